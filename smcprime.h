@@ -20,6 +20,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  #include <intrin.h>
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +39,105 @@ extern "C" {
   #endif
 #endif
 
+/* Larger helpers (sieves, indexes, engines): inlinable but not forced */
+#ifndef SMC_API
+  #define SMC_API static inline
+#endif
+
+/*
+ * Host-tuned thresholds: tools/smc_tune.c benchmarks the candidates and
+ * writes a header of #defines, used when built with
+ * -DSMC_CONFIG_HEADER='"smcprime_tuned.h"'. Explicit -D values still win.
+ */
+#ifdef SMC_CONFIG_HEADER
+  #include SMC_CONFIG_HEADER
+#endif
+
+/* ===========================================================================
+ * BIT UTILITIES
+ * =========================================================================== */
+
+SMC_INLINE int smc_popcount64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/* Count trailing zeros; x must be non-zero */
+SMC_INLINE int smc_ctz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#else
+    int r = 0;
+    while ((x & 1) == 0) { x >>= 1; r++; }
+    return r;
+#endif
+}
+
+/* Count leading zeros; x must be non-zero */
+SMC_INLINE int smc_clz64(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#else
+    int r = 0;
+    while ((x & 0x8000000000000000ULL) == 0) { x <<= 1; r++; }
+    return r;
+#endif
+}
+
+/*
+ * Full 64x64 -> 128-bit product; returns the low word. Without __int128
+ * it uses the MSVC intrinsics, else four 32x32 -> 64-bit products, each
+ * a single multiply instruction on 32-bit targets.
+ */
+SMC_INLINE uint64_t smc_mul64_wide(uint64_t a, uint64_t b, uint64_t *hi) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t p = (__uint128_t)a * b;
+    *hi = (uint64_t)(p >> 64);
+    return (uint64_t)p;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, hi);
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+    *hi = __umulh(a, b);
+    return a * b;
+#else
+    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    *hi = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)p0;
+#endif
+}
+
+/* High word of a * b */
+SMC_INLINE uint64_t smc_mulhi64(uint64_t a, uint64_t b) {
+#if defined(_MSC_VER) && !defined(__SIZEOF_INT128__) && (defined(_M_X64) || defined(_M_ARM64))
+    return __umulh(a, b);
+#else
+    uint64_t hi;
+    smc_mul64_wide(a, b, &hi);
+    return hi;
+#endif
+}
+
+/* floor(sqrt(n)) via Newton iteration from above */
+SMC_INLINE uint32_t smc_isqrt64(uint64_t n) {
+    if (n < 2) return (uint32_t)n;
+    uint64_t r = 1ULL << ((64 - smc_clz64(n) + 1) / 2);
+    for (;;) {
+        uint64_t y = (r + n / r) >> 1;
+        if (y >= r) break;
+        r = y;
+    }
+    return (uint32_t)r;
+}
+
 /* ===========================================================================
  * 32-BIT PRIMALITY TESTING
  * 
@@ -72,6 +175,78 @@ SMC_INLINE bool smc_sprp32(uint32_t n, uint32_t a) {
     return false;
 }
 
+/*
+ * 32-bit Montgomery arithmetic (R = 2^32, n odd). Every product is one
+ * 32x32 -> 64-bit multiply, which 32-bit targets have natively, and no
+ * 64-bit division is needed (a libgcc call there).
+ */
+SMC_INLINE uint32_t smc_mont_inv32(uint32_t n) {
+    uint32_t est = (3 * n) ^ 2;
+    est = (2 - est * n) * est;
+    est = (2 - est * n) * est;
+    est = (2 - est * n) * est;
+    return est;
+}
+
+SMC_INLINE uint32_t smc_mont_mul32(uint32_t a, uint32_t b, uint32_t n, uint32_t n_inv) {
+    uint64_t x = (uint64_t)a * b;
+    uint32_t t = (uint32_t)(((uint64_t)((uint32_t)x * n_inv) * n) >> 32);
+    uint32_t hi = (uint32_t)(x >> 32);
+    return hi < t ? hi - t + n : hi - t;
+}
+
+/* a * R mod n for a < n, by binary doubling on one = R mod n */
+SMC_INLINE uint32_t smc_mont_small32(uint32_t a, uint32_t n, uint32_t one) {
+    uint32_t r = 0;
+    for (int i = 63 - smc_clz64(a); i >= 0; i--) {
+        r = r >= n - r ? r - (n - r) : r + r;
+        if ((a >> i) & 1) r = r >= n - one ? r - (n - one) : r + one;
+    }
+    return r;
+}
+
+/* b^e for b and the result in Montgomery form */
+SMC_INLINE uint32_t smc_mont_pow32(uint32_t b, uint32_t e, uint32_t n, uint32_t n_inv, uint32_t one) {
+    uint32_t x = one;
+    while (e) {
+        if (e & 1) x = smc_mont_mul32(x, b, n, n_inv);
+        e >>= 1;
+        if (e) b = smc_mont_mul32(b, b, n, n_inv);
+    }
+    return x;
+}
+
+SMC_INLINE bool smc_mont_sprp32(uint32_t n, uint32_t a, uint32_t n_inv, uint32_t one) {
+    a %= n;
+    if (a == 0) return true;
+    uint32_t d = n - 1;
+    uint32_t s = 0;
+    while ((d & 1) == 0) { d >>= 1; s++; }
+    uint32_t b = smc_mont_small32(a, n, one), x = one, neg_one = n - one;
+    while (d) {
+        if (d & 1) x = smc_mont_mul32(x, b, n, n_inv);
+        d >>= 1;
+        if (d) b = smc_mont_mul32(b, b, n, n_inv);
+    }
+    if (x == one || x == neg_one) return true;
+    for (uint32_t r = 1; r < s; r++) {
+        x = smc_mont_mul32(x, x, n, n_inv);
+        if (x == neg_one) return true;
+        if (x == one) return false;
+    }
+    return false;
+}
+
+/* Witnesses {2, 7, 61} in Montgomery form; any odd n > 8 */
+SMC_INLINE bool smc_mont_is_prime32(uint32_t n) {
+    if (n == 3215031751U) return false;  /* Special pseudoprime */
+    uint32_t n_inv = smc_mont_inv32(n);
+    uint32_t one = (UINT32_MAX % n) + 1;
+    if (!smc_mont_sprp32(n, 2, n_inv, one)) return false;
+    if (n < 2047) return true;
+    return smc_mont_sprp32(n, 7, n_inv, one) && smc_mont_sprp32(n, 61, n_inv, one);
+}
+
 /*
  * Deterministic primality test for 32-bit integers
  * 
@@ -87,9 +262,7 @@ SMC_INLINE bool smc_is_prime32(uint32_t n) {
     if (n % 5 == 0) return false;
     if (n % 7 == 0) return false;
     
-    if (n == 3215031751U) return false;  /* Special pseudoprime */
-    
-    return smc_sprp32(n, 2) && smc_sprp32(n, 7) && smc_sprp32(n, 61);
+    return smc_mont_is_prime32(n);
 }
 
 SMC_INLINE uint32_t smc_next_prime32(uint32_t n) {
@@ -141,6 +314,42 @@ static const uint64_t SMC_PRIME_INV64[] = {
 };
 #define SMC_NUM_PRIME_INV64 66
 
+/* The primes matching SMC_PRIME_INV64, in the same order */
+static const uint16_t SMC_SMALL_PRIMES[] = {
+    3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59,
+    61, 67, 71, 73, 79, 83, 89, 97, 101, 103, 107, 109, 113, 127, 131, 137,
+    139, 149, 151, 157, 163, 167, 173, 179, 181, 191, 193, 197, 199, 211, 223, 227,
+    229, 233, 239, 241, 251, 257, 263, 269, 271, 277, 281, 283, 293, 307, 311, 313,
+    317, 331,
+};
+
+/*
+ * Trial division in smc_is_prime64. Below SMC_TRIAL_LIMIT64 the first
+ * SMC_TRIAL_PRIMES64 table primes are tried with the one-comparison test
+ * n * inv < n, which is exact while n <= 2^64 / p for the largest prime
+ * tried (the default limit is that bound for 331, so it holds for any
+ * depth). Larger n try the first SMC_TRIAL_LARGE64 primes with the exact
+ * test n * inv <= (2^64 - 1) / p.
+ */
+#ifndef SMC_TRIAL_PRIMES64
+  #define SMC_TRIAL_PRIMES64 SMC_NUM_PRIME_INV64
+#endif
+#ifndef SMC_TRIAL_LIMIT64
+  #define SMC_TRIAL_LIMIT64 55730344633563600ULL
+#endif
+#ifndef SMC_TRIAL_LARGE64
+  #define SMC_TRIAL_LARGE64 5
+#endif
+#if SMC_TRIAL_PRIMES64 < 1 || SMC_TRIAL_PRIMES64 > SMC_NUM_PRIME_INV64 || SMC_TRIAL_LARGE64 > SMC_NUM_PRIME_INV64
+  #error "smcPrime: trial-division depths must be within the 66-prime table"
+#endif
+
+/* Below this, smc_is_prime64_wc defers to smc_is_prime64, whose witness
+   sets shrink with n; 0 always runs the full witness set */
+#ifndef SMC_WC_CROSSOVER
+  #define SMC_WC_CROSSOVER 0
+#endif
+
 /* Montgomery inverse via Hensel lifting (Newton-Raphson iteration) */
 SMC_INLINE uint64_t smc_mont_inv64(uint64_t n) {
     uint64_t est = (3 * n) ^ 2;
@@ -151,51 +360,63 @@ SMC_INLINE uint64_t smc_mont_inv64(uint64_t n) {
     return est;
 }
 
+/* High word of m * n for m = x_lo * n_inv; x - m * n is then (x_hi - t) * 2^64 */
+SMC_INLINE uint64_t smc_mont_redc_hi64(uint64_t x_lo, uint64_t n, uint64_t n_inv) {
+    return smc_mulhi64(x_lo * n_inv, n);
+}
+
 /* Montgomery reduction */
 SMC_INLINE uint64_t smc_mont_reduce64(uint64_t x_lo, uint64_t x_hi, uint64_t n, uint64_t n_inv) {
-    uint64_t m = x_lo * n_inv;
-#if defined(__SIZEOF_INT128__)
-    uint64_t t = (uint64_t)(((__uint128_t)m * n) >> 64);
-#else
-    uint64_t a_lo = (uint32_t)m, a_hi = m >> 32;
-    uint64_t b_lo = (uint32_t)n, b_hi = n >> 32;
-    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
-    uint64_t cy = ((p0 >> 32) + (uint32_t)p1 + (uint32_t)p2) >> 32;
-    uint64_t t = p3 + (p1 >> 32) + (p2 >> 32) + cy;
-#endif
+    uint64_t t = smc_mont_redc_hi64(x_lo, n, n_inv);
     return (x_hi < t) ? x_hi - t + n : x_hi - t;
 }
 
 /* Montgomery multiplication */
 SMC_INLINE uint64_t smc_mont_mul64(uint64_t a, uint64_t b, uint64_t n, uint64_t n_inv) {
-#if defined(__SIZEOF_INT128__)
-    __uint128_t prod = (__uint128_t)a * b;
-    return smc_mont_reduce64((uint64_t)prod, (uint64_t)(prod >> 64), n, n_inv);
-#else
-    uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
-    uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
-    uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
-    uint64_t lo = p0 + (p1 << 32) + (p2 << 32);
-    uint64_t cy = (lo < p0) + ((p0 >> 32) + (uint32_t)p1 + (uint32_t)p2 >= 0x100000000ULL);
-    uint64_t hi = p3 + (p1 >> 32) + (p2 >> 32) + cy;
+    uint64_t hi, lo = smc_mul64_wide(a, b, &hi);
     return smc_mont_reduce64(lo, hi, n, n_inv);
-#endif
 }
 
-/* Convert to Montgomery form */
+/* One in Montgomery form */
+SMC_INLINE uint64_t smc_mont_one64(uint64_t n) {
+    return (UINT64_MAX % n) + 1;
+}
+
+/* R^2 mod n: 2 in Montgomery form, squared six times (2^64 in Montgomery form) */
+SMC_INLINE uint64_t smc_mont_r2_64(uint64_t n, uint64_t n_inv, uint64_t one) {
+    uint64_t x = one << 1;
+    if (x < one || x >= n) x -= n;
+    for (int i = 0; i < 6; i++) x = smc_mont_mul64(x, x, n, n_inv);
+    return x;
+}
+
+/*
+ * Convert to Montgomery form. Without __int128 a 128-bit remainder is not
+ * available (except MSVC's _udiv128), so x * R^2 is reduced instead.
+ */
 SMC_INLINE uint64_t smc_to_mont64(uint64_t x, uint64_t n) {
 #if defined(__SIZEOF_INT128__)
     return (uint64_t)(((__uint128_t)x << 64) % n);
-#else
-    uint64_t r = x % n;
-    for (int i = 0; i < 64; i++) { r <<= 1; if (r >= n) r -= n; }
+#elif defined(_MSC_VER) && defined(_M_X64) && _MSC_VER >= 1920
+    uint64_t r;
+    _udiv128(x % n, 0, n, &r);
     return r;
+#else
+    uint64_t n_inv = smc_mont_inv64(n);
+    return smc_mont_mul64(x % n, smc_mont_r2_64(n, n_inv, smc_mont_one64(n)), n, n_inv);
 #endif
 }
 
-/* One in Montgomery form */
-SMC_INLINE uint64_t smc_mont_one64(uint64_t n) {
-    return (UINT64_MAX % n) + 1;
+/* a * R mod n for a < n, by binary doubling on one = R mod n; cheaper
+   than smc_to_mont64 for the small Miller-Rabin witnesses (0 for a = 0) */
+SMC_INLINE uint64_t smc_mont_small64(uint64_t a, uint64_t n, uint64_t one) {
+    uint64_t r = 0;
+    if (a == 0) return 0;   /* smc_clz64(0) is undefined */
+    for (int i = 63 - smc_clz64(a); i >= 0; i--) {
+        r = r >= n - r ? r - (n - r) : r + r;
+        if ((a >> i) & 1) r = r >= n - one ? r - (n - one) : r + one;
+    }
+    return r;
 }
 
 /* Montgomery exponentiation */
@@ -209,6 +430,52 @@ SMC_INLINE uint64_t smc_mont_pow64(uint64_t base, uint64_t exp, uint64_t n, uint
     return result;
 }
 
+/*
+ * Lazy Montgomery arithmetic for n < 2^62: values are kept in [0, 2n)
+ * rather than [0, n). A product of two such values is below 4n^2, so its
+ * high word is below n and x_hi - t + n lands in (0, 2n) with no
+ * compare-and-correct; the + n is off the multiply's dependency chain.
+ * smc_mont_norm64 brings a value back to [0, n) for comparisons.
+ */
+SMC_INLINE uint64_t smc_mont_norm64(uint64_t x, uint64_t n) {
+    return x >= n ? x - n : x;
+}
+
+SMC_INLINE uint64_t smc_mont_mul64_lazy(uint64_t a, uint64_t b, uint64_t n, uint64_t n_inv) {
+    uint64_t hi, lo = smc_mul64_wide(a, b, &hi);
+    return (hi + n) - smc_mont_redc_hi64(lo, n, n_inv);
+}
+
+SMC_INLINE uint64_t smc_mont_pow64_lazy(uint64_t base, uint64_t exp, uint64_t n, uint64_t n_inv, uint64_t one) {
+    uint64_t result = one;
+    while (exp > 0) {
+        if (exp & 1) result = smc_mont_mul64_lazy(result, base, n, n_inv);
+        base = smc_mont_mul64_lazy(base, base, n, n_inv);
+        exp >>= 1;
+    }
+    return result;
+}
+
+/*
+ * Inverse of a modulo m (gcd(a, m) = 1, m > 1) by extended Euclid.
+ * Tracks coefficient magnitudes only: their signs alternate, so the
+ * recurrence never overflows.
+ */
+SMC_INLINE uint64_t smc_modinv64(uint64_t a, uint64_t m) {
+    uint64_t r0 = m, r1 = a % m, u0 = 0, u1 = 1;
+    bool odd = false;
+    while (r1 != 0) {
+        uint64_t q = r0 / r1, t = r0 - q * r1;
+        r0 = r1;
+        r1 = t;
+        t = u0 + q * u1;
+        u0 = u1;
+        u1 = t;
+        odd = !odd;
+    }
+    return odd ? u0 : m - u0;
+}
+
 /*
  * Strong Fermat test in Montgomery form
  * 
@@ -222,13 +489,27 @@ SMC_INLINE bool smc_mont_sprp64(uint64_t n, uint64_t a, uint64_t n_inv, uint64_t
     while ((d & 1) == 0) { d >>= 1; s++; }
     
     /* Convert witness to Montgomery form (handles a % n automatically) */
-    uint64_t a_mont = smc_to_mont64(a % n, n);
+    uint64_t a_mont = a < n ? smc_mont_small64(a, n, one) : smc_to_mont64(a % n, n);
     if (a_mont == 0) return true;  /* a is multiple of n, trivially passes */
     
-    uint64_t x = smc_mont_pow64(a_mont, d, n, n_inv, one);
     uint64_t neg_one = n - one;
     if (neg_one >= n) neg_one -= n;
     
+    if (n < (1ULL << 62)) {
+        /* Lazy chain; normalized only where compared */
+        uint64_t y = smc_mont_pow64_lazy(a_mont, d, n, n_inv, one);
+        uint64_t x = smc_mont_norm64(y, n);
+        if (x == one || x == neg_one) return true;
+        for (uint32_t r = 1; r < s; r++) {
+            y = smc_mont_mul64_lazy(y, y, n, n_inv);
+            x = smc_mont_norm64(y, n);
+            if (x == neg_one) return true;
+            if (x == one) return false;
+        }
+        return false;
+    }
+    
+    uint64_t x = smc_mont_pow64(a_mont, d, n, n_inv, one);
     if (x == one || x == neg_one) return true;
     
     for (uint32_t r = 1; r < s; r++) {
@@ -251,26 +532,30 @@ SMC_INLINE bool smc_is_prime64(uint64_t n) {
     if ((n & 1) == 0) return false;
     if (n < 9) return true;
     
-    /* 
-     * Fast trial division using prime inverses (from machine-prime)
-     * Only valid for n < 55730344633563600 to avoid overflow issues
+    /*
+     * Fast trial division using prime inverses (from machine-prime); the
+     * one-comparison form is only valid below SMC_TRIAL_LIMIT64
      */
-    if (n < 55730344633563600ULL) {
-        for (size_t i = 0; i < SMC_NUM_PRIME_INV64; i++) {
+    if (n < SMC_TRIAL_LIMIT64) {
+        for (size_t i = 0; i < SMC_TRIAL_PRIMES64; i++) {
             uint64_t prod = n * SMC_PRIME_INV64[i];
             if (prod == 1) return true;   /* n IS this prime */
             if (prod < n) return false;   /* n is divisible by this prime */
         }
-        if (n < 109561) return true;  /* 331^2, passed all trial divisions */
+        /* Passed all trial divisions: prime below the square of the last one */
+        if (n < (uint64_t)SMC_SMALL_PRIMES[SMC_TRIAL_PRIMES64 - 1] * SMC_SMALL_PRIMES[SMC_TRIAL_PRIMES64 - 1])
+            return true;
     } else {
-        /* For large n, use traditional trial division */
-        if (n % 3 == 0) return false;
-        if (n % 5 == 0) return false;
-        if (n % 7 == 0) return false;
-        if (n % 11 == 0) return false;
-        if (n % 13 == 0) return false;
+#if SMC_TRIAL_LARGE64 > 0
+        /* For large n, the exact divisibility test */
+        for (size_t i = 0; i < SMC_TRIAL_LARGE64; i++) {
+            if (n * SMC_PRIME_INV64[i] <= UINT64_MAX / SMC_SMALL_PRIMES[i]) return false;
+        }
+#endif
     }
     
+    if (n <= UINT32_MAX) return smc_mont_is_prime32((uint32_t)n);
+    
     /* Montgomery setup */
     uint64_t n_inv = smc_mont_inv64(n);
     uint64_t one = smc_mont_one64(n);
@@ -311,7 +596,8 @@ SMC_INLINE bool smc_is_prime64(uint64_t n) {
 
 /*
  * Worst-case optimized version (for numbers likely to be prime)
- * Skips trial division, goes straight to Miller-Rabin
+ * Skips trial division, goes straight to Miller-Rabin; below
+ * SMC_WC_CROSSOVER the smaller witness sets of smc_is_prime64 win
  */
 SMC_INLINE bool smc_is_prime64_wc(uint64_t n) {
     if (n < 2) return false;
@@ -319,6 +605,9 @@ SMC_INLINE bool smc_is_prime64_wc(uint64_t n) {
     if ((n & 1) == 0) return false;
     if (n < 9) return true;
     if (n == 3215031751ULL) return false;
+#if SMC_WC_CROSSOVER
+    if (n < SMC_WC_CROSSOVER) return smc_is_prime64(n);
+#endif
     
     uint64_t n_inv = smc_mont_inv64(n);
     uint64_t one = smc_mont_one64(n);
@@ -346,6 +635,94 @@ SMC_INLINE uint64_t smc_prev_prime64(uint64_t n) {
     return n;
 }
 
+/* ===========================================================================
+ * SPECIAL-FORM MODULI AND GENERIC MODPOW
+ *
+ * For Mersenne (2^k - 1) and pseudo-Mersenne (2^k - c, small c) moduli,
+ * the high part of a product folds back as hi * c + lo, so reduction costs
+ * one small multiply and needs no Montgomery domain conversion. The payoff
+ * is largest for multi-limb moduli (smcprime_mp.h), where Montgomery
+ * reduction is quadratic and folding is linear.
+ * =========================================================================== */
+
+/* One fold: hi * 2^64 + lo = H * 2^k + L  ->  H * c + L (1 <= k <= 64) */
+SMC_INLINE void smc_pmod_fold64(uint64_t *lo, uint64_t *hi, unsigned k, uint64_t c) {
+    uint64_t h = (*hi << (64 - k)) | ((*lo >> (k - 1)) >> 1);
+    uint64_t l = *lo & (~0ULL >> (64 - k));
+    uint64_t h_hi, t = smc_mul64_wide(h, c, &h_hi);
+    *lo = t + l;
+    *hi = h_hi + (*lo < t);
+}
+
+/* Reduce hi * 2^64 + lo (< m^2) modulo m = 2^k - c */
+SMC_INLINE uint64_t smc_pmod_reduce64(uint64_t lo, uint64_t hi, unsigned k, uint64_t c) {
+    uint64_t mask = ~0ULL >> (64 - k), m = mask - (c - 1);
+    if (c == 1 && k < 64) {
+        /* Mersenne: H + L < 2m, no multiply */
+        uint64_t r = ((hi << (64 - k)) | (lo >> k)) + (lo & mask);
+        return r >= m ? r - m : r;
+    }
+    /* Two folds bring c < 2^(k/2) products below 2^(k+1); the loop is
+       for the rare leftover bit */
+    smc_pmod_fold64(&lo, &hi, k, c);
+    smc_pmod_fold64(&lo, &hi, k, c);
+    while (hi != 0 || (lo & ~mask) != 0) smc_pmod_fold64(&lo, &hi, k, c);
+    return lo >= m ? lo - m : lo;
+}
+
+SMC_INLINE uint64_t smc_pmod_mul64(uint64_t a, uint64_t b, unsigned k, uint64_t c) {
+    uint64_t hi, lo = smc_mul64_wide(a, b, &hi);
+    return smc_pmod_reduce64(lo, hi, k, c);
+}
+
+/* a * b mod m for any m > 0 */
+SMC_INLINE uint64_t smc_mulmod64(uint64_t a, uint64_t b, uint64_t m) {
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((__uint128_t)a * b) % m);
+#else
+    uint64_t r = 0;
+    a %= m;
+    while (b) {
+        if (b & 1) r = r >= m - a ? r - (m - a) : r + a;
+        a = a >= m - a ? a - (m - a) : a + a;
+        b >>= 1;
+    }
+    return r;
+#endif
+}
+
+/*
+ * base^exp mod m for any m > 0.
+ *
+ * Dispatches on the modulus: native arithmetic below 2^32, Montgomery for
+ * odd m, and plain 128-bit remainders for even m. (Single-limb special-form
+ * folding measured slower than Montgomery here, so it is not used.)
+ */
+SMC_INLINE uint64_t smc_powmod64(uint64_t base, uint64_t exp, uint64_t m) {
+    if (m == 1) return 0;
+    uint64_t r = 1;
+    base %= m;
+    if (m >> 32 == 0) {
+        while (exp) {
+            if (exp & 1) r = r * base % m;
+            base = base * base % m;
+            exp >>= 1;
+        }
+        return r;
+    }
+    if (m & 1) {
+        uint64_t n_inv = smc_mont_inv64(m);
+        uint64_t x = smc_mont_pow64(smc_to_mont64(base, m), exp, m, n_inv, smc_mont_one64(m));
+        return smc_mont_reduce64(x, 0, m, n_inv);
+    }
+    while (exp) {
+        if (exp & 1) r = smc_mulmod64(r, base, m);
+        base = smc_mulmod64(base, base, m);
+        exp >>= 1;
+    }
+    return r;
+}
+
 /* ===========================================================================
  * CONVENIENCE ALIASES
  * =========================================================================== */
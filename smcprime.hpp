@@ -0,0 +1,191 @@
+/*
+ * smcPrime - C++20 Interface
+ *
+ * Ranges over primes backed by the segmented sieve:
+ * - smc::primes(lo, hi): a bidirectional std::ranges view of the primes
+ *   in [lo, hi), with one cached segment and no per-element allocation
+ * - smc::prime_generator(lo, hi): the same sequence as a std::generator
+ *   (when the standard library provides <generator>)
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_HPP
+#define SMCPRIME_HPP
+
+#include "smcprime.h"
+#include "smcprime_sieve.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#if __has_include(<generator>)
+  #include <generator>
+#endif
+
+namespace smc {
+
+/* ===========================================================================
+ * PRIME VIEW
+ *
+ * Iterators share the view's sieve state: the segment holding the current
+ * prime is sieved once and scanned bit by bit. Moving forward into the
+ * next segment continues the sieve; moving backward (or jumping) re-seeks
+ * it. Copies of a view share that state; iterators stay valid while any
+ * copy lives, but one view must not be iterated from several threads at
+ * once.
+ * =========================================================================== */
+
+class prime_view : public std::ranges::view_interface<prime_view> {
+    struct state {
+        smc_sieve s;
+        uint64_t lo, hi;
+        uint64_t seg_b0 = 0;        /* bit index of the cached segment's bit 0 */
+        bool loaded = false;
+
+        state(uint64_t lo_, uint64_t hi_) : lo(lo_), hi(hi_) {
+            if (!smc_sieve_init(&s, lo, hi)) throw std::bad_alloc();
+        }
+        ~state() { smc_sieve_free(&s); }
+        state(const state &) = delete;
+        state &operator=(const state &) = delete;
+
+        bool has_two() const { return lo <= 2 && hi > 2; }
+
+        /* Make the segment containing odd-bit index 'bit' current */
+        void load(uint64_t bit) {
+            if (loaded && bit - seg_b0 < s.seg_bits) return;
+            uint64_t b0 = bit - bit % s.seg_cap;
+            if (s.done_bits != b0) smc_sieve_seek(&s, b0);
+            smc_sieve_next(&s);
+            seg_b0 = b0;
+            loaded = true;
+        }
+
+        /* Smallest prime whose odd-bit index is >= bit, or hi */
+        uint64_t next_from(uint64_t bit) {
+            while (bit < s.total_bits) {
+                load(bit);
+                size_t i = (size_t)(bit - seg_b0);
+                size_t words = (s.seg_bits + 63) / 64;
+                uint64_t m = s.bits[i / 64] & (~0ULL << (i % 64));
+                for (size_t w = i / 64;;) {
+                    if (m) return s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m));
+                    if (++w == words) break;
+                    m = s.bits[w];
+                }
+                bit = seg_b0 + s.seg_bits;
+            }
+            return hi;
+        }
+
+        /* Largest prime whose odd-bit index is <= bit, or 2 / hi if none */
+        uint64_t prev_from(uint64_t bit) {
+            for (;;) {
+                load(bit);
+                size_t i = (size_t)(bit - seg_b0);
+                uint64_t m = s.bits[i / 64] & (~0ULL >> (63 - i % 64));
+                for (size_t w = i / 64;;) {
+                    if (m) return s.seg_lo + 2 * (64 * (uint64_t)w + 63 - (uint64_t)smc_clz64(m));
+                    if (w-- == 0) break;
+                    m = s.bits[w];
+                }
+                if (seg_b0 == 0) return has_two() ? 2 : hi;
+                bit = seg_b0 - 1;
+            }
+        }
+    };
+
+    std::shared_ptr<state> st_;
+    uint64_t first_ = 0;
+
+public:
+    class iterator {
+        state *st_ = nullptr;
+        uint64_t p_ = 0;            /* current prime, or hi for end() */
+
+        friend class prime_view;
+        iterator(state *st, uint64_t p) : st_(st), p_(p) {}
+
+    public:
+        using iterator_concept = std::bidirectional_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = uint64_t;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+
+        uint64_t operator*() const { return p_; }
+
+        iterator &operator++() {
+            if (p_ < 3) {
+                p_ = st_->next_from(0);
+            } else {
+                p_ = st_->next_from((p_ - st_->s.base) / 2 + 1);
+            }
+            return *this;
+        }
+        iterator operator++(int) { iterator t = *this; ++*this; return t; }
+
+        iterator &operator--() {
+            uint64_t top = p_ == st_->hi ? st_->s.total_bits : (p_ - st_->s.base) / 2;
+            if (p_ == 2 || top == 0) {
+                p_ = 2;
+            } else {
+                p_ = st_->prev_from(top - 1);
+            }
+            return *this;
+        }
+        iterator operator--(int) { iterator t = *this; --*this; return t; }
+
+        friend bool operator==(const iterator &a, const iterator &b) { return a.p_ == b.p_; }
+    };
+
+    prime_view() = default;
+
+    /* Primes in [lo, hi). Throws std::bad_alloc if the sieve cannot be set up. */
+    prime_view(uint64_t lo, uint64_t hi) : st_(std::make_shared<state>(lo, hi < lo ? lo : hi)) {
+        first_ = st_->has_two() ? 2 : st_->next_from(0);
+    }
+
+    /* A default-constructed view is empty: begin() == end() */
+    iterator begin() const { return st_ ? iterator(st_.get(), first_) : iterator(nullptr, 0); }
+    iterator end() const { return st_ ? iterator(st_.get(), st_->hi) : iterator(nullptr, 0); }
+};
+
+/* All primes in [lo, hi) as a bidirectional range */
+inline prime_view primes(uint64_t lo, uint64_t hi) {
+    return prime_view(lo, hi);
+}
+
+/* ===========================================================================
+ * GENERATOR
+ * =========================================================================== */
+
+#if defined(__cpp_lib_generator)
+
+/* All primes in [lo, hi), yielded straight from the sieve segments */
+inline std::generator<uint64_t> prime_generator(uint64_t lo, uint64_t hi) {
+    struct guard {
+        smc_sieve s;
+        ~guard() { smc_sieve_free(&s); }
+    } g;
+    if (!smc_sieve_init(&g.s, lo, hi)) throw std::bad_alloc();
+    if (lo <= 2 && hi > 2) co_yield 2;
+    while (smc_sieve_next(&g.s)) {
+        size_t words = (g.s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++)
+            for (uint64_t m = g.s.bits[w]; m; m &= m - 1)
+                co_yield g.s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m));
+    }
+}
+
+#endif /* __cpp_lib_generator */
+
+} /* namespace smc */
+
+#endif /* SMCPRIME_HPP */
@@ -0,0 +1,451 @@
+/*
+ * smcPrime - 128-bit Primes
+ *
+ * Primality and range enumeration beyond 2^64 (needs unsigned __int128):
+ * - 128-bit Montgomery arithmetic (R = 2^128) for odd moduli
+ * - smc_is_prime128(n): Baillie-PSW (strong base-2 test plus strong
+ *   Lucas-Selfridge test); no counterexample is known, none exists
+ *   below 2^64
+ * - smc_sieve128_*: windowed sieve of [lo, hi) with the primes up to a
+ *   chosen bound; one 128-by-64-bit remainder per sieving prime, then
+ *   additions only
+ * - smc_count_primes128 / smc_primes128_range: sieve, then confirm the
+ *   survivors with Baillie-PSW (skipped when bound^2 covers the window)
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME128_H
+#define SMCPRIME128_H
+
+#include "smcprime.h"
+#include "smcprime_mp.h"
+#include "smcprime_pi.h"
+#include "smcprime_sieve.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SIZEOF_INT128__)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default sieving bound: survivors below it cost a bit clear, above it a BPSW test */
+#ifndef SMC_SIEVE128_BOUND
+  #define SMC_SIEVE128_BOUND (1u << 22)
+#endif
+
+/* ===========================================================================
+ * 128-BIT MONTGOMERY ARITHMETIC
+ * =========================================================================== */
+
+typedef struct smc_mont128 {
+    smc_u128 n;                 /* odd modulus */
+    smc_u128 n_inv;             /* n^-1 mod 2^128 */
+    smc_u128 one;               /* R mod n */
+} smc_mont128;
+
+/* x mod p for 64-bit p: one hardware 128/64 division where available */
+SMC_INLINE uint64_t smc_mod128_64(smc_u128 x, uint64_t p) {
+    uint64_t hi = (uint64_t)(x >> 64) % p, lo = (uint64_t)x;
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t q, r;
+    __asm__("divq %4" : "=a"(q), "=d"(r) : "a"(lo), "d"(hi), "rm"(p));
+    (void)q;
+    return r;
+#else
+    return (uint64_t)((((smc_u128)hi << 64) | lo) % p);
+#endif
+}
+
+/* High half of a 128x128-bit product */
+SMC_INLINE smc_u128 smc_mulhi128(smc_u128 a, smc_u128 b) {
+    uint64_t r[4];
+    smc_mul128_wide(a, b, r);
+    return ((smc_u128)r[3] << 64) | r[2];
+}
+
+SMC_INLINE void smc_mont128_init(smc_mont128 *m, smc_u128 n) {
+    smc_u128 est = (3 * n) ^ 2;                 /* 5 bits */
+    for (int i = 0; i < 5; i++) est *= 2 - n * est;
+    m->n = n;
+    m->n_inv = est;
+    m->one = (0 - n) % n;
+}
+
+/* (hi:lo) / R mod n, for hi < n */
+SMC_INLINE smc_u128 smc_mont128_reduce(const smc_mont128 *m, smc_u128 lo, smc_u128 hi) {
+    smc_u128 t = smc_mulhi128(lo * m->n_inv, m->n);
+    return hi < t ? hi - t + m->n : hi - t;
+}
+
+SMC_INLINE smc_u128 smc_mont128_mul(const smc_mont128 *m, smc_u128 a, smc_u128 b) {
+    uint64_t r[4];
+    smc_mul128_wide(a, b, r);
+    return smc_mont128_reduce(m, ((smc_u128)r[1] << 64) | r[0], ((smc_u128)r[3] << 64) | r[2]);
+}
+
+SMC_INLINE smc_u128 smc_mont128_add(const smc_mont128 *m, smc_u128 a, smc_u128 b) {
+    smc_u128 s = a + b;
+    return (s < a || s >= m->n) ? s - m->n : s;
+}
+
+SMC_INLINE smc_u128 smc_mont128_sub(const smc_mont128 *m, smc_u128 a, smc_u128 b) {
+    return a >= b ? a - b : a - b + m->n;
+}
+
+/* a / 2 mod n, without leaving 128 bits */
+SMC_INLINE smc_u128 smc_mont128_half(const smc_mont128 *m, smc_u128 a) {
+    return (a & 1) ? (a >> 1) + (m->n >> 1) + 1 : a >> 1;
+}
+
+/* x * v mod n for small v, by doubling and adding */
+SMC_INLINE smc_u128 smc_mont128_mul_small(const smc_mont128 *m, smc_u128 x, uint64_t v) {
+    smc_u128 r = 0;
+    for (; v; v >>= 1) {
+        if (v & 1) r = smc_mont128_add(m, r, x);
+        x = smc_mont128_add(m, x, x);
+    }
+    return r;
+}
+
+/* x * v mod n for small signed v */
+SMC_INLINE smc_u128 smc_mont128_mul_signed(const smc_mont128 *m, smc_u128 x, int64_t v) {
+    smc_u128 r = smc_mont128_mul_small(m, x, (uint64_t)(v < 0 ? -v : v));
+    return v < 0 && r ? m->n - r : r;
+}
+
+/* R^2 mod n: 2 in Montgomery form, squared seven times (2^128 in Montgomery form) */
+SMC_INLINE smc_u128 smc_mont128_r2(const smc_mont128 *m) {
+    smc_u128 x = smc_mont128_add(m, m->one, m->one);
+    for (int i = 0; i < 7; i++) x = smc_mont128_mul(m, x, x);
+    return x;
+}
+
+/* Into and out of Montgomery form */
+SMC_INLINE smc_u128 smc_mont128_to(const smc_mont128 *m, smc_u128 x) {
+    return smc_mont128_mul(m, x % m->n, smc_mont128_r2(m));
+}
+
+SMC_INLINE smc_u128 smc_mont128_from(const smc_mont128 *m, smc_u128 x) {
+    return smc_mont128_reduce(m, x, 0);
+}
+
+/* x^e in Montgomery form, right-to-left square-and-multiply */
+SMC_INLINE smc_u128 smc_mont128_pow(const smc_mont128 *m, smc_u128 x, smc_u128 e) {
+    smc_u128 r = m->one;
+    while (e) {
+        if (e & 1) r = smc_mont128_mul(m, r, x);
+        e >>= 1;
+        if (e) x = smc_mont128_mul(m, x, x);
+    }
+    return r;
+}
+
+/* ===========================================================================
+ * BAILLIE-PSW
+ * =========================================================================== */
+
+/* Strong probable prime to base 2; left-to-right, so multiplying by 2 is an add */
+SMC_API bool smc_sprp2_128(const smc_mont128 *m) {
+    smc_u128 nm1 = m->n - 1;
+    int s = 0;
+    smc_u128 d = nm1;
+    while ((d & 1) == 0) { d >>= 1; s++; }
+    uint64_t dh = (uint64_t)(d >> 64);
+    int top = dh ? 127 - smc_clz64(dh) : 63 - smc_clz64((uint64_t)d);
+    smc_u128 x = smc_mont128_add(m, m->one, m->one);
+    for (int i = top - 1; i >= 0; i--) {
+        x = smc_mont128_mul(m, x, x);
+        if ((d >> i) & 1) x = smc_mont128_add(m, x, x);
+    }
+    smc_u128 mone = m->n - m->one;              /* -1 in Montgomery form */
+    if (x == m->one || x == mone) return true;
+    for (int r = 1; r < s; r++) {
+        x = smc_mont128_mul(m, x, x);
+        if (x == mone) return true;
+        if (x == m->one) return false;
+    }
+    return false;
+}
+
+/* Jacobi symbol (a / n) for odd n */
+SMC_INLINE int smc_jacobi64(uint64_t a, uint64_t n) {
+    int t = 1;
+    a %= n;
+    while (a != 0) {
+        int z = smc_ctz64(a);
+        a >>= z;
+        if ((z & 1) && ((n & 7) == 3 || (n & 7) == 5)) t = -t;
+        uint64_t x = a;
+        a = n;
+        n = x;
+        if ((a & 3) == 3 && (n & 3) == 3) t = -t;
+        a %= n;
+    }
+    return n == 1 ? t : 0;
+}
+
+/* (D / n) for small odd D and odd n, by reciprocity: one 128/64 remainder */
+SMC_INLINE int smc_jacobi128_small(int64_t D, smc_u128 n) {
+    uint64_t a = (uint64_t)(D < 0 ? -D : D);
+    int t = 1;
+    if (D < 0 && (n & 3) == 3) t = -t;                  /* (-1 / n) */
+    if ((a & 3) == 3 && (n & 3) == 3) t = -t;
+    return t * smc_jacobi64(smc_mod128_64(n, a), a);
+}
+
+SMC_API bool smc_is_square128(smc_u128 n) {
+    if (n < 2) return true;
+    uint64_t hi = (uint64_t)(n >> 64);
+    int bits = hi ? 128 - smc_clz64(hi) : 64 - smc_clz64((uint64_t)n);
+    smc_u128 x = (smc_u128)1 << ((bits + 1) / 2), y;
+    while ((y = (x + n / x) >> 1) < x) x = y;   /* Newton from above */
+    return x * x == n;
+}
+
+/*
+ * Strong Lucas probable prime with Selfridge's parameters: the first D in
+ * 5, -7, 9, -11, ... with (D / n) = -1, P = 1, Q = (1 - D) / 4. Needs odd
+ * n > 1 that is not a perfect square and has no factor among the small D.
+ */
+SMC_API bool smc_lucas128(const smc_mont128 *m) {
+    smc_u128 n = m->n;
+    int64_t D = 5;
+    for (;;) {
+        int j = smc_jacobi128_small(D, n);
+        if (j == -1) break;
+        if (j == 0 && (smc_u128)(D < 0 ? -D : D) != n) return false;
+        if (D == 21 && smc_is_square128(n)) return false;
+        D = D > 0 ? -(D + 2) : -D + 2;
+    }
+    int64_t Q = (1 - D) / 4;
+    smc_u128 Qm = smc_mont128_mul_signed(m, m->one, Q);
+
+    /* n + 1 = d 2^s; n < 2^128 - 1 since 2^128 - 1 is divisible by 3 */
+    smc_u128 d = n + 1;
+    int s = 0;
+    while ((d & 1) == 0) { d >>= 1; s++; }
+    uint64_t dh = (uint64_t)(d >> 64);
+    int top = dh ? 127 - smc_clz64(dh) : 63 - smc_clz64((uint64_t)d);
+
+    /* U_1 = 1, V_1 = P = 1, Q^1 */
+    smc_u128 U = m->one, V = m->one, Qk = Qm;
+    for (int i = top - 1; i >= 0; i--) {
+        U = smc_mont128_mul(m, U, V);                               /* U_2k */
+        V = smc_mont128_sub(m, smc_mont128_mul(m, V, V), smc_mont128_add(m, Qk, Qk));
+        Qk = smc_mont128_mul(m, Qk, Qk);
+        if ((d >> i) & 1) {
+            smc_u128 U1 = smc_mont128_half(m, smc_mont128_add(m, U, V));
+            V = smc_mont128_half(m, smc_mont128_add(m, smc_mont128_mul_signed(m, U, D), V));
+            U = U1;
+            Qk = smc_mont128_mul_signed(m, Qk, Q);
+        }
+    }
+    if (U == 0 || V == 0) return true;
+    for (int r = 1; r < s; r++) {
+        V = smc_mont128_sub(m, smc_mont128_mul(m, V, V), smc_mont128_add(m, Qk, Qk));
+        if (V == 0) return true;
+        Qk = smc_mont128_mul(m, Qk, Qk);
+    }
+    return false;
+}
+
+/* Baillie-PSW for odd n > 53 without factors up to 53 */
+SMC_API bool smc_bpsw128(smc_u128 n) {
+    smc_mont128 m;
+    smc_mont128_init(&m, n);
+    return smc_sprp2_128(&m) && smc_lucas128(&m);
+}
+
+/* Primality of a 128-bit integer (deterministic below 2^64) */
+SMC_API bool smc_is_prime128(smc_u128 n) {
+    if ((n >> 64) == 0) return smc_is_prime64((uint64_t)n);
+    if ((n & 1) == 0) return false;
+    /* One division by 3 * 5 * ... * 53, then 64-bit remainders */
+    uint64_t r = smc_mod128_64(n, 16294579238595022365ULL);
+    for (int i = 0; SMC_SMALL_PRIMES[i] <= 53; i++)
+        if (r % SMC_SMALL_PRIMES[i] == 0) return false;
+    return smc_bpsw128(n);
+}
+
+/* ===========================================================================
+ * WINDOWED SIEVE
+ *
+ * Same layout as smc_sieve: after smc_sieve128_next, bit i of 'bits' is
+ * set iff seg_lo + 2*i has no odd prime factor <= bound (other than
+ * itself). When bound^2 >= hi every survivor is prime ('exact').
+ * =========================================================================== */
+
+typedef struct smc_sieve128 {
+    smc_u128 lo, hi;            /* requested range [lo, hi) */
+    smc_u128 base;              /* first odd value >= lo */
+    uint64_t total_bits;        /* odd values in [base, hi) */
+    uint64_t done_bits;
+    smc_u128 seg_lo;            /* value of bit 0 in the current segment */
+    size_t seg_bits;
+    size_t seg_cap;
+    uint64_t *bits;
+    uint32_t *primes;           /* odd sieving primes <= bound */
+    size_t nprimes;
+    uint64_t *next;             /* per prime: absolute bit index of next multiple */
+    bool exact;                 /* survivors are prime without a BPSW test */
+} smc_sieve128;
+
+SMC_API void smc_sieve128_free(smc_sieve128 *s) {
+    free(s->bits);
+    free(s->primes);
+    free(s->next);
+    memset(s, 0, sizeof(*s));
+}
+
+/*
+ * Prepare to sieve [lo, hi) (hi - lo < 2^64) with the odd primes up to
+ * bound (0 = SMC_SIEVE128_BOUND). Returns false on allocation failure.
+ */
+SMC_API bool smc_sieve128_init(smc_sieve128 *s, smc_u128 lo, smc_u128 hi, uint32_t bound) {
+    memset(s, 0, sizeof(*s));
+    if (bound == 0) bound = SMC_SIEVE128_BOUND;
+    s->lo = lo;
+    s->hi = hi;
+    s->base = lo | 1;
+    if (hi > s->base) s->total_bits = (uint64_t)((hi - s->base + 1) / 2);
+    if (hi <= ((smc_u128)1 << 64) && smc_isqrt64((uint64_t)(hi - 1)) <= bound) {
+        bound = smc_isqrt64((uint64_t)(hi - 1));
+        s->exact = true;
+    }
+    if (s->total_bits == 0) return true;
+
+    size_t np = 0;
+    s->primes = smc_sieve_primes32(bound, &np);
+    if (s->primes == NULL) { smc_sieve128_free(s); return false; }
+    if (np > 0) memmove(s->primes, s->primes + 1, --np * sizeof(uint32_t));
+    s->nprimes = np;
+    s->seg_cap = smc_sieve_segment_bytes(np) * 8;
+    if (s->seg_cap > s->total_bits) s->seg_cap = (size_t)((s->total_bits + 63) & ~(uint64_t)63);
+    s->bits = (uint64_t *)malloc(s->seg_cap / 8);
+    s->next = (uint64_t *)malloc((np + 1) * sizeof(uint64_t));
+    if (s->bits == NULL || s->next == NULL) { smc_sieve128_free(s); return false; }
+
+    /* One remainder per prime; the first odd multiple >= max(base, p^2) */
+    for (size_t k = 0; k < np; k++) {
+        uint64_t p = s->primes[k], off;
+        smc_u128 sq = (smc_u128)p * p;
+        if (sq >= s->base) {
+            off = (uint64_t)(sq - s->base);
+        } else {
+            uint64_t r = smc_mod128_64(s->base, p);
+            off = r ? p - r : 0;
+            if (off & 1) off += p;
+        }
+        s->next[k] = off / 2;
+    }
+    return true;
+}
+
+/* Sieve the next segment. Returns false once the range is exhausted. */
+SMC_API bool smc_sieve128_next(smc_sieve128 *s) {
+    if (s->done_bits >= s->total_bits) return false;
+    uint64_t b0 = s->done_bits;
+    uint64_t left = s->total_bits - b0;
+    size_t len = left < s->seg_cap ? (size_t)left : s->seg_cap;
+    size_t words = (len + 63) / 64;
+    uint64_t *bits = s->bits;
+
+    memset(bits, 0xFF, words * 8);
+    if (len & 63) bits[words - 1] = (1ULL << (len & 63)) - 1;
+
+    uint64_t b1 = b0 + len;
+    for (size_t k = 0; k < s->nprimes; k++) {
+        uint64_t j = s->next[k];
+        if (j >= b1) continue;
+        uint64_t p = s->primes[k];
+        for (j -= b0; j < len; j += p) bits[j >> 6] &= ~(1ULL << (j & 63));
+        s->next[k] = j + b0;
+    }
+
+    s->seg_lo = s->base + 2 * (smc_u128)b0;
+    if (s->seg_lo == 1) bits[0] &= ~1ULL;
+    s->seg_bits = len;
+    s->done_bits = b1;
+    return true;
+}
+
+/* Clear the survivors of the current segment that fail Baillie-PSW */
+SMC_API void smc_sieve128_confirm(smc_sieve128 *s) {
+    if (s->exact) return;
+    size_t words = (s->seg_bits + 63) / 64;
+    for (size_t w = 0; w < words; w++) {
+        for (uint64_t m = s->bits[w]; m; m &= m - 1) {
+            int b = smc_ctz64(m);
+            smc_u128 v = s->seg_lo + 2 * (smc_u128)(64 * w + (uint64_t)b);
+            if (!smc_is_prime128(v)) s->bits[w] &= ~(1ULL << b);
+        }
+    }
+}
+
+/* ===========================================================================
+ * RANGE HELPERS
+ * =========================================================================== */
+
+/* Number of primes in [lo, hi) (hi - lo < 2^64); UINT64_MAX on allocation failure */
+SMC_API uint64_t smc_count_primes128(smc_u128 lo, smc_u128 hi, uint32_t bound) {
+    if (hi <= lo) return 0;
+    smc_sieve128 s;
+    if (!smc_sieve128_init(&s, lo, hi, bound)) return UINT64_MAX;
+    uint64_t c = (lo <= 2 && hi > 2) ? 1 : 0;
+    while (smc_sieve128_next(&s)) {
+        smc_sieve128_confirm(&s);
+        size_t words = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++) c += (uint64_t)smc_popcount64(s.bits[w]);
+    }
+    smc_sieve128_free(&s);
+    return c;
+}
+
+/*
+ * All primes in [lo, hi) (hi - lo < 2^64), ascending, as a malloc'd
+ * array; NULL on allocation failure. Sized from the prime density near
+ * lo (the proven Brun-Titchmarsh bound is several times too large that
+ * far out), growing if the window holds more.
+ */
+SMC_API smc_u128 *smc_primes128_range(smc_u128 lo, smc_u128 hi, uint32_t bound, size_t *count) {
+    *count = 0;
+    uint64_t y = hi > lo ? (uint64_t)(hi - lo) : 0;
+    double L = lo > 16 ? smc_ln((double)lo) : 2;
+    size_t cap = (size_t)(1.05 * (double)y / L) + 64, n = 0;
+    smc_u128 *out = (smc_u128 *)malloc(cap * sizeof(smc_u128));
+    if (out == NULL) return NULL;
+    if (y == 0) return out;
+    smc_sieve128 s;
+    if (!smc_sieve128_init(&s, lo, hi, bound)) { free(out); return NULL; }
+    if (lo <= 2 && hi > 2) out[n++] = 2;
+    while (smc_sieve128_next(&s)) {
+        smc_sieve128_confirm(&s);
+        size_t words = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t m = s.bits[w]; m; m &= m - 1) {
+                if (n == cap) {
+                    smc_u128 *t = (smc_u128 *)realloc(out, 2 * cap * sizeof(smc_u128));
+                    if (t == NULL) { smc_sieve128_free(&s); free(out); return NULL; }
+                    out = t;
+                    cap *= 2;
+                }
+                out[n++] = s.seg_lo + 2 * (smc_u128)(64 * w + (uint64_t)smc_ctz64(m));
+            }
+        }
+    }
+    smc_sieve128_free(&s);
+    *count = n;
+    return (smc_u128 *)smc_shrink_alloc(out, n, cap, sizeof(smc_u128));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIZEOF_INT128__ */
+
+#endif /* SMCPRIME128_H */
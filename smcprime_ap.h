@@ -0,0 +1,281 @@
+/*
+ * smcPrime - Primes in Arithmetic Progressions
+ *
+ * Counts, enumerates and steps through primes p = a (mod q) by sieving
+ * only the progression x_k = r0 + k*q:
+ * - Each sieving prime p (not dividing q) first hits index
+ *   k0 = -r0 * q^-1 (mod p), found with one modular inverse per range,
+ *   then every p-th index
+ * - Sieving stops at a bound chosen from the window size; when that is
+ *   below sqrt(hi), survivors are confirmed with smc_is_prime64
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_AP_H
+#define SMCPRIME_AP_H
+
+#include "smcprime.h"
+#include "smcprime_sieve.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Lowest sieving bound used when sqrt(hi) would be larger */
+#ifndef SMC_AP_MIN_BOUND
+  #define SMC_AP_MIN_BOUND 512
+#endif
+
+/* Progression terms per smc_ap_next window */
+#define SMC_AP_NEXT_WINDOW 64
+
+/* ===========================================================================
+ * PROGRESSION SIEVE ITERATOR
+ *
+ * After each successful smc_ap_sieve_next call, bit i of 'bits' is set
+ * iff seg_lo + i*q is prime, for i < seg_bits.
+ * =========================================================================== */
+
+typedef struct smc_ap_sieve {
+    uint64_t q;
+    uint64_t r0;            /* first term >= lo */
+    uint64_t total;         /* terms in [lo, hi) */
+    uint64_t done;          /* terms already sieved */
+    uint64_t seg_lo;        /* term represented by bit 0 */
+    size_t seg_bits, seg_cap;
+    uint64_t *bits;
+    uint32_t *primes;       /* sieving primes not dividing q */
+    size_t nprimes;
+    uint64_t *next;         /* per prime: absolute index of next hit */
+    bool confirm;           /* bound < sqrt(hi): test survivors */
+    uint64_t only;          /* gcd(a, q) > 1: the single possible prime, or 0 */
+} smc_ap_sieve;
+
+SMC_API void smc_ap_sieve_free(smc_ap_sieve *s) {
+    free(s->bits);
+    free(s->primes);
+    free(s->next);
+    memset(s, 0, sizeof(*s));
+}
+
+/*
+ * Prepare to sieve the terms of a + kq in [lo, hi) (q >= 1).
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_ap_sieve_init(smc_ap_sieve *s, uint64_t a, uint64_t q, uint64_t lo, uint64_t hi) {
+    memset(s, 0, sizeof(*s));
+    s->q = q;
+    a %= q;
+    uint64_t r = lo % q;
+    uint64_t add = a >= r ? a - r : q - (r - a);
+    if (hi <= lo || add >= hi - lo) return true;
+    s->r0 = lo + add;
+    s->total = (hi - 1 - s->r0) / q + 1;
+
+    /* Shared factor: every term is divisible by g, so only g can be prime */
+    uint64_t x = a, y = q;
+    while (y) { uint64_t t = x % y; x = y; y = t; }
+    if (x != 1) {
+        s->total = 0;
+        if (x % q == a && smc_is_prime64(x) && x >= lo && x < hi) s->only = x;
+        return true;
+    }
+
+    uint64_t root = smc_isqrt64(hi - 1);
+    uint64_t bound = s->total > SMC_AP_MIN_BOUND ? s->total : SMC_AP_MIN_BOUND;
+    if (bound >= root) bound = root;
+    else s->confirm = true;
+
+    size_t np = 0;
+    s->primes = smc_sieve_primes32((uint32_t)bound, &np);
+    s->seg_cap = smc_sieve_segment_bytes(np) * 8;
+    if (s->seg_cap > s->total) s->seg_cap = (size_t)((s->total + 63) & ~(uint64_t)63);
+    s->bits = (uint64_t *)malloc(s->seg_cap / 8);
+    s->next = (uint64_t *)malloc((np + 1) * sizeof(uint64_t));
+    if (s->primes == NULL || s->bits == NULL || s->next == NULL) { smc_ap_sieve_free(s); return false; }
+
+    size_t kept = 0;
+    for (size_t k = 0; k < np; k++) {
+        uint64_t p = s->primes[k];
+        uint64_t qp = q % p;
+        if (qp == 0) continue;
+        uint64_t neg = (p - s->r0 % p) % p;
+        uint64_t idx = neg * smc_modinv64(qp, p) % p;
+        /* Skip hits on terms <= p: those are 0 and p itself */
+        if (s->r0 <= p) {
+            uint64_t last = (p - s->r0) / q;
+            while (idx <= last) idx += p;
+        }
+        s->primes[kept] = (uint32_t)p;
+        s->next[kept++] = idx;
+    }
+    s->nprimes = kept;
+    return true;
+}
+
+/* Sieve the next segment of terms. Returns false once exhausted. */
+SMC_API bool smc_ap_sieve_next(smc_ap_sieve *s) {
+    if (s->done >= s->total) return false;
+    uint64_t b0 = s->done;
+    uint64_t left = s->total - b0;
+    size_t len = left < s->seg_cap ? (size_t)left : s->seg_cap;
+    size_t words = (len + 63) / 64;
+    uint64_t *bits = s->bits;
+
+    memset(bits, 0xFF, words * 8);
+    if (len & 63) bits[words - 1] = (1ULL << (len & 63)) - 1;
+
+    uint64_t b1 = b0 + len;
+    for (size_t k = 0; k < s->nprimes; k++) {
+        uint64_t j = s->next[k];
+        if (j >= b1) continue;
+        uint64_t p = s->primes[k];
+        for (j -= b0; j < len; j += p) bits[j >> 6] &= ~(1ULL << (j & 63));
+        s->next[k] = j + b0;
+    }
+
+    s->seg_lo = s->r0 + b0 * s->q;
+    for (size_t i = 0; i < len && s->seg_lo + i * s->q < 2; i++)
+        bits[0] &= ~(1ULL << i);   /* 0 and 1 are not prime */
+    if (s->confirm) {
+        for (size_t w = 0; w < words; w++)
+            for (uint64_t m = bits[w]; m; m &= m - 1) {
+                uint64_t i = 64 * (uint64_t)w + (uint64_t)smc_ctz64(m);
+                if (!smc_is_prime64(s->seg_lo + i * s->q)) bits[w] &= ~(1ULL << (i & 63));
+            }
+    }
+    s->seg_bits = len;
+    s->done = b1;
+    return true;
+}
+
+/* ===========================================================================
+ * RANGE HELPERS
+ * =========================================================================== */
+
+/* Number of primes p = a (mod q) in [lo, hi); UINT64_MAX on allocation failure */
+SMC_API uint64_t smc_ap_count(uint64_t a, uint64_t q, uint64_t lo, uint64_t hi) {
+    smc_ap_sieve s;
+    if (!smc_ap_sieve_init(&s, a, q, lo, hi)) return UINT64_MAX;
+    uint64_t c = s.only ? 1 : 0;
+    while (smc_ap_sieve_next(&s)) {
+        size_t words = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++) c += (uint64_t)smc_popcount64(s.bits[w]);
+    }
+    smc_ap_sieve_free(&s);
+    return c;
+}
+
+/*
+ * Lower bound on Euler's phi(q): exact over the primes up to 331; any
+ * cofactor r left has at most seven prime factors, all above 331, so
+ * phi(r) >= r (1 - 1/337)^7 > 0.9794 r.
+ */
+SMC_API double smc_ap_phi_lower(uint64_t q) {
+    double phi = 1;
+    if (q == 0) return 0;
+    int tz = smc_ctz64(q);
+    if (tz) { q >>= tz; phi = (double)(1ULL << (tz - 1)); }
+    for (size_t i = 0; i < SMC_NUM_PRIME_INV64 && q > 1; i++) {
+        uint64_t p = SMC_SMALL_PRIMES[i];
+        if (q % p) continue;
+        q /= p;
+        phi *= (double)(p - 1);
+        while (q % p == 0) { q /= p; phi *= (double)p; }
+    }
+    if (q > 1) phi *= smc_is_prime64(q) ? (double)(q - 1) : 0.9794 * (double)q;
+    return phi;
+}
+
+/*
+ * Upper bound on the number of primes p = a (mod q) in [lo, hi): the
+ * number of terms, the plain range bound, and Montgomery-Vaughan's
+ * 2y / (phi(q) ln(y / q)) for y = hi - lo well above q.
+ */
+SMC_API uint64_t smc_ap_count_upper(uint64_t a, uint64_t q, uint64_t lo, uint64_t hi) {
+    if (hi <= lo || q == 0) return 0;
+    a %= q;
+    uint64_t r0 = lo % q;
+    uint64_t add = a >= r0 ? a - r0 : q - (r0 - a);
+    if (add >= hi - lo) return 0;
+    uint64_t b = (hi - 1 - lo - add) / q + 1;
+    uint64_t x = a, y = q;
+    while (y) { uint64_t t = x % y; x = y; y = t; }
+    if (x != 1) return 1;
+    uint64_t r = smc_pi_range_upper(lo, hi);
+    if (r < b) b = r;
+    uint64_t span = hi - lo;
+    if (lo >= 2 && span / 16 >= q) {
+        double yd = (double)span;
+        uint64_t mv = smc_bound_up(2 * yd / (smc_ap_phi_lower(q) * smc_ln(yd / (double)q)));
+        if (mv < b) b = mv;
+    }
+    return b;
+}
+
+/*
+ * All primes p = a (mod q) in [lo, hi), ascending.
+ *
+ * Returns a malloc'd array and stores its length in *count, or NULL on
+ * allocation failure. The array is allocated once from
+ * smc_ap_count_upper and trimmed to size at the end.
+ */
+SMC_API uint64_t *smc_ap_primes(uint64_t a, uint64_t q, uint64_t lo, uint64_t hi, size_t *count) {
+    *count = 0;
+    size_t cap = (size_t)smc_ap_count_upper(a, q, lo, hi) + 1, n = 0;
+    uint64_t *out = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    smc_ap_sieve s;
+    if (out == NULL || !smc_ap_sieve_init(&s, a, q, lo, hi)) { free(out); return NULL; }
+    if (s.only) out[n++] = s.only;
+    while (smc_ap_sieve_next(&s)) {
+        size_t words = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t m = s.bits[w]; m; m &= m - 1) {
+                if (n == cap) {
+                    uint64_t *t = (uint64_t *)realloc(out, 2 * cap * sizeof(uint64_t));
+                    if (t == NULL) { smc_ap_sieve_free(&s); free(out); return NULL; }
+                    out = t;
+                    cap *= 2;
+                }
+                out[n++] = s.seg_lo + (64 * (uint64_t)w + (uint64_t)smc_ctz64(m)) * q;
+            }
+        }
+    }
+    smc_ap_sieve_free(&s);
+    *count = n;
+    return (uint64_t *)smc_shrink_alloc(out, n, cap, sizeof(uint64_t));
+}
+
+/*
+ * Smallest prime p >= n with p = a (mod q), or 0 if there is none below
+ * 2^64 (including when gcd(a, q) > 1 rules everything out).
+ */
+SMC_API uint64_t smc_ap_next(uint64_t a, uint64_t q, uint64_t n) {
+    uint64_t lo = n;
+    while (true) {
+        uint64_t span = q > UINT64_MAX / SMC_AP_NEXT_WINDOW ? UINT64_MAX : (uint64_t)SMC_AP_NEXT_WINDOW * q;
+        uint64_t hi = UINT64_MAX - lo < span ? UINT64_MAX : lo + span;
+        smc_ap_sieve s;
+        if (!smc_ap_sieve_init(&s, a, q, lo, hi)) return 0;
+        uint64_t found = s.only;
+        bool more = s.total != 0;
+        while (!found && smc_ap_sieve_next(&s)) {
+            size_t words = (s.seg_bits + 63) / 64;
+            for (size_t w = 0; w < words && !found; w++)
+                if (s.bits[w]) found = s.seg_lo + (64 * (uint64_t)w + (uint64_t)smc_ctz64(s.bits[w])) * q;
+        }
+        smc_ap_sieve_free(&s);
+        if (found || !more || hi == UINT64_MAX) return found;
+        lo = hi;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_AP_H */
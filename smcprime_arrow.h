@@ -0,0 +1,436 @@
+/*
+ * smcPrime - Arrow C Data Interface
+ *
+ * Batch classification of Arrow integer columns where they lie, with no
+ * Arrow dependency (the ABI structs are declared here under the guard the
+ * specification prescribes):
+ * - Primality of a uint64, int64, uint32 or int32 array, either into a
+ *   boolean array (bit-packed values, validity carried over) or into a
+ *   caller's bitmap; blocks of words spread over threads
+ * - Factorization into a list<uint64> array: small values one at a time,
+ *   large ones through the lane-parallel smc_factor_batch
+ *
+ * Values are read through the input's buffers and offset. Null slots are
+ * skipped and stay null; negative signed values are neither prime nor
+ * factored. Results own their buffers and free them through the standard
+ * release callbacks.
+ *
+ * POSIX builds using the threaded classification must link with -pthread.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_ARROW_H
+#define SMCPRIME_ARROW_H
+
+#include "smcprime.h"
+#include "smcprime_factor.h"
+#include "smcprime_sys.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===========================================================================
+ * ARROW C DATA INTERFACE
+ * =========================================================================== */
+
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char *format;
+    const char *name;
+    const char *metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema **children;
+    struct ArrowSchema *dictionary;
+    void (*release)(struct ArrowSchema *);
+    void *private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void **buffers;
+    struct ArrowArray **children;
+    struct ArrowArray *dictionary;
+    void (*release)(struct ArrowArray *);
+    void *private_data;
+};
+
+#endif /* ARROW_C_DATA_INTERFACE */
+
+/* Bitmap words (64 values) per primality task */
+#ifndef SMC_ARROW_BLOCK
+  #define SMC_ARROW_BLOCK 64
+#endif
+
+/*
+ * Values from here on are factored by the lane-parallel batch rho rather
+ * than one at a time; it only pays off for large cofactors, and earlier
+ * with the IFMA lanes
+ */
+#ifndef SMC_ARROW_FACTOR_SPLIT
+  #if defined(__AVX512IFMA__) && defined(__AVX512F__) && defined(__SIZEOF_INT128__)
+    #define SMC_ARROW_FACTOR_SPLIT (1ULL << 40)
+  #else
+    #define SMC_ARROW_FACTOR_SPLIT (1ULL << 48)
+  #endif
+#endif
+
+/* ===========================================================================
+ * INPUT COLUMNS
+ * =========================================================================== */
+
+/* A validated integer column: element width, signedness and buffers */
+typedef struct smc_arrow_column {
+    const uint8_t *valid;   /* NULL if every slot is valid */
+    const uint8_t *data;
+    uint64_t offset;
+    uint64_t length;
+    unsigned width;         /* bytes: 4 or 8 */
+    bool is_signed;
+} smc_arrow_column;
+
+/*
+ * Check that schema / array describe a live (unreleased), dictionary-free
+ * integer array of format "L", "l", "I" or "i", and describe it in *c
+ */
+SMC_API bool smc_arrow_column_init(smc_arrow_column *c, const struct ArrowSchema *schema,
+                                   const struct ArrowArray *array) {
+    if (schema == NULL || array == NULL || schema->release == NULL || array->release == NULL) return false;
+    const char *f = schema->format;
+    if (f == NULL || f[0] == 0 || f[1] != 0 || schema->dictionary != NULL) return false;
+    switch (f[0]) {
+        case 'L': c->width = 8; c->is_signed = false; break;
+        case 'l': c->width = 8; c->is_signed = true; break;
+        case 'I': c->width = 4; c->is_signed = false; break;
+        case 'i': c->width = 4; c->is_signed = true; break;
+        default: return false;
+    }
+    if (array->length < 0 || array->offset < 0 || array->n_buffers != 2 || array->buffers == NULL) return false;
+    c->length = (uint64_t)array->length;
+    c->offset = (uint64_t)array->offset;
+    c->valid = array->null_count == 0 ? NULL : (const uint8_t *)array->buffers[0];
+    c->data = (const uint8_t *)array->buffers[1];
+    return c->data != NULL || c->length == 0;
+}
+
+/* Slot i of the column (after the array offset); negatives read as 0 */
+SMC_INLINE uint64_t smc_arrow_value(const smc_arrow_column *c, uint64_t i) {
+    i += c->offset;
+    if (c->width == 8) {
+        uint64_t v;
+        memcpy(&v, c->data + 8 * i, 8);
+        return c->is_signed && (int64_t)v < 0 ? 0 : v;
+    }
+    uint32_t v;
+    memcpy(&v, c->data + 4 * i, 4);
+    return c->is_signed && (int32_t)v < 0 ? 0 : v;
+}
+
+/* As smc_arrow_value, with null slots read as 0 */
+SMC_INLINE uint64_t smc_arrow_slot(const smc_arrow_column *c, uint64_t i) {
+    uint64_t j = c->offset + i;
+    if (c->valid != NULL && !((c->valid[j >> 3] >> (j & 7)) & 1)) return 0;
+    return smc_arrow_value(c, i);
+}
+
+/* n <= 64 bits of an Arrow bitmap from bit pos, least significant first */
+SMC_INLINE uint64_t smc_arrow_bits(const uint8_t *bits, uint64_t pos, unsigned n) {
+    const uint8_t *b = bits + (pos >> 3);
+    unsigned sh = (unsigned)(pos & 7), nb = (sh + n + 7) >> 3;
+    uint64_t w = 0;
+    for (unsigned k = 0; k < nb && k < 8; k++) w |= (uint64_t)b[k] << (8 * k);
+    w >>= sh;
+    if (nb > 8) w |= (uint64_t)b[8] << (64 - sh);
+    return n < 64 ? w & ((1ULL << n) - 1) : w;
+}
+
+/* The low nbytes bytes of w into an Arrow bitmap, least significant first */
+SMC_INLINE void smc_arrow_store_bits(uint8_t *dst, uint64_t w, unsigned nbytes) {
+    for (unsigned k = 0; k < nbytes; k++) dst[k] = (uint8_t)(w >> (8 * k));
+}
+
+/* ===========================================================================
+ * OWNED RESULTS
+ * =========================================================================== */
+
+/* Producer data behind an exported array or schema: up to two buffers, one child */
+typedef struct smc_arrow_owned {
+    const void *buffers[2];
+    struct ArrowArray *array_children[1];
+    struct ArrowArray array_child;
+    struct ArrowSchema *schema_children[1];
+    struct ArrowSchema schema_child;
+} smc_arrow_owned;
+
+SMC_API void smc_arrow_release_array(struct ArrowArray *a) {
+    smc_arrow_owned *o = (smc_arrow_owned *)a->private_data;
+    for (int64_t k = 0; k < a->n_children; k++) {
+        if (a->children[k]->release != NULL) a->children[k]->release(a->children[k]);
+    }
+    free((void *)o->buffers[0]);
+    free((void *)o->buffers[1]);
+    free(o);
+    a->release = NULL;
+}
+
+SMC_API void smc_arrow_release_schema(struct ArrowSchema *s) {
+    for (int64_t k = 0; k < s->n_children; k++) {
+        if (s->children[k]->release != NULL) s->children[k]->release(s->children[k]);
+    }
+    free(s->private_data);
+    s->release = NULL;
+}
+
+/* A fresh array with n_buffers buffers (owned by the new private data) */
+SMC_API bool smc_arrow_array_init(struct ArrowArray *a, int64_t length, int64_t n_buffers) {
+    memset(a, 0, sizeof(*a));
+    smc_arrow_owned *o = (smc_arrow_owned *)calloc(1, sizeof(smc_arrow_owned));
+    if (o == NULL) return false;
+    a->length = length;
+    a->n_buffers = n_buffers;
+    a->buffers = o->buffers;
+    a->release = smc_arrow_release_array;
+    a->private_data = o;
+    return true;
+}
+
+/* A fresh schema; format and name must be static strings */
+SMC_API bool smc_arrow_schema_init(struct ArrowSchema *s, const char *format, const char *name) {
+    memset(s, 0, sizeof(*s));
+    smc_arrow_owned *o = (smc_arrow_owned *)calloc(1, sizeof(smc_arrow_owned));
+    if (o == NULL) return false;
+    s->format = format;
+    s->name = name;
+    s->flags = ARROW_FLAG_NULLABLE;
+    s->release = smc_arrow_release_schema;
+    s->private_data = o;
+    return true;
+}
+
+/* Allocation for a bitmap of n bits, padded to 64 bytes as Arrow recommends */
+SMC_INLINE uint8_t *smc_arrow_bitmap_alloc(uint64_t n) {
+    size_t bytes = (size_t)((n + 511) / 512 * 64);
+    return (uint8_t *)malloc(bytes ? bytes : 64);
+}
+
+/*
+ * The input validity moved to offset 0 in dst (n bits); returns the
+ * number of null slots
+ */
+SMC_API int64_t smc_arrow_copy_validity(uint8_t *dst, const smc_arrow_column *c) {
+    int64_t nulls = 0;
+    for (uint64_t w = 0; 64 * w < c->length; w++) {
+        uint64_t i = 64 * w;
+        unsigned n = c->length - i < 64 ? (unsigned)(c->length - i) : 64;
+        uint64_t v = smc_arrow_bits(c->valid, c->offset + i, n);
+        nulls += n - (unsigned)smc_popcount64(v);
+        smc_arrow_store_bits(dst + 8 * w, v, (n + 7) / 8);
+    }
+    return nulls;
+}
+
+/* ===========================================================================
+ * PRIMALITY
+ * =========================================================================== */
+
+typedef struct smc_arrow_prime_job {
+    const smc_arrow_column *col;
+    uint8_t *bits;
+} smc_arrow_prime_job;
+
+/* Bitmap words [SMC_ARROW_BLOCK * index, ...) of the primality column */
+SMC_API void smc_arrow_prime_task(void *ctx, size_t index) {
+    const smc_arrow_prime_job *job = (const smc_arrow_prime_job *)ctx;
+    const smc_arrow_column *c = job->col;
+    uint64_t end = c->length;
+    for (uint64_t w = (uint64_t)index * SMC_ARROW_BLOCK; w < (uint64_t)(index + 1) * SMC_ARROW_BLOCK; w++) {
+        uint64_t i = 64 * w;
+        if (i >= end) break;
+        unsigned n = end - i < 64 ? (unsigned)(end - i) : 64;
+        uint64_t todo = c->valid ? smc_arrow_bits(c->valid, c->offset + i, n)
+                                 : n < 64 ? (1ULL << n) - 1 : UINT64_MAX;
+        uint64_t res = 0;
+        while (todo) {
+            unsigned k = (unsigned)smc_ctz64(todo);
+            todo &= todo - 1;
+            if (smc_is_prime64(smc_arrow_value(c, i + k))) res |= 1ULL << k;
+        }
+        smc_arrow_store_bits(job->bits + 8 * w, res, (n + 7) / 8);
+    }
+}
+
+/*
+ * Primality of every slot of an integer array into bits (length bits from
+ * bit 0, least significant first; null slots read 0) on up to 'threads'
+ * threads (0 = one per hardware thread). Returns false for an unsupported
+ * array or if threads could not be started (bits is complete either way).
+ */
+SMC_API bool smc_arrow_is_prime_bits(const struct ArrowSchema *schema, const struct ArrowArray *array,
+                                     uint8_t *bits, unsigned threads) {
+    smc_arrow_column c;
+    if (!smc_arrow_column_init(&c, schema, array)) return false;
+    smc_arrow_prime_job job;
+    job.col = &c;
+    job.bits = bits;
+    uint64_t words = (c.length + 63) / 64;
+    size_t tasks = (size_t)((words + SMC_ARROW_BLOCK - 1) / SMC_ARROW_BLOCK);
+    if (threads == 1 || tasks <= 1) {
+        for (size_t t = 0; t < tasks; t++) smc_arrow_prime_task(&job, t);
+        return true;
+    }
+    return smc_parallel_for(tasks, threads, smc_arrow_prime_task, &job);
+}
+
+/*
+ * Primality of an integer array as a new boolean array in *out (and its
+ * schema in *out_schema unless NULL), nulls where the input has them.
+ * Release both with their release callbacks. Returns false for an
+ * unsupported array or on allocation failure (nothing to release then).
+ */
+SMC_API bool smc_arrow_is_prime(const struct ArrowSchema *schema, const struct ArrowArray *array, unsigned threads,
+                                struct ArrowArray *out, struct ArrowSchema *out_schema) {
+    smc_arrow_column c;
+    if (!smc_arrow_column_init(&c, schema, array)) return false;
+    if (!smc_arrow_array_init(out, array->length, 2)) return false;
+    smc_arrow_owned *o = (smc_arrow_owned *)out->private_data;
+    uint8_t *values = smc_arrow_bitmap_alloc(c.length);
+    uint8_t *valid = c.valid ? smc_arrow_bitmap_alloc(c.length) : NULL;
+    o->buffers[0] = valid;
+    o->buffers[1] = values;
+    if (values == NULL || (c.valid && valid == NULL) ||
+        (out_schema != NULL && !smc_arrow_schema_init(out_schema, "b", "is_prime"))) {
+        out->release(out);
+        return false;
+    }
+    out->null_count = valid ? smc_arrow_copy_validity(valid, &c) : 0;
+    smc_arrow_is_prime_bits(schema, array, values, threads);
+    return true;
+}
+
+/* ===========================================================================
+ * FACTORIZATION
+ * =========================================================================== */
+
+/*
+ * Prime factors of every slot of an integer array as a new list<uint64>
+ * array in *out (schema "+l" with a "L" child in *out_schema unless NULL):
+ * slot i lists its factors ascending with multiplicity, empty for 0, 1 and
+ * negatives, null where the input is null. Values below
+ * SMC_ARROW_FACTOR_SPLIT are factored one by one with smc_factor64 and
+ * the rest gathered for smc_factor_batch. Release with the release
+ * callbacks. Returns false for an unsupported array, 2^31 or more factors
+ * in total, or on allocation failure.
+ */
+SMC_API bool smc_arrow_factor(const struct ArrowSchema *schema, const struct ArrowArray *array,
+                              struct ArrowArray *out, struct ArrowSchema *out_schema) {
+    smc_arrow_column c;
+    if (!smc_arrow_column_init(&c, schema, array)) return false;
+    if (c.length > INT32_MAX) return false;
+    size_t count = (size_t)c.length;
+
+    /* Large values to the lane-parallel rho; null slots read 0, which has no factors */
+    size_t nbig = 0;
+    for (size_t i = 0; i < count; i++) nbig += smc_arrow_slot(&c, i) >= SMC_ARROW_FACTOR_SPLIT;
+    uint64_t *big = (uint64_t *)malloc((nbig ? nbig : 1) * sizeof(uint64_t));
+    if (big == NULL) return false;
+    nbig = 0;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t v = smc_arrow_slot(&c, i);
+        if (v >= SMC_ARROW_FACTOR_SPLIT) big[nbig++] = v;
+    }
+    smc_factor_chunk chunk;
+    bool ok = smc_factor_batch(big, nbig, &chunk);
+    free(big);
+    if (!ok) return false;
+
+    /* Offsets and factors in slot order */
+    uint8_t *valid = c.valid ? smc_arrow_bitmap_alloc(c.length) : NULL;
+    int32_t *off = (int32_t *)malloc((count + 1) * sizeof(int32_t));
+    size_t cap = 2 * count + SMC_MAX_FACTORS64;
+    uint64_t *fac = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    ok = off != NULL && fac != NULL && (c.valid == NULL || valid != NULL);
+    size_t total = 0, b = 0;
+    for (size_t i = 0; i < count && ok; i++) {
+        off[i] = (int32_t)total;
+        if (total + SMC_MAX_FACTORS64 > cap) {
+            uint64_t *t = (uint64_t *)realloc(fac, 2 * cap * sizeof(uint64_t));
+            if (t == NULL) { ok = false; break; }
+            fac = t;
+            cap *= 2;
+        }
+        uint64_t v = smc_arrow_slot(&c, i);
+        if (v < SMC_ARROW_FACTOR_SPLIT) {
+            total += (size_t)smc_factor64(v, fac + total);
+        } else {
+            uint32_t k0 = chunk.offset[b], k1 = chunk.offset[b + 1];
+            memcpy(fac + total, chunk.factor + k0, (k1 - k0) * sizeof(uint64_t));
+            total += k1 - k0;
+            b++;
+        }
+        if (total > INT32_MAX) ok = false;
+    }
+    smc_factor_chunk_free(&chunk);
+    if (ok) {
+        off[count] = (int32_t)total;
+        ok = smc_arrow_array_init(out, array->length, 2);
+    }
+    if (!ok) {
+        free(valid);
+        free(off);
+        free(fac);
+        return false;
+    }
+    smc_arrow_owned *o = (smc_arrow_owned *)out->private_data;
+    o->buffers[0] = valid;
+    o->buffers[1] = off;
+    out->null_count = valid ? smc_arrow_copy_validity(valid, &c) : 0;
+    struct ArrowArray *child = &o->array_child;
+    if (!smc_arrow_array_init(child, (int64_t)total, 2)) {
+        free(fac);
+        out->release(out);
+        return false;
+    }
+    ((smc_arrow_owned *)child->private_data)->buffers[1] = fac;
+    o->array_children[0] = child;
+    out->n_children = 1;
+    out->children = o->array_children;
+
+    if (out_schema != NULL) {
+        if (!smc_arrow_schema_init(out_schema, "+l", "factors")) {
+            out->release(out);
+            return false;
+        }
+        smc_arrow_owned *so = (smc_arrow_owned *)out_schema->private_data;
+        if (!smc_arrow_schema_init(&so->schema_child, "L", "item")) {
+            out_schema->release(out_schema);
+            out->release(out);
+            return false;
+        }
+        so->schema_child.flags = 0;
+        so->schema_children[0] = &so->schema_child;
+        out_schema->n_children = 1;
+        out_schema->children = so->schema_children;
+    }
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_ARROW_H */
@@ -0,0 +1,363 @@
+/*
+ * smcPrime - C++20 Async Jobs
+ *
+ * Awaitable versions of the long-running range operations:
+ * - smc::async_count_primes(lo, hi), smc::async_primes(lo, hi)
+ * - smc::async_factor(numbers): batch factorization into one arena
+ *
+ * co_await starts the job on a background thread (smc_spawn), which fans
+ * the work out with smc_parallel_for and resumes the awaiting coroutine
+ * when it finishes. Jobs publish progress through smc::job_progress and
+ * check a std::stop_token between sieve segments / factor blocks; a
+ * cancelled job yields an empty std::optional.
+ *
+ * POSIX builds must link with -pthread. GCC 12 destroys braced temporaries
+ * inside a co_await expression twice, so build async_options in a named
+ * variable there.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_ASYNC_HPP
+#define SMCPRIME_ASYNC_HPP
+
+#include "smcprime.h"
+#include "smcprime_factor.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <utility>
+#include <vector>
+
+/* Numbers per cancellation check in async_factor */
+#ifndef SMC_ASYNC_FACTOR_BLOCK
+  #define SMC_ASYNC_FACTOR_BLOCK 1024
+#endif
+
+/* Smallest slice of a range handed to one worker (integers) */
+#ifndef SMC_ASYNC_MIN_SLICE
+  #define SMC_ASYNC_MIN_SLICE ((uint64_t)1 << 24)
+#endif
+
+namespace smc {
+
+/* ===========================================================================
+ * JOB PLUMBING
+ * =========================================================================== */
+
+/* Work done so far, safe to poll from any thread while the job runs */
+struct job_progress {
+    std::atomic<uint64_t> done{0};
+    std::atomic<uint64_t> total{0};
+
+    double fraction() const {
+        uint64_t t = total.load(std::memory_order_relaxed);
+        return t ? (double)done.load(std::memory_order_relaxed) / (double)t : 0.0;
+    }
+};
+
+struct async_options {
+    unsigned threads = 0;               /* worker threads, 0 = one per hardware thread */
+    std::stop_token stop{};             /* checked once per segment / block */
+    job_progress *progress = nullptr;   /* optional; units are job-specific */
+    /* Where to resume the awaiting coroutine; by default it resumes on the
+       job's background thread. Event loops pass a function that posts the
+       handle to their own queue. */
+    std::function<void(std::coroutine_handle<>)> resume{};
+};
+
+/*
+ * Single-use awaitable returned by the async_* functions. Nothing runs
+ * until it is awaited; await it exactly once, and keep inputs passed by
+ * reference alive until then.
+ */
+template <class T>
+class async_job {
+public:
+    using work_fn = std::function<std::optional<T>(const async_options &)>;
+
+    async_job(work_fn work, async_options opt) : st_(std::make_unique<state>()) {
+        st_->work = std::move(work);
+        st_->opt = std::move(opt);
+    }
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> h) {
+        st_->handle = h;
+        if (smc_spawn(&async_job::run, st_.get())) return true;
+        execute(*st_);      /* no thread available: run here, do not suspend */
+        return false;
+    }
+
+    std::optional<T> await_resume() {
+        if (st_->error) std::rethrow_exception(st_->error);
+        return std::move(st_->result);
+    }
+
+private:
+    struct state {
+        work_fn work;
+        async_options opt;
+        std::optional<T> result;
+        std::exception_ptr error;
+        std::coroutine_handle<> handle;
+    };
+
+    static void execute(state &st) noexcept {
+        try {
+            st.result = st.work(st.opt);
+        } catch (...) {
+            st.error = std::current_exception();
+        }
+    }
+
+    static void run(void *ctx, size_t) {
+        state *st = static_cast<state *>(ctx);
+        execute(*st);
+        /* Resuming may destroy *st (it lives in the awaiter), so take
+           what is needed first */
+        auto resume = std::move(st->opt.resume);
+        std::coroutine_handle<> h = st->handle;
+        if (resume) resume(h);
+        else h.resume();
+    }
+
+    std::unique_ptr<state> st_;
+};
+
+namespace detail {
+
+/* smc_parallel_for over a callable; the first exception is rethrown after the join */
+template <class F>
+void parallel_for(size_t count, unsigned threads, F &fn) {
+    struct ctx_t {
+        F *fn;
+        std::mutex mu;
+        std::exception_ptr error;
+    } ctx{&fn, {}, {}};
+    smc_parallel_for(count, threads, [](void *p, size_t i) {
+        ctx_t *c = static_cast<ctx_t *>(p);
+        try {
+            (*c->fn)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(c->mu);
+            if (!c->error) c->error = std::current_exception();
+        }
+    }, &ctx);
+    if (ctx.error) std::rethrow_exception(ctx.error);
+}
+
+inline unsigned resolve_threads(unsigned threads) {
+    return threads ? threads : smc_thread_count();
+}
+
+/* Split [lo, hi) into slices for the workers; returns the slice width */
+inline uint64_t slice_span(uint64_t lo, uint64_t hi, unsigned threads, size_t *count) {
+    uint64_t len = hi - lo;
+    uint64_t span = len / (4 * (uint64_t)threads) + 1;
+    if (span < SMC_ASYNC_MIN_SLICE) span = SMC_ASYNC_MIN_SLICE;
+    *count = len ? (size_t)((len - 1) / span + 1) : 0;
+    return span;
+}
+
+/*
+ * Odd sieving primes <= isqrt(hi - 1) for a whole job, built once and
+ * shared by its slices. Sieved in segments with a cancellation check
+ * after each one (near 2^64 this is ~203M primes and the longest phase
+ * of the job). Returns false if cancelled.
+ */
+inline bool sieve_primes(uint64_t hi, const async_options &opt, std::vector<uint32_t> &out) {
+    if (opt.stop.stop_requested()) return false;
+    uint64_t root = hi > 1 ? smc_isqrt64(hi - 1) : 0;
+    if (root < 3) return true;
+    out.reserve((size_t)smc_pi_upper(root));
+    smc_sieve s;
+    if (!smc_sieve_init(&s, 3, root + 1)) throw std::bad_alloc();
+    struct guard { smc_sieve *s; ~guard() { smc_sieve_free(s); } } g{&s};
+    while (smc_sieve_next(&s)) {
+        if (opt.stop.stop_requested()) return false;
+        size_t words = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++)
+            for (uint64_t m = s.bits[w]; m; m &= m - 1)
+                out.push_back((uint32_t)(s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m))));
+    }
+    return true;
+}
+
+/*
+ * Sieve slice i of [lo, hi) with the job's sieving primes (borrowed, not
+ * copied), calling seg(s) for every segment and reporting progress in
+ * integers covered. Returns false if cancelled.
+ */
+template <class Seg>
+bool sieve_slice(uint64_t lo, uint64_t hi, uint64_t span, size_t i,
+                 const std::vector<uint32_t> &primes, const async_options &opt, Seg &&seg) {
+    if (opt.stop.stop_requested()) return false;
+    uint64_t a = lo + i * span;
+    uint64_t b = hi - a < span ? hi : a + span;
+    smc_sieve s;
+    if (!smc_sieve_init_borrow(&s, a, b, primes.data(), primes.size())) throw std::bad_alloc();
+    struct guard { smc_sieve *s; ~guard() { smc_sieve_free(s); } } g{&s};
+    uint64_t reported = 0;
+    while (smc_sieve_next(&s)) {
+        if (opt.stop.stop_requested()) return false;
+        seg(s);
+        if (opt.progress) {
+            uint64_t covered = s.seg_lo + 2 * (uint64_t)s.seg_bits - a;
+            if (covered > b - a) covered = b - a;
+            opt.progress->done.fetch_add(covered - reported, std::memory_order_relaxed);
+            reported = covered;
+        }
+    }
+    if (opt.progress) opt.progress->done.fetch_add((b - a) - reported, std::memory_order_relaxed);
+    return !opt.stop.stop_requested();
+}
+
+} /* namespace detail */
+
+/* ===========================================================================
+ * RANGE JOBS
+ *
+ * Progress is measured in integers of [lo, hi) covered.
+ * =========================================================================== */
+
+/* Number of primes in [lo, hi) */
+inline async_job<uint64_t> async_count_primes(uint64_t lo, uint64_t hi, async_options opt = {}) {
+    return async_job<uint64_t>([lo, hi](const async_options &o) -> std::optional<uint64_t> {
+        uint64_t end = hi < lo ? lo : hi;
+        unsigned threads = detail::resolve_threads(o.threads);
+        size_t slices;
+        uint64_t span = detail::slice_span(lo, end, threads, &slices);
+        if (o.progress) o.progress->total.store(end - lo, std::memory_order_relaxed);
+        std::vector<uint32_t> primes;
+        if (!detail::sieve_primes(end, o, primes)) return std::nullopt;
+
+        std::vector<uint64_t> counts(slices, 0);
+        std::atomic<bool> cancelled{false};
+        auto task = [&](size_t i) {
+            uint64_t c = 0;
+            bool ok = detail::sieve_slice(lo, end, span, i, primes, o, [&c](const smc_sieve &s) {
+                c += smc_sieve_segment_count(&s);
+            });
+            if (!ok) cancelled = true;
+            counts[i] = c;
+        };
+        detail::parallel_for(slices, threads, task);
+        if (cancelled) return std::nullopt;
+
+        uint64_t total = lo <= 2 && end > 2 ? 1 : 0;
+        for (uint64_t c : counts) total += c;
+        return total;
+    }, std::move(opt));
+}
+
+/* All primes in [lo, hi), ascending */
+inline async_job<std::vector<uint64_t>> async_primes(uint64_t lo, uint64_t hi, async_options opt = {}) {
+    using list = std::vector<uint64_t>;
+    return async_job<list>([lo, hi](const async_options &o) -> std::optional<list> {
+        uint64_t end = hi < lo ? lo : hi;
+        unsigned threads = detail::resolve_threads(o.threads);
+        size_t slices;
+        uint64_t span = detail::slice_span(lo, end, threads, &slices);
+        if (o.progress) o.progress->total.store(end - lo, std::memory_order_relaxed);
+        std::vector<uint32_t> primes;
+        if (!detail::sieve_primes(end, o, primes)) return std::nullopt;
+
+        std::vector<list> parts(slices);
+        std::atomic<bool> cancelled{false};
+        auto task = [&](size_t i) {
+            list &out = parts[i];
+            uint64_t a = lo + i * span;
+            out.reserve((size_t)smc_pi_range_upper(a, end - a < span ? end : a + span));
+            bool ok = detail::sieve_slice(lo, end, span, i, primes, o, [&out](const smc_sieve &s) {
+                size_t words = (s.seg_bits + 63) / 64;
+                for (size_t w = 0; w < words; w++)
+                    for (uint64_t m = s.bits[w]; m; m &= m - 1)
+                        out.push_back(s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m)));
+            });
+            if (!ok) cancelled = true;
+        };
+        detail::parallel_for(slices, threads, task);
+        if (cancelled) return std::nullopt;
+
+        size_t n = lo <= 2 && end > 2 ? 1 : 0;
+        for (const list &p : parts) n += p.size();
+        list all;
+        all.reserve(n);
+        if (lo <= 2 && end > 2) all.push_back(2);
+        for (list &p : parts) {
+            all.insert(all.end(), p.begin(), p.end());
+            list().swap(p);
+        }
+        return all;
+    }, std::move(opt));
+}
+
+/* ===========================================================================
+ * BATCH FACTORIZATION
+ *
+ * Progress is measured in numbers factored.
+ * =========================================================================== */
+
+/* Factors of n[i] are factor[offset[i] .. offset[i + 1]), ascending */
+struct factor_batch {
+    std::vector<uint32_t> offset;
+    std::vector<uint64_t> factor;
+};
+
+/* Factor every number of n (smc_factor_batch); n must stay alive until the job completes */
+inline async_job<factor_batch> async_factor(std::span<const uint64_t> n, async_options opt = {}) {
+    return async_job<factor_batch>([n](const async_options &o) -> std::optional<factor_batch> {
+        const size_t block = SMC_ASYNC_FACTOR_BLOCK;
+        size_t blocks = (n.size() + block - 1) / block;
+        if (o.progress) o.progress->total.store(n.size(), std::memory_order_relaxed);
+
+        /* Per block: factor counts, then the factors themselves */
+        std::vector<std::vector<uint8_t>> counts(blocks);
+        std::vector<std::vector<uint64_t>> factors(blocks);
+        std::atomic<bool> cancelled{false};
+        auto task = [&](size_t b) {
+            if (o.stop.stop_requested()) { cancelled = true; return; }
+            size_t i0 = b * block, i1 = n.size() - i0 < block ? n.size() : i0 + block;
+            smc_factor_chunk ch;
+            if (!smc_factor_batch(n.data() + i0, i1 - i0, &ch)) throw std::bad_alloc();
+            counts[b].resize(i1 - i0);
+            for (size_t i = 0; i < i1 - i0; i++) counts[b][i] = (uint8_t)(ch.offset[i + 1] - ch.offset[i]);
+            factors[b].assign(ch.factor, ch.factor + ch.offset[i1 - i0]);
+            smc_factor_chunk_free(&ch);
+            if (o.progress) o.progress->done.fetch_add(i1 - i0, std::memory_order_relaxed);
+        };
+        detail::parallel_for(blocks, detail::resolve_threads(o.threads), task);
+        if (cancelled) return std::nullopt;
+
+        factor_batch out;
+        size_t total = 0;
+        for (const auto &f : factors) total += f.size();
+        out.offset.reserve(n.size() + 1);
+        out.factor.reserve(total);
+        out.offset.push_back(0);
+        for (size_t b = 0; b < blocks; b++) {
+            for (uint8_t k : counts[b]) out.offset.push_back(out.offset.back() + k);
+            out.factor.insert(out.factor.end(), factors[b].begin(), factors[b].end());
+        }
+        return out;
+    }, std::move(opt));
+}
+
+} /* namespace smc */
+
+#endif /* SMCPRIME_ASYNC_HPP */
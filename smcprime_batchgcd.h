@@ -0,0 +1,491 @@
+/*
+ * smcPrime - Batch GCD
+ *
+ * Finds the moduli of a large set that share a prime with any other
+ * (Bernstein's batch GCD), in quasi-linear time instead of one gcd per pair:
+ * - Product tree of the moduli P, built one level at a time
+ * - Remainder tree of P mod x^2 from the root down, kept as scaled
+ *   fractions so each node costs one product and no division
+ * - gcd(x_i, (P mod x_i^2) / x_i) for every modulus
+ *
+ * Large products use the NTT of smcprime_goldbach.h on 16-bit digits;
+ * the root's reciprocal uses Newton's iteration.
+ * Levels with many nodes spread the nodes over threads, the few big nodes
+ * near the root thread their transforms instead.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_BATCHGCD_H
+#define SMCPRIME_BATCHGCD_H
+
+#include "smcprime.h"
+#include "smcprime_mp.h"
+#include "smcprime_goldbach.h"
+#include "smcprime_sys.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Operand size (limbs) from which products switch to the NTT */
+#ifndef SMC_MP_NTT
+  #define SMC_MP_NTT 1024
+#endif
+
+/* Divisor size (limbs) from which reciprocals use Newton's iteration */
+#ifndef SMC_MP_NEWTON
+  #define SMC_MP_NEWTON 48
+#endif
+
+/* ===========================================================================
+ * LARGE MULTIPLICATION
+ * =========================================================================== */
+
+/* Spread limbs into 16-bit coefficients, zero-padded to len */
+SMC_INLINE void smc_ntt_load16(uint64_t *f, size_t len, const uint64_t *a, size_t an) {
+    for (size_t i = 0; i < an; i++) {
+        uint64_t x = a[i];
+        f[4 * i] = x & 0xFFFF;
+        f[4 * i + 1] = (x >> 16) & 0xFFFF;
+        f[4 * i + 2] = (x >> 32) & 0xFFFF;
+        f[4 * i + 3] = x >> 48;
+    }
+    memset(f + 4 * an, 0, (len - 4 * an) * sizeof(uint64_t));
+}
+
+/*
+ * r = a * b (an + bn limbs) by NTT convolution of 16-bit digits; a == b
+ * squares with one forward transform. Coefficient sums stay below
+ * 2^32 * 2^28 < P up to 2^29 digits. Returns false on allocation failure
+ * or beyond that size.
+ */
+SMC_API bool smc_mpn_mul_ntt(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn,
+                             unsigned threads) {
+    const uint64_t P = SMC_NTT_P;
+    unsigned lg = 1;
+    while (((size_t)1 << lg) < 4 * (an + bn)) lg++;
+    if (lg > 29) return false;
+    size_t len = (size_t)1 << lg;
+    bool sqr = a == b && an == bn;
+    uint64_t *fa = (uint64_t *)malloc((sqr ? 1 : 2) * len * sizeof(uint64_t));
+    if (fa == NULL) return false;
+    uint64_t *fb = sqr ? fa : fa + len;
+    smc_ntt_load16(fa, len, a, an);
+    smc_ntt(fa, lg, false, threads);
+    if (!sqr) {
+        smc_ntt_load16(fb, len, b, bn);
+        smc_ntt(fb, lg, false, threads);
+    }
+    /* Plain digits are Montgomery forms of digit / R: each product needs an extra R */
+    uint64_t n_inv = smc_mont_inv64(P), r2 = smc_to_mont64(smc_mont_one64(P), P);
+    for (size_t i = 0; i < len; i++)
+        fa[i] = smc_mont_mul64(smc_mont_mul64(fa[i], fb[i], P, n_inv), r2, P, n_inv);
+    smc_ntt(fa, lg, true, threads);
+
+    uint64_t cy = 0;
+    for (size_t i = 0; i < an + bn; i++) {
+        uint64_t limb = 0;
+        for (unsigned t = 0; t < 4; t++) {
+            uint64_t x = fa[4 * i + t] + cy;
+            limb |= (x & 0xFFFF) << (16 * t);
+            cy = x >> 16;
+        }
+        r[i] = limb;
+    }
+    free(fa);
+    return true;
+}
+
+/*
+ * r = a * b (an + bn limbs, either operand larger; r must not overlap):
+ * smc_mpn_mul below SMC_MP_NTT limbs, the NTT above. a == b squares.
+ */
+SMC_API void smc_mpn_mul_big(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn,
+                             unsigned threads) {
+    if (an < bn) {
+        const uint64_t *t = a; a = b; b = t;
+        size_t tn = an; an = bn; bn = tn;
+    }
+    if (bn >= SMC_MP_NTT && smc_mpn_mul_ntt(r, a, an, b, bn, threads)) return;
+    if (a == b && an == bn) smc_mpn_sqr(r, a, an);
+    else smc_mpn_mul(r, a, an, b, bn);
+}
+
+/* ===========================================================================
+ * RECIPROCAL
+ * =========================================================================== */
+
+/*
+ * I = floor(B^2k / m) (k + 1 limbs, B = 2^64) for k-limb m with its top bit
+ * set. Newton's step from the reciprocal of m's top half plus one, which
+ * stays below the true value, then an exact correction of a few units.
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_mpn_invert(uint64_t *I, const uint64_t *m, size_t k, unsigned threads) {
+    if (k < SMC_MP_NEWTON) {
+        uint64_t *num = (uint64_t *)calloc(2 * k + 1 + k + 2, sizeof(uint64_t));
+        if (num == NULL) return false;
+        uint64_t *q = num + 2 * k + 1;
+        num[2 * k] = 1;
+        bool ok = smc_mpn_divrem(q, NULL, num, 2 * k + 1, m, k);
+        memcpy(I, q, (k + 1) * sizeof(uint64_t));
+        free(num);
+        return ok;
+    }
+    size_t h = (k + 1) / 2, l = k - h;
+    size_t en_cap = k + h + 1;
+    uint64_t *buf = (uint64_t *)calloc(2 * (h + 1) + en_cap + (h + 1 + en_cap) + (2 * k + 3) + 2 * k + 2,
+                                       sizeof(uint64_t));
+    if (buf == NULL) return false;
+    uint64_t *mt = buf, *ih = mt + h + 1, *e = ih + h + 1, *t = e + en_cap, *e1 = t + h + 1 + en_cap;
+    uint64_t *md = e1 + 2 * k + 3;
+
+    /* ih = floor(B^2h / (top + 1)) <= B^2k / m, so E below is positive */
+    if (smc_mpn_add_1(mt, m + l, h, 1)) {
+        ih[h] = 1;
+    } else if (!smc_mpn_invert(ih, mt, h, threads)) {
+        free(buf);
+        return false;
+    }
+    size_t ihn = smc_mpn_normalize(ih, h + 1);
+
+    /* E = B^(k+h) - m * ih, below 3 B^k */
+    smc_mpn_mul_big(e, m, k, ih, ihn, threads);
+    for (size_t i = 0; i < k + h; i++) e[i] = ~e[i];
+    smc_mpn_add_1(e, e, k + h, 1);
+    e[k + h] = 0;
+    size_t en = smc_mpn_normalize(e, k + h);
+
+    /* X = ih * B^l + d with d = floor(ih * E / B^2h), still <= B^2k / m */
+    memset(I, 0, (k + 1) * sizeof(uint64_t));
+    memcpy(I + l, ih, ihn * sizeof(uint64_t));
+    size_t dn = 0;
+    uint64_t *d = t + 2 * h;
+    if (en > 0) {
+        smc_mpn_mul_big(t, ih, ihn, e, en, threads);
+        dn = ihn + en > 2 * h ? smc_mpn_normalize(d, ihn + en - 2 * h) : 0;
+        if (dn > 0) smc_mpn_add(I, I, k + 1, d, dn);
+    }
+
+    /* E1 = B^2k - m * X = E * B^l - m * d; add back the few missing units */
+    size_t e1n = l + en > k + dn ? l + en : k + dn;
+    memcpy(e1 + l, e, en * sizeof(uint64_t));
+    if (dn > 0) {
+        smc_mpn_mul_big(md, m, k, d, dn, threads);
+        smc_mpn_sub(e1, e1, e1n, md, smc_mpn_normalize(md, k + dn));
+    }
+    e1n = smc_mpn_normalize(e1, e1n);
+    while (e1n > k || (e1n == k && smc_mpn_cmp(e1, m, k) >= 0)) {
+        smc_mpn_sub(e1, e1, e1n, m, k);
+        e1n = smc_mpn_normalize(e1, e1n);
+        smc_mpn_add_1(I, I, k + 1, 1);
+    }
+    free(buf);
+    return true;
+}
+
+/* ===========================================================================
+ * BATCH GCD
+ *
+ * Scaled remainder tree: instead of R = X mod x^2 each node keeps the
+ * fraction y = frac(X / x^2) as a (2 * slot + 1)-limb fixed-point number,
+ * slot being the node's limb capacity. A child c with sibling s has
+ * y_c = frac(y_parent * s^2), one truncated product; floors keep every
+ * y below the truth by a few units of its last limb, so at a leaf
+ * X mod x^2 = y * x^2 is recovered by rounding.
+ * =========================================================================== */
+
+/* Receives modulus index and g = gcd(x_index, product of the others) != 1 */
+typedef void (*smc_batch_gcd_fn)(void *ctx, size_t index, const uint64_t *g, size_t gn);
+
+/* One tree level: node i occupies limbs[off[i] .. off[i + 1]), maybe with leading zeros */
+typedef struct smc_bgcd_level {
+    uint64_t *limbs;
+    size_t *off;
+    size_t count;
+} smc_bgcd_level;
+
+enum { SMC_BGCD_PRODUCT, SMC_BGCD_SCALED, SMC_BGCD_LEAF };
+
+typedef struct smc_bgcd_job {
+    const smc_bgcd_level *src;      /* product tree level being read */
+    const smc_bgcd_level *parent;   /* fractions of the level above (SCALED, LEAF) */
+    smc_bgcd_level *dst;            /* level being written */
+    size_t *gn;                     /* LEAF: gcd limb counts */
+    size_t count, per_task;
+    unsigned inner;                 /* threads inside each node's arithmetic */
+    int op;
+    volatile uint64_t failed;
+} smc_bgcd_job;
+
+SMC_INLINE void smc_bgcd_level_free(smc_bgcd_level *L) {
+    free(L->limbs);
+    free(L->off);
+    memset(L, 0, sizeof(*L));
+}
+
+/* Allocate a level's offsets; smc_bgcd_level_limbs then sizes it from off[count] */
+SMC_API bool smc_bgcd_level_alloc(smc_bgcd_level *L, size_t count) {
+    L->count = count;
+    L->limbs = NULL;
+    L->off = (size_t *)malloc((count + 1) * sizeof(size_t));
+    return L->off != NULL;
+}
+
+SMC_API bool smc_bgcd_level_limbs(smc_bgcd_level *L) {
+    L->limbs = (uint64_t *)calloc(L->off[L->count] ? L->off[L->count] : 1, sizeof(uint64_t));
+    return L->limbs != NULL;
+}
+
+/* Node i of a fraction level from the level above: y = frac(y_parent * sibling^2) */
+SMC_API bool smc_bgcd_scale(const smc_bgcd_job *job, size_t i, uint64_t *y) {
+    const smc_bgcd_level *S = job->src, *Y = job->parent;
+    size_t wp = Y->off[i / 2 + 1] - Y->off[i / 2], w = 2 * (S->off[i + 1] - S->off[i]) + 1;
+    const uint64_t *yp = Y->limbs + Y->off[i / 2];
+    size_t sib = i ^ 1;
+    if (sib >= S->count) {
+        memcpy(y, yp, w * sizeof(uint64_t));   /* only child: same node */
+        return true;
+    }
+    const uint64_t *x = S->limbs + S->off[sib];
+    size_t xn = smc_mpn_normalize(x, S->off[sib + 1] - S->off[sib]);
+    size_t ypn = smc_mpn_normalize(yp, wp);
+    memset(y, 0, w * sizeof(uint64_t));
+    if (ypn == 0) return true;
+    uint64_t *sq = (uint64_t *)malloc((2 * xn + ypn + 2 * xn) * sizeof(uint64_t));
+    if (sq == NULL) return false;
+    uint64_t *t = sq + 2 * xn;
+    smc_mpn_mul_big(sq, x, xn, x, xn, job->inner);
+    size_t sqn = smc_mpn_normalize(sq, 2 * xn), tn = ypn + sqn;
+    smc_mpn_mul_big(t, yp, ypn, sq, sqn, job->inner);
+    /* Keep limbs [wp - w, wp): drop the low part, and the integer part above */
+    size_t lo = wp - w;
+    if (tn > lo) memcpy(y, t + lo, (tn - lo < w ? tn - lo : w) * sizeof(uint64_t));
+    free(sq);
+    return true;
+}
+
+/* gcd(x, (X mod x^2) / x) for leaf i, with X mod x^2 = round(y * x^2) */
+SMC_API bool smc_bgcd_leaf(const smc_bgcd_job *job, size_t i, const uint64_t *y, size_t w) {
+    const smc_bgcd_level *S = job->src;
+    const uint64_t *x = S->limbs + S->off[i];
+    size_t xn = smc_mpn_normalize(x, S->off[i + 1] - S->off[i]), yn = smc_mpn_normalize(y, w);
+    uint64_t *g = job->dst->limbs + job->dst->off[i];
+    uint64_t *buf = (uint64_t *)calloc(2 * xn + (w + 2 * xn + 1) + xn + 2, sizeof(uint64_t));
+    if (buf == NULL) return false;
+    uint64_t *sq = buf, *t = sq + 2 * xn, *q = t + w + 2 * xn + 1;
+    smc_mpn_mul_big(sq, x, xn, x, xn, job->inner);
+    size_t sqn = smc_mpn_normalize(sq, 2 * xn), zn = 0;
+    uint64_t *z = t + w;
+    if (yn > 0) {
+        smc_mpn_mul_big(t, y, yn, sq, sqn, job->inner);
+        if (t[w - 1] >> 63) smc_mpn_add_1(z, z, sqn + 1, 1);
+        zn = smc_mpn_normalize(z, sqn + 1);
+        if (zn == sqn && smc_mpn_cmp(z, sq, sqn) == 0) zn = 0;   /* rounded up to x^2 */
+    }
+    bool ok = true;
+    if (zn == 0) {
+        /* x^2 divides the product: every prime of x occurs elsewhere */
+        memcpy(g, x, xn * sizeof(uint64_t));
+        job->gn[i] = xn;
+    } else {
+        ok = smc_mpn_divrem(q, NULL, z, zn, x, xn);
+        size_t gn = ok ? smc_mpn_gcd(g, x, xn, q, zn - xn + 1) : 0;
+        job->gn[i] = gn;
+        ok = ok && gn > 0;
+    }
+    free(buf);
+    return ok;
+}
+
+SMC_API bool smc_bgcd_node(smc_bgcd_job *job, size_t i) {
+    const smc_bgcd_level *S = job->src;
+    smc_bgcd_level *D = job->dst;
+    if (job->op == SMC_BGCD_PRODUCT) {
+        const uint64_t *a = S->limbs + S->off[2 * i];
+        size_t an = smc_mpn_normalize(a, S->off[2 * i + 1] - S->off[2 * i]);
+        uint64_t *r = D->limbs + D->off[i];
+        if (2 * i + 1 == S->count) {
+            memcpy(r, a, an * sizeof(uint64_t));
+            return true;
+        }
+        const uint64_t *b = S->limbs + S->off[2 * i + 1];
+        size_t bn = smc_mpn_normalize(b, S->off[2 * i + 2] - S->off[2 * i + 1]);
+        smc_mpn_mul_big(r, a, an, b, bn, job->inner);
+        return true;
+    }
+    if (job->op == SMC_BGCD_SCALED) return smc_bgcd_scale(job, i, D->limbs + D->off[i]);
+
+    size_t w = 2 * (S->off[i + 1] - S->off[i]) + 1;
+    uint64_t *y = (uint64_t *)malloc(w * sizeof(uint64_t));
+    bool ok = y != NULL && smc_bgcd_scale(job, i, y) && smc_bgcd_leaf(job, i, y, w);
+    free(y);
+    return ok;
+}
+
+SMC_API void smc_bgcd_task(void *ctx, size_t t) {
+    smc_bgcd_job *job = (smc_bgcd_job *)ctx;
+    size_t end = (t + 1) * job->per_task < job->count ? (t + 1) * job->per_task : job->count;
+    for (size_t i = t * job->per_task; i < end; i++)
+        if (!smc_bgcd_node(job, i)) smc_atomic_store64(&job->failed, 1);
+}
+
+/* Run every node of a level: over threads when there are enough nodes, else one by one */
+SMC_API bool smc_bgcd_level_run(smc_bgcd_job *job, size_t count, unsigned threads) {
+    job->count = count;
+    job->failed = 0;
+    if (threads > 1 && count >= threads) {
+        size_t tasks = count < 8 * (size_t)threads ? count : 8 * (size_t)threads;
+        job->inner = 1;
+        job->per_task = (count + tasks - 1) / tasks;
+        if (!smc_parallel_for((count + job->per_task - 1) / job->per_task, threads, smc_bgcd_task, job))
+            return false;
+    } else {
+        job->inner = threads;
+        job->per_task = count;
+        smc_bgcd_task(job, 0);
+    }
+    return smc_atomic_load64(&job->failed) == 0;
+}
+
+/* Fraction level of the root: y = 1 / P to 2 * slot + 1 limbs, from one reciprocal */
+SMC_API bool smc_bgcd_root(smc_bgcd_level *Y, const smc_bgcd_level *P, unsigned threads) {
+    size_t w = 2 * P->off[1] + 1, pn = smc_mpn_normalize(P->limbs, P->off[1]);
+    if (!smc_bgcd_level_alloc(Y, 1)) return false;
+    Y->off[0] = 0;
+    Y->off[1] = w;
+    if (!smc_bgcd_level_limbs(Y)) return false;
+    if (pn == 1 && P->limbs[0] == 1) return true;   /* frac(1 / 1) = 0 */
+
+    /* I = floor(B^(w+1) / (P 2^s)) from m = P 2^s B^(k-pn); y = floor(I 2^s / B) */
+    size_t k = w - pn + 1;
+    uint64_t *m = (uint64_t *)calloc(k + k + 2, sizeof(uint64_t));
+    if (m == NULL) return false;
+    uint64_t *I = m + k;
+    unsigned s = (unsigned)smc_clz64(P->limbs[pn - 1]);
+    if (s) smc_mpn_lshift(m + k - pn, P->limbs, pn, s);
+    else memcpy(m + k - pn, P->limbs, pn * sizeof(uint64_t));
+    bool ok = smc_mpn_invert(I, m, k, threads);
+    if (ok) {
+        I[k + 1] = s ? smc_mpn_lshift(I, I, k + 1, s) : 0;
+        memcpy(Y->limbs, I + 1, (k + 1 < w ? k + 1 : w) * sizeof(uint64_t));
+    }
+    free(m);
+    return ok;
+}
+
+/*
+ * For each of count nonzero moduli x_i, computes
+ * g = gcd(x_i, prod_{j != i} x_j) and calls fn(ctx, i, g, gn) for every
+ * g != 1, in index order. Modulus i is limbs[offset[i] .. offset[i + 1]),
+ * or the single limb limbs[i] when offset is NULL. A modulus that equals
+ * another, or whose primes all occur elsewhere, reports g = x_i.
+ *
+ * Memory is about (log2(count) + 6) times the input; threads = 0 uses
+ * every core. fn runs on the calling thread once every gcd is known.
+ * Returns false on allocation failure, before any call to fn.
+ */
+SMC_API bool smc_batch_gcd(const uint64_t *limbs, const size_t *offset, size_t count, unsigned threads,
+                           smc_batch_gcd_fn fn, void *ctx) {
+    if (count < 2) return true;
+    if (threads == 0) threads = smc_thread_count();
+    unsigned depth = 1;
+    while (((size_t)1 << (depth - 1)) < count) depth++;
+    smc_bgcd_level *prod = (smc_bgcd_level *)calloc(2 * (size_t)depth, sizeof(smc_bgcd_level));
+    size_t *gn = (size_t *)malloc(count * sizeof(size_t));
+    if (prod == NULL || gn == NULL) { free(prod); free(gn); return false; }
+    smc_bgcd_level *frac = prod + depth, out = { NULL, NULL, 0 };
+    smc_bgcd_job job;
+    memset(&job, 0, sizeof(job));
+    bool ok = smc_bgcd_level_alloc(&prod[0], count);
+
+    /* Leaves: normalized copies, zero moduli replaced by 1 */
+    if (ok) {
+        prod[0].off[0] = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t n = offset ? smc_mpn_normalize(limbs + offset[i], offset[i + 1] - offset[i]) : 1;
+            prod[0].off[i + 1] = prod[0].off[i] + (n ? n : 1);
+        }
+        ok = smc_bgcd_level_limbs(&prod[0]);
+    }
+    if (ok) {
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t *x = offset ? limbs + offset[i] : limbs + i;
+            size_t n = offset ? smc_mpn_normalize(x, offset[i + 1] - offset[i]) : (x[0] != 0);
+            if (n == 0) prod[0].limbs[prod[0].off[i]] = 1;
+            else memcpy(prod[0].limbs + prod[0].off[i], x, n * sizeof(uint64_t));
+        }
+    }
+
+    /* Product tree, bottom up */
+    job.op = SMC_BGCD_PRODUCT;
+    for (unsigned j = 1; ok && j < depth; j++) {
+        size_t n = (prod[j - 1].count + 1) / 2;
+        ok = smc_bgcd_level_alloc(&prod[j], n);
+        if (!ok) break;
+        prod[j].off[0] = 0;
+        for (size_t i = 0; i < n; i++) {
+            size_t hi = 2 * i + 2 < prod[j - 1].count ? 2 * i + 2 : prod[j - 1].count;
+            prod[j].off[i + 1] = prod[j].off[i] + prod[j - 1].off[hi] - prod[j - 1].off[2 * i];
+        }
+        ok = smc_bgcd_level_limbs(&prod[j]);
+        job.src = &prod[j - 1];
+        job.dst = &prod[j];
+        ok = ok && smc_bgcd_level_run(&job, n, threads);
+    }
+
+    /* Scaled remainder tree, top down; each level frees the two above it */
+    ok = ok && smc_bgcd_root(&frac[depth - 1], &prod[depth - 1], threads);
+    job.op = SMC_BGCD_SCALED;
+    for (unsigned j = depth - 1; ok && j-- > 1;) {
+        size_t n = prod[j].count;
+        ok = smc_bgcd_level_alloc(&frac[j], n);
+        if (!ok) break;
+        frac[j].off[0] = 0;
+        for (size_t i = 0; i < n; i++)
+            frac[j].off[i + 1] = frac[j].off[i] + 2 * (prod[j].off[i + 1] - prod[j].off[i]) + 1;
+        ok = smc_bgcd_level_limbs(&frac[j]);
+        job.src = &prod[j];
+        job.parent = &frac[j + 1];
+        job.dst = &frac[j];
+        ok = ok && smc_bgcd_level_run(&job, n, threads);
+        smc_bgcd_level_free(&frac[j + 1]);
+        smc_bgcd_level_free(&prod[j + 1]);
+    }
+
+    /* Leaves: gcds into an arena shaped like the input */
+    if (ok) ok = smc_bgcd_level_alloc(&out, count);
+    if (ok) {
+        memcpy(out.off, prod[0].off, (count + 1) * sizeof(size_t));
+        ok = smc_bgcd_level_limbs(&out);
+    }
+    if (ok) {
+        job.op = SMC_BGCD_LEAF;
+        job.src = &prod[0];
+        job.parent = &frac[1];
+        job.dst = &out;
+        job.gn = gn;
+        ok = smc_bgcd_level_run(&job, count, threads);
+    }
+    if (ok) {
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t *g = out.limbs + out.off[i];
+            if (gn[i] > 1 || g[0] != 1) fn(ctx, i, g, gn[i]);
+        }
+    }
+    for (unsigned j = 0; j < 2 * depth; j++) smc_bgcd_level_free(&prod[j]);
+    smc_bgcd_level_free(&out);
+    free(prod);
+    free(gn);
+    return ok;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_BATCHGCD_H */
@@ -0,0 +1,343 @@
+/*
+ * smcPrime - Persistent Sieving-Prime Cache
+ *
+ * A range sieve near 2^64 needs every prime up to 2^32 (203M of them),
+ * which takes seconds to regenerate in each short-lived process. This
+ * header keeps them in a file that is mapped instead:
+ * - One byte per odd prime: half the gap to its predecessor (gaps below
+ *   2^32 are at most 336)
+ * - An absolute 32-bit anchor every SMC_PRIME_CACHE_STRIDE primes, so any
+ *   prime is reachable by a short scan
+ * - A checksum over header and payload, verified on open
+ *
+ * smc_prime_cache_default() opens the cache on first use and builds it
+ * if it is missing or invalid, once per process even when called from
+ * several threads. The file is written to a temporary name and renamed
+ * into place, so concurrent processes never see a partial cache.
+ * smc_sieve_init_cached() is smc_sieve_init with its primes taken from it.
+ *
+ * The default cache lives in SMC_PRIME_CACHE (environment) or else
+ * smcprime-primes32.cache in the per-user cache directory, never in a
+ * shared temporary one: the checksum is not a signature, so the default
+ * cache is only used if no other user could have written it. Its state is
+ * per translation unit, like every header-only function here. Files use
+ * the host byte order.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_CACHE_H
+#define SMCPRIME_CACHE_H
+
+#include "smcprime.h"
+#include "smcprime_pi.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Primes per absolute anchor */
+#ifndef SMC_PRIME_CACHE_STRIDE
+  #define SMC_PRIME_CACHE_STRIDE 65536
+#endif
+
+/* smc_sieve_init_cached sieves its own primes below this root */
+#ifndef SMC_PRIME_CACHE_MIN_ROOT
+  #define SMC_PRIME_CACHE_MIN_ROOT (1u << 22)
+#endif
+
+#define SMC_PRIME_CACHE_MAGIC 0x3130504743434D53ULL   /* "SMCCGP01" */
+
+typedef struct smc_prime_cache {
+    uint32_t limit;             /* every odd prime <= limit is stored */
+    uint32_t stride;            /* primes per anchor */
+    uint64_t count;             /* odd primes stored, 3 first */
+    const uint32_t *anchor;     /* anchor[k] = prime number k * stride */
+    const uint8_t *gap;         /* gap[i] = (p_i - p_{i-1}) / 2, gap[0] = 0 */
+    const void *map;
+    size_t map_len;
+} smc_prime_cache;
+
+/* On-disk header; anchors follow, padded to 8 bytes, then the gaps */
+typedef struct smc_prime_cache_header {
+    uint64_t magic;
+    uint64_t limit;
+    uint64_t count;
+    uint64_t stride;
+    uint64_t anchors;
+    uint64_t checksum;          /* smc_prime_cache_hash of the rest */
+} smc_prime_cache_header;
+
+/* ===========================================================================
+ * FORMAT
+ * =========================================================================== */
+
+/* Multiply-xor hash over four independent lanes, so it runs near memory speed */
+SMC_API uint64_t smc_prime_cache_hash(uint64_t seed, const void *data, size_t len) {
+    const uint64_t k = 0x9E3779B97F4A7C15ULL;
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h[4] = {seed, seed ^ 1, seed ^ 2, seed ^ 3};
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        for (int j = 0; j < 4; j++) {
+            uint64_t w;
+            memcpy(&w, p + i + 8 * j, 8);
+            h[j] = (h[j] ^ w) * k;
+            h[j] ^= h[j] >> 29;
+        }
+    }
+    uint64_t r = len;
+    for (int j = 0; j < 4; j++) r = (r ^ h[j]) * k;
+    for (; i < len; i++) r = (r ^ p[i]) * k;
+    return r ^ (r >> 32);
+}
+
+SMC_INLINE size_t smc_prime_cache_anchor_bytes(uint64_t anchors) {
+    return (size_t)(anchors * 4 + 7) & ~(size_t)7;
+}
+
+SMC_INLINE uint64_t smc_prime_cache_sum(const smc_prime_cache_header *h, const void *body,
+                                        size_t len) {
+    uint64_t seed = h->limit ^ (h->count << 32) ^ (h->stride << 16) ^ h->anchors;
+    return smc_prime_cache_hash(seed, body, len);
+}
+
+/*
+ * Write a cache of the odd primes <= limit to path: sieved in segments
+ * into memory (one byte per prime), written to a new path.<pid>.tmp
+ * (created exclusively, owner-only, never through a symlink) and renamed
+ * over path. Returns false on allocation or I/O failure, or if the
+ * temporary name is taken.
+ */
+SMC_API bool smc_prime_cache_write(const char *path, uint32_t limit) {
+    uint64_t cap = smc_pi_upper(limit) + 1;
+    uint64_t anchors = cap / SMC_PRIME_CACHE_STRIDE + 1;
+    size_t abytes = smc_prime_cache_anchor_bytes(anchors);
+    const size_t hbytes = sizeof(smc_prime_cache_header);
+    uint8_t *file = (uint8_t *)calloc(hbytes + abytes + (size_t)cap, 1);
+    if (file == NULL) return false;
+    uint8_t *body = file + hbytes;
+    uint32_t *anchor = (uint32_t *)body;
+    uint8_t *gap = body + abytes;
+
+    uint64_t n = 0, prev = 3;
+    smc_sieve s;
+    if (limit >= 3) {
+        if (!smc_sieve_init(&s, 3, (uint64_t)limit + 1)) { free(file); return false; }
+        while (smc_sieve_next(&s)) {
+            size_t words = (s.seg_bits + 63) / 64;
+            for (size_t w = 0; w < words; w++) {
+                for (uint64_t m = s.bits[w]; m; m &= m - 1) {
+                    uint64_t p = s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m));
+                    if (n % SMC_PRIME_CACHE_STRIDE == 0) anchor[n / SMC_PRIME_CACHE_STRIDE] = (uint32_t)p;
+                    gap[n++] = (uint8_t)((p - prev) / 2);
+                    prev = p;
+                }
+            }
+        }
+        smc_sieve_free(&s);
+    }
+
+    smc_prime_cache_header h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SMC_PRIME_CACHE_MAGIC;
+    h.limit = limit;
+    h.count = n;
+    h.stride = SMC_PRIME_CACHE_STRIDE;
+    h.anchors = (n + SMC_PRIME_CACHE_STRIDE - 1) / SMC_PRIME_CACHE_STRIDE;
+    /* Move the gaps down against the anchors actually used */
+    size_t used = smc_prime_cache_anchor_bytes(h.anchors);
+    memmove(body + used, gap, (size_t)n);
+    size_t len = used + (size_t)n;
+    h.checksum = smc_prime_cache_sum(&h, body, len);
+    memcpy(file, &h, hbytes);
+
+    size_t plen = strlen(path);
+    char *tmp = (char *)malloc(plen + 32);
+    if (tmp == NULL) { free(file); return false; }
+    snprintf(tmp, plen + 32, "%s.%lu.tmp", path, smc_process_id());
+    bool ok = smc_write_new_file(tmp, file, hbytes + len);
+    if (ok && !smc_replace_file(tmp, path)) {
+        remove(tmp);
+        ok = false;
+    }
+    free(tmp);
+    free(file);
+    return ok;
+}
+
+/* Validate a mapped cache file and point c into it; unmaps it and returns false if invalid */
+SMC_API bool smc_prime_cache_adopt(smc_prime_cache *c, const void *map, size_t len) {
+    memset(c, 0, sizeof(*c));
+    if (map == NULL) return false;
+    const smc_prime_cache_header *h = (const smc_prime_cache_header *)map;
+    const uint8_t *body = (const uint8_t *)(h + 1);
+    bool ok = len >= sizeof(*h) && h->magic == SMC_PRIME_CACHE_MAGIC
+        && h->limit <= UINT32_MAX && h->stride > 0 && h->stride <= UINT32_MAX
+        && h->count <= h->limit / 2
+        && h->anchors == (h->count + h->stride - 1) / h->stride
+        && len == sizeof(*h) + smc_prime_cache_anchor_bytes(h->anchors) + h->count
+        && h->checksum == smc_prime_cache_sum(h, body, len - sizeof(*h));
+    if (!ok) {
+        smc_unmap_file(map, len);
+        return false;
+    }
+    c->limit = (uint32_t)h->limit;
+    c->stride = (uint32_t)h->stride;
+    c->count = h->count;
+    c->anchor = (const uint32_t *)body;
+    c->gap = body + smc_prime_cache_anchor_bytes(h->anchors);
+    c->map = map;
+    c->map_len = len;
+    return true;
+}
+
+/* Map a cache written by smc_prime_cache_write. Returns false if missing or invalid. */
+SMC_API bool smc_prime_cache_open(smc_prime_cache *c, const char *path) {
+    size_t len = 0;
+    const void *map = smc_map_file(path, &len);
+    return smc_prime_cache_adopt(c, map, len);
+}
+
+/*
+ * smc_prime_cache_open for a file that must not be writable by other
+ * users (smc_map_private_file): the checksum only catches corruption, not
+ * a cache planted by someone else.
+ */
+SMC_API bool smc_prime_cache_open_private(smc_prime_cache *c, const char *path) {
+    size_t len = 0;
+    const void *map = smc_map_private_file(path, &len);
+    return smc_prime_cache_adopt(c, map, len);
+}
+
+SMC_API void smc_prime_cache_close(smc_prime_cache *c) {
+    smc_unmap_file(c->map, c->map_len);
+    memset(c, 0, sizeof(*c));
+}
+
+/* ===========================================================================
+ * ACCESS
+ * =========================================================================== */
+
+/* Odd prime number i (0 -> 3) for i < count: anchor plus at most stride gaps */
+SMC_API uint32_t smc_prime_cache_nth(const smc_prime_cache *c, uint64_t i) {
+    uint64_t k = i / c->stride;
+    uint32_t p = c->anchor[k];
+    for (uint64_t j = k * c->stride + 1; j <= i; j++) p += 2u * c->gap[j];
+    return p;
+}
+
+/*
+ * The odd primes <= limit (at most the cache limit) as a malloc'd array,
+ * the form smc_sieve_init_with takes. Returns NULL on allocation failure.
+ */
+SMC_API uint32_t *smc_prime_cache_primes(const smc_prime_cache *c, uint32_t limit, size_t *count) {
+    *count = 0;
+    if (limit > c->limit) limit = c->limit;
+    /* Count first: last anchor <= limit, then a scan of its block */
+    uint64_t n = 0;
+    if (c->count > 0 && limit >= 3) {
+        uint64_t a = 0, b = (c->count - 1) / c->stride;
+        while (a < b) {
+            uint64_t mid = (a + b + 1) / 2;
+            if (c->anchor[mid] <= limit) a = mid; else b = mid - 1;
+        }
+        uint32_t p = c->anchor[a];
+        for (n = a * c->stride + 1; n < c->count && p + 2u * c->gap[n] <= limit; n++)
+            p += 2u * c->gap[n];
+    }
+    uint32_t *out = (uint32_t *)malloc((n ? (size_t)n : 1) * sizeof(uint32_t));
+    if (out == NULL) return NULL;
+    uint32_t p = 3;
+    for (size_t i = 0; i < (size_t)n; i++) out[i] = p += 2u * c->gap[i];
+    *count = (size_t)n;
+    return out;
+}
+
+/* ===========================================================================
+ * DEFAULT CACHE
+ * =========================================================================== */
+
+typedef struct smc_prime_cache_state {
+    smc_prime_cache cache;
+    bool ok;
+} smc_prime_cache_state;
+
+/*
+ * Path of the default cache into buf: $SMC_PRIME_CACHE, else
+ * smcprime-primes32.cache in the per-user cache directory
+ * ($XDG_CACHE_HOME or ~/.cache, %LOCALAPPDATA% on Windows), which is
+ * created if missing. Returns false if there is no such directory.
+ */
+SMC_API bool smc_prime_cache_default_path(char *buf, size_t size) {
+    const char *path = getenv("SMC_PRIME_CACHE");
+    if (path != NULL && path[0] != 0) return (size_t)snprintf(buf, size, "%s", path) < size;
+#if defined(_WIN32)
+    const char *dir = getenv("LOCALAPPDATA");
+    if (dir == NULL || dir[0] == 0) return false;
+    return (size_t)snprintf(buf, size, "%s\\smcprime-primes32.cache", dir) < size;
+#else
+    const char *xdg = getenv("XDG_CACHE_HOME"), *home = getenv("HOME");
+    int n;
+    if (xdg != NULL && xdg[0] == '/') n = snprintf(buf, size, "%s", xdg);
+    else if (home != NULL && home[0] == '/') n = snprintf(buf, size, "%s/.cache", home);
+    else return false;
+    if (n < 0 || (size_t)n >= size) return false;
+    mkdir(buf, 0700);
+    return (size_t)snprintf(buf + n, size - (size_t)n, "/smcprime-primes32.cache") < size - (size_t)n;
+#endif
+}
+
+SMC_API void smc_prime_cache_init_default(void *ctx) {
+    smc_prime_cache_state *st = (smc_prime_cache_state *)ctx;
+    char path[4096];
+    st->ok = false;
+    if (!smc_prime_cache_default_path(path, sizeof(path))) return;
+    st->ok = smc_prime_cache_open_private(&st->cache, path)
+        && st->cache.limit == UINT32_MAX;
+    if (!st->ok) {
+        if (st->cache.map) smc_prime_cache_close(&st->cache);
+        st->ok = smc_prime_cache_write(path, UINT32_MAX)
+            && smc_prime_cache_open_private(&st->cache, path);
+    }
+}
+
+/*
+ * The cache of all odd primes below 2^32, opened (and if necessary built,
+ * a few seconds) on the first call. Returns NULL if it can be neither
+ * read nor written. Thread-safe; the mapping lives until exit.
+ */
+SMC_API const smc_prime_cache *smc_prime_cache_default(void) {
+    static volatile uint64_t once = SMC_ONCE_INIT;
+    static smc_prime_cache_state st;
+    smc_once(&once, smc_prime_cache_init_default, &st);
+    return st.ok ? &st.cache : NULL;
+}
+
+/*
+ * smc_sieve_init with the sieving primes decoded from the default cache
+ * when hi needs primes above SMC_PRIME_CACHE_MIN_ROOT; falls back to
+ * sieving them if the cache is unavailable.
+ */
+SMC_API bool smc_sieve_init_cached(smc_sieve *s, uint64_t lo, uint64_t hi) {
+    if (hi <= (lo | 1) || smc_isqrt64(hi - 1) < SMC_PRIME_CACHE_MIN_ROOT)
+        return smc_sieve_init(s, lo, hi);
+    const smc_prime_cache *c = smc_prime_cache_default();
+    if (c == NULL) return smc_sieve_init(s, lo, hi);
+    size_t np = 0;
+    uint32_t *primes = smc_prime_cache_primes(c, (uint32_t)smc_isqrt64(hi - 1), &np);
+    if (primes == NULL) { memset(s, 0, sizeof(*s)); return false; }
+    return smc_sieve_init_with(s, lo, hi, primes, np);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_CACHE_H */
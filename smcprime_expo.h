@@ -0,0 +1,273 @@
+/*
+ * smcPrime - Fixed-Base Exponentiation
+ *
+ * Many powers of one base modulo one odd modulus (Diffie-Hellman, Pedersen
+ * commitments, ElGamal), in Montgomery form:
+ * - smc_fixbase64_*: g^(d * 2^(i*w)) tabled for every w-bit digit d of
+ *   every exponent window i, so g^e is one multiply per nonzero digit and
+ *   no squarings (Brickell-Gordon-McCurley-Wilson with one row per window)
+ * - smc_mont_pow2_64: g^a h^b for arbitrary g, h by Straus's interleaving
+ *   (Shamir's trick) with a 2-bit joint window: one squaring chain for
+ *   both exponents
+ * - smc_fixbase128_* / smc_mont128_pow2: the same on smc_mont128 (needs
+ *   __int128)
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_EXPO_H
+#define SMCPRIME_EXPO_H
+
+#include "smcprime.h"
+#include "smcprime128.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default digit width: 8 windows of 256 entries (16 KB) for 64-bit exponents */
+#ifndef SMC_FIXBASE_WINDOW
+  #define SMC_FIXBASE_WINDOW 8
+#endif
+
+/* ===========================================================================
+ * 64-BIT FIXED BASE
+ * =========================================================================== */
+
+typedef struct smc_fixbase64 {
+    uint64_t n, n_inv, one;     /* odd modulus, Montgomery constants */
+    uint64_t *table;            /* windows rows of 2^w entries, Montgomery form */
+    uint64_t top;               /* g^(2^(w * windows)): exponent bits past the table */
+    unsigned w, windows;
+} smc_fixbase64;
+
+SMC_API void smc_fixbase64_free(smc_fixbase64 *fb) {
+    free(fb->table);
+    memset(fb, 0, sizeof(*fb));
+}
+
+/*
+ * Table the powers of g modulo odd n > 1 for exponents of up to exp_bits
+ * bits (larger ones still work, at the cost of a generic power for the
+ * excess), with w-bit digits (0 = SMC_FIXBASE_WINDOW, at most 16). Costs
+ * one multiply per table entry, ceil(exp_bits / w) * 2^w entries.
+ * Returns false for bad arguments or on allocation failure.
+ */
+SMC_API bool smc_fixbase64_init(smc_fixbase64 *fb, uint64_t g, uint64_t n, unsigned exp_bits, unsigned w) {
+    memset(fb, 0, sizeof(*fb));
+    if (w == 0) w = SMC_FIXBASE_WINDOW;
+    if (n < 3 || (n & 1) == 0 || w > 16) return false;
+    if (exp_bits == 0 || exp_bits > 64) exp_bits = 64;
+    if (w > exp_bits) w = exp_bits;
+    fb->n = n;
+    fb->n_inv = smc_mont_inv64(n);
+    fb->one = smc_mont_one64(n);
+    fb->w = w;
+    fb->windows = (exp_bits + w - 1) / w;
+    size_t row = (size_t)1 << w;
+    fb->table = (uint64_t *)malloc(fb->windows * row * sizeof(uint64_t));
+    if (fb->table == NULL) return false;
+
+    /* Row i holds b^d for b = g^(2^(i*w)); the next base is b^(2^w) */
+    uint64_t b = smc_to_mont64(g, n);
+    for (unsigned i = 0; i < fb->windows; i++) {
+        uint64_t *t = fb->table + i * row;
+        t[0] = fb->one;
+        t[1] = b;
+        for (size_t d = 2; d < row; d++) t[d] = smc_mont_mul64(t[d - 1], b, n, fb->n_inv);
+        b = smc_mont_mul64(t[row - 1], b, n, fb->n_inv);
+    }
+    fb->top = b;
+    return true;
+}
+
+/* g^e in Montgomery form */
+SMC_INLINE uint64_t smc_fixbase64_pow_mont(const smc_fixbase64 *fb, uint64_t e) {
+    unsigned w = fb->w;
+    uint64_t mask = ((uint64_t)1 << w) - 1;
+    size_t row = (size_t)1 << w;
+    uint64_t x = fb->table[e & mask];
+    for (unsigned i = 1; i < fb->windows; i++) {
+        uint64_t d = (e >> (i * w)) & mask;
+        if (d) x = smc_mont_mul64(x, fb->table[i * row + d], fb->n, fb->n_inv);
+    }
+    unsigned bits = w * fb->windows;
+    if (bits < 64 && (e >> bits) != 0)
+        x = smc_mont_mul64(x, smc_mont_pow64(fb->top, e >> bits, fb->n, fb->n_inv, fb->one), fb->n, fb->n_inv);
+    return x;
+}
+
+/* g^e mod n */
+SMC_INLINE uint64_t smc_fixbase64_pow(const smc_fixbase64 *fb, uint64_t e) {
+    return smc_mont_reduce64(smc_fixbase64_pow_mont(fb, e), 0, fb->n, fb->n_inv);
+}
+
+/* g^a h^b mod n for two tables over the same modulus */
+SMC_INLINE uint64_t smc_fixbase64_pow2(const smc_fixbase64 *fg, uint64_t a, const smc_fixbase64 *fh, uint64_t b) {
+    uint64_t x = smc_mont_mul64(smc_fixbase64_pow_mont(fg, a), smc_fixbase64_pow_mont(fh, b), fg->n, fg->n_inv);
+    return smc_mont_reduce64(x, 0, fg->n, fg->n_inv);
+}
+
+/* ===========================================================================
+ * 64-BIT MULTI-EXPONENTIATION
+ * =========================================================================== */
+
+/*
+ * g^a h^b in Montgomery form (g, h in Montgomery form). The 16 products
+ * g^i h^j (i, j < 4) are built first (12 multiplies), then each 2-bit
+ * digit pair of (a, b) costs two squarings and at most one multiply.
+ */
+SMC_API uint64_t smc_mont_pow2_64(uint64_t g, uint64_t a, uint64_t h, uint64_t b,
+                                  uint64_t n, uint64_t n_inv, uint64_t one) {
+    if ((a | b) == 0) return one;
+    uint64_t t[16];
+    t[0] = one;
+    t[1] = h;
+    t[2] = smc_mont_mul64(h, h, n, n_inv);
+    t[3] = smc_mont_mul64(t[2], h, n, n_inv);
+    t[4] = g;
+    t[8] = smc_mont_mul64(g, g, n, n_inv);
+    t[12] = smc_mont_mul64(t[8], g, n, n_inv);
+    for (int i = 4; i < 16; i += 4)
+        for (int j = 1; j < 4; j++) t[i + j] = smc_mont_mul64(t[i], t[j], n, n_inv);
+
+    int k = (63 - smc_clz64(a | b)) & ~1;
+    uint64_t x = t[(((a >> k) & 3) << 2) | ((b >> k) & 3)];
+    for (k -= 2; k >= 0; k -= 2) {
+        x = smc_mont_mul64(x, x, n, n_inv);
+        x = smc_mont_mul64(x, x, n, n_inv);
+        unsigned d = (unsigned)((((a >> k) & 3) << 2) | ((b >> k) & 3));
+        if (d) x = smc_mont_mul64(x, t[d], n, n_inv);
+    }
+    return x;
+}
+
+/* g^a h^b mod n for odd n > 1 */
+SMC_INLINE uint64_t smc_powmod2_64(uint64_t g, uint64_t a, uint64_t h, uint64_t b, uint64_t n) {
+    uint64_t n_inv = smc_mont_inv64(n);
+    uint64_t x = smc_mont_pow2_64(smc_to_mont64(g, n), a, smc_to_mont64(h, n), b,
+                                  n, n_inv, smc_mont_one64(n));
+    return smc_mont_reduce64(x, 0, n, n_inv);
+}
+
+#if defined(__SIZEOF_INT128__)
+
+/* ===========================================================================
+ * 128-BIT FIXED BASE
+ * =========================================================================== */
+
+typedef struct smc_fixbase128 {
+    smc_mont128 m;
+    smc_u128 *table;            /* windows rows of 2^w entries, Montgomery form */
+    smc_u128 top;               /* g^(2^(w * windows)) */
+    unsigned w, windows;
+} smc_fixbase128;
+
+SMC_API void smc_fixbase128_free(smc_fixbase128 *fb) {
+    free(fb->table);
+    memset(fb, 0, sizeof(*fb));
+}
+
+/* As smc_fixbase64_init, for exponents of up to 128 bits */
+SMC_API bool smc_fixbase128_init(smc_fixbase128 *fb, smc_u128 g, smc_u128 n, unsigned exp_bits, unsigned w) {
+    memset(fb, 0, sizeof(*fb));
+    if (w == 0) w = SMC_FIXBASE_WINDOW;
+    if (n < 3 || (n & 1) == 0 || w > 16) return false;
+    if (exp_bits == 0 || exp_bits > 128) exp_bits = 128;
+    if (w > exp_bits) w = exp_bits;
+    smc_mont128_init(&fb->m, n);
+    fb->w = w;
+    fb->windows = (exp_bits + w - 1) / w;
+    size_t row = (size_t)1 << w;
+    fb->table = (smc_u128 *)malloc(fb->windows * row * sizeof(smc_u128));
+    if (fb->table == NULL) return false;
+
+    smc_u128 b = smc_mont128_to(&fb->m, g);
+    for (unsigned i = 0; i < fb->windows; i++) {
+        smc_u128 *t = fb->table + i * row;
+        t[0] = fb->m.one;
+        t[1] = b;
+        for (size_t d = 2; d < row; d++) t[d] = smc_mont128_mul(&fb->m, t[d - 1], b);
+        b = smc_mont128_mul(&fb->m, t[row - 1], b);
+    }
+    fb->top = b;
+    return true;
+}
+
+/* g^e in Montgomery form */
+SMC_INLINE smc_u128 smc_fixbase128_pow_mont(const smc_fixbase128 *fb, smc_u128 e) {
+    unsigned w = fb->w;
+    uint64_t mask = ((uint64_t)1 << w) - 1;
+    size_t row = (size_t)1 << w;
+    smc_u128 x = fb->table[(uint64_t)e & mask];
+    for (unsigned i = 1; i < fb->windows; i++) {
+        uint64_t d = (uint64_t)(e >> (i * w)) & mask;
+        if (d) x = smc_mont128_mul(&fb->m, x, fb->table[i * row + d]);
+    }
+    unsigned bits = w * fb->windows;
+    if (bits < 128 && (e >> bits) != 0)
+        x = smc_mont128_mul(&fb->m, x, smc_mont128_pow(&fb->m, fb->top, e >> bits));
+    return x;
+}
+
+/* g^e mod n */
+SMC_INLINE smc_u128 smc_fixbase128_pow(const smc_fixbase128 *fb, smc_u128 e) {
+    return smc_mont128_from(&fb->m, smc_fixbase128_pow_mont(fb, e));
+}
+
+/* g^a h^b mod n for two tables over the same modulus */
+SMC_INLINE smc_u128 smc_fixbase128_pow2(const smc_fixbase128 *fg, smc_u128 a, const smc_fixbase128 *fh, smc_u128 b) {
+    smc_u128 x = smc_mont128_mul(&fg->m, smc_fixbase128_pow_mont(fg, a), smc_fixbase128_pow_mont(fh, b));
+    return smc_mont128_from(&fg->m, x);
+}
+
+/* ===========================================================================
+ * 128-BIT MULTI-EXPONENTIATION
+ * =========================================================================== */
+
+/* g^a h^b in Montgomery form, as smc_mont_pow2_64 */
+SMC_API smc_u128 smc_mont128_pow2(const smc_mont128 *m, smc_u128 g, smc_u128 a, smc_u128 h, smc_u128 b) {
+    if ((a | b) == 0) return m->one;
+    smc_u128 t[16];
+    t[0] = m->one;
+    t[1] = h;
+    t[2] = smc_mont128_mul(m, h, h);
+    t[3] = smc_mont128_mul(m, t[2], h);
+    t[4] = g;
+    t[8] = smc_mont128_mul(m, g, g);
+    t[12] = smc_mont128_mul(m, t[8], g);
+    for (int i = 4; i < 16; i += 4)
+        for (int j = 1; j < 4; j++) t[i + j] = smc_mont128_mul(m, t[i], t[j]);
+
+    smc_u128 ab = a | b;
+    uint64_t hi = (uint64_t)(ab >> 64);
+    int k = (hi ? 127 - smc_clz64(hi) : 63 - smc_clz64((uint64_t)ab)) & ~1;
+    smc_u128 x = t[(((unsigned)(a >> k) & 3) << 2) | ((unsigned)(b >> k) & 3)];
+    for (k -= 2; k >= 0; k -= 2) {
+        x = smc_mont128_mul(m, x, x);
+        x = smc_mont128_mul(m, x, x);
+        unsigned d = (((unsigned)(a >> k) & 3) << 2) | ((unsigned)(b >> k) & 3);
+        if (d) x = smc_mont128_mul(m, x, t[d]);
+    }
+    return x;
+}
+
+/* g^a h^b mod n for odd n > 1 */
+SMC_INLINE smc_u128 smc_powmod2_128(smc_u128 g, smc_u128 a, smc_u128 h, smc_u128 b, smc_u128 n) {
+    smc_mont128 m;
+    smc_mont128_init(&m, n);
+    smc_u128 r2 = smc_mont128_r2(&m);
+    smc_u128 x = smc_mont128_pow2(&m, smc_mont128_mul(&m, g % n, r2), a, smc_mont128_mul(&m, h % n, r2), b);
+    return smc_mont128_from(&m, x);
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_EXPO_H */
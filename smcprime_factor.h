@@ -0,0 +1,914 @@
+/*
+ * smcPrime - Integer Factorization
+ *
+ * - Single 64-bit integers: prime-inverse trial division, then Brent's
+ *   variant of Pollard rho in Montgomery form
+ * - Whole windows [lo, hi): a segmented sieve that divides every sieving
+ *   prime out of the entries it hits, leaving at most one cofactor per
+ *   entry, which is prime by construction
+ * - Batches of unrelated integers: trial division, then Brent rho with one
+ *   independent walk per SIMD lane (AVX-512, AVX2 or scalar)
+ *
+ * Window results are stored per chunk as a compact arena: an offset array
+ * plus a flat factor array (counting-sorted from the sieve hits).
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_FACTOR_H
+#define SMCPRIME_FACTOR_H
+
+#include "smcprime.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+  #include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Integers per chunk handed to range-factorization callbacks: sized from
+ * the L2 cache and the sieving primes (smc_factor_chunk_size) unless
+ * SMC_FACTOR_CHUNK is defined.
+ */
+
+/* Most prime factors (with multiplicity) a 64-bit integer can have */
+#define SMC_MAX_FACTORS64 64
+
+/* ===========================================================================
+ * HELPERS
+ * =========================================================================== */
+
+/* Binary GCD */
+SMC_INLINE uint64_t smc_gcd64(uint64_t a, uint64_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    int shift = smc_ctz64(a | b);
+    a >>= smc_ctz64(a);
+    do {
+        b >>= smc_ctz64(b);
+        if (a > b) { uint64_t t = a; a = b; b = t; }
+        b -= a;
+    } while (b != 0);
+    return a << shift;
+}
+
+/*
+ * Exact-division test for odd p with p_inv = p^-1 mod 2^64.
+ * n is divisible by p iff n * p_inv <= (2^64 - 1) / p; the quotient is
+ * then n * p_inv.
+ */
+SMC_INLINE bool smc_divisible_inv64(uint64_t n, uint64_t p, uint64_t p_inv, uint64_t *quot) {
+    uint64_t q = n * p_inv;
+    *quot = q;
+#if defined(__SIZEOF_INT128__)
+    return (((__uint128_t)q * p) >> 64) == 0;
+#else
+    return q <= UINT64_MAX / p;
+#endif
+}
+
+/* ===========================================================================
+ * POLLARD RHO (Brent)
+ * =========================================================================== */
+
+/*
+ * Find a non-trivial factor of odd composite n using x -> x^2 + c.
+ * Returns n on failure for this c; retry with another constant.
+ */
+SMC_API uint64_t smc_rho64(uint64_t n, uint64_t c) {
+    const uint64_t m = 128;
+    uint64_t n_inv = smc_mont_inv64(n);
+    uint64_t one = smc_mont_one64(n);
+    uint64_t y = one, x = one, ys = one, q = one, g = 1;
+    c %= n;
+    for (uint64_t r = 1; g == 1; r <<= 1) {
+        x = y;
+        for (uint64_t i = 0; i < r; i++) {
+            y = smc_mont_mul64(y, y, n, n_inv);
+            y = y >= n - c ? y - (n - c) : y + c;
+        }
+        for (uint64_t k = 0; k < r && g == 1; k += m) {
+            ys = y;
+            uint64_t lim = r - k < m ? r - k : m;
+            for (uint64_t i = 0; i < lim; i++) {
+                y = smc_mont_mul64(y, y, n, n_inv);
+                y = y >= n - c ? y - (n - c) : y + c;
+                q = smc_mont_mul64(q, x > y ? x - y : y - x, n, n_inv);
+            }
+            g = smc_gcd64(q, n);
+        }
+    }
+    if (g == n) {
+        /* The batched product hit 0 mod n; replay one step at a time */
+        do {
+            ys = smc_mont_mul64(ys, ys, n, n_inv);
+            ys = ys >= n - c ? ys - (n - c) : ys + c;
+            g = smc_gcd64(x > ys ? x - ys : ys - x, n);
+        } while (g == 1);
+    }
+    return g;
+}
+
+/*
+ * Prime factorization of n, ascending with multiplicity.
+ *
+ * Writes up to SMC_MAX_FACTORS64 factors to f and returns their count;
+ * 0 and 1 have no factors.
+ */
+SMC_API int smc_factor64(uint64_t n, uint64_t *f) {
+    int k = 0;
+    if (n < 2) return 0;
+    int tz = smc_ctz64(n);
+    n >>= tz;
+    while (tz-- > 0) f[k++] = 2;
+
+    for (size_t i = 0; i < SMC_NUM_PRIME_INV64 && n > 1; i++) {
+        uint64_t p = SMC_SMALL_PRIMES[i], q;
+        if (p * p > n) break;
+        while (smc_divisible_inv64(n, p, SMC_PRIME_INV64[i], &q)) { f[k++] = p; n = q; }
+    }
+
+    /* Split the remaining cofactor with a small explicit stack */
+    uint64_t stack[SMC_MAX_FACTORS64];
+    int sp = 0;
+    if (n > 1) stack[sp++] = n;
+    while (sp > 0) {
+        uint64_t m = stack[--sp];
+        if (smc_is_prime64(m)) { f[k++] = m; continue; }
+        uint64_t d = m;
+        for (uint64_t c = 1; d == m; c++) d = smc_rho64(m, c);
+        stack[sp++] = d;
+        stack[sp++] = m / d;
+    }
+
+    /* Insertion sort: at most 64 entries, mostly ordered already */
+    for (int i = 1; i < k; i++) {
+        uint64_t v = f[i];
+        int j = i;
+        while (j > 0 && f[j - 1] > v) { f[j] = f[j - 1]; j--; }
+        f[j] = v;
+    }
+    return k;
+}
+
+/* ===========================================================================
+ * RANGE FACTORIZATION
+ *
+ * Factors every integer of [lo, hi). Results arrive as chunks: the prime
+ * factors of chunk->lo + i are factor[offset[i] .. offset[i + 1]),
+ * ascending with multiplicity (0 and 1 have none).
+ *
+ * smc_factor_range streams chunks to a callback from worker threads;
+ * chunks of one slice arrive in order, slices run concurrently.
+ * smc_factor_window builds a single arena for a whole (moderate) window.
+ * =========================================================================== */
+
+typedef struct smc_factor_chunk {
+    uint64_t lo;            /* first integer of the chunk */
+    size_t count;           /* integers in the chunk */
+    uint32_t *offset;       /* count + 1 entries */
+    uint64_t *factor;       /* offset[count] entries */
+} smc_factor_chunk;
+
+typedef void (*smc_factor_fn)(void *ctx, const smc_factor_chunk *chunk);
+
+/* Odd sieving primes with their inverses mod 2^64, shared by all slices */
+typedef struct smc_factor_primes {
+    uint32_t *p;
+    uint64_t *inv;
+    size_t n;
+} smc_factor_primes;
+
+/* Per-slice sieving state and buffers */
+typedef struct smc_factor_sieve {
+    const smc_factor_primes *fp;
+    uint64_t pos;           /* next integer to factor */
+    uint64_t *next;         /* per prime: next multiple, as an offset from pos */
+    uint64_t *resid;        /* unfactored part of each entry */
+    uint64_t *hits;         /* (prime << 32) | entry, in prime order */
+    size_t hit_cap;
+    uint32_t *cursor;
+    smc_factor_chunk chunk;
+    size_t factor_cap;
+    size_t cap;             /* entries per chunk */
+} smc_factor_sieve;
+
+SMC_API void smc_factor_primes_free(smc_factor_primes *fp) {
+    free(fp->p);
+    free(fp->inv);
+    memset(fp, 0, sizeof(*fp));
+}
+
+SMC_API bool smc_factor_primes_init(smc_factor_primes *fp, uint64_t hi) {
+    memset(fp, 0, sizeof(*fp));
+    size_t np = 0;
+    fp->p = smc_sieve_primes32(hi > 1 ? smc_isqrt64(hi - 1) : 0, &np);
+    if (fp->p == NULL) return false;
+    /* Drop 2: powers of two are stripped with a trailing-zero count */
+    if (np > 0) memmove(fp->p, fp->p + 1, (np - 1) * sizeof(uint32_t));
+    fp->n = np > 0 ? np - 1 : 0;
+    fp->inv = (uint64_t *)malloc((fp->n + 1) * sizeof(uint64_t));
+    if (fp->inv == NULL) { smc_factor_primes_free(fp); return false; }
+    for (size_t k = 0; k < fp->n; k++) fp->inv[k] = smc_mont_inv64(fp->p[k]);
+    return true;
+}
+
+SMC_API void smc_factor_sieve_free(smc_factor_sieve *fs) {
+    free(fs->next);
+    free(fs->resid);
+    free(fs->hits);
+    free(fs->cursor);
+    free(fs->chunk.offset);
+    free(fs->chunk.factor);
+    memset(fs, 0, sizeof(*fs));
+}
+
+/* Prepare to factor chunks of up to 'cap' integers starting at 'start' */
+SMC_API bool smc_factor_sieve_init(smc_factor_sieve *fs, const smc_factor_primes *fp,
+                                   uint64_t start, size_t cap) {
+    memset(fs, 0, sizeof(*fs));
+    fs->fp = fp;
+    fs->pos = start;
+    fs->cap = cap;
+    fs->hit_cap = 4 * cap + 64;
+    fs->factor_cap = 4 * cap + 64;
+    fs->next = (uint64_t *)malloc((fp->n + 1) * sizeof(uint64_t));
+    fs->resid = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    fs->hits = (uint64_t *)malloc(fs->hit_cap * sizeof(uint64_t));
+    fs->cursor = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    fs->chunk.offset = (uint32_t *)malloc((cap + 1) * sizeof(uint32_t));
+    fs->chunk.factor = (uint64_t *)malloc(fs->factor_cap * sizeof(uint64_t));
+    if (!fs->next || !fs->resid || !fs->hits || !fs->cursor || !fs->chunk.offset || !fs->chunk.factor) {
+        smc_factor_sieve_free(fs);
+        return false;
+    }
+    for (size_t k = 0; k < fp->n; k++) {
+        /* First multiple >= max(start, p): 0 is never sieved */
+        uint64_t p = fp->p[k];
+        if (start <= p) {
+            fs->next[k] = p - start;
+        } else {
+            uint64_t r = start % p;
+            fs->next[k] = r ? p - r : 0;
+        }
+    }
+    return true;
+}
+
+/* Factor the next 'len' (<= cap) integers into fs->chunk */
+SMC_API bool smc_factor_sieve_chunk(smc_factor_sieve *fs, size_t len) {
+    const smc_factor_primes *fp = fs->fp;
+    uint64_t *resid = fs->resid;
+    uint32_t *off = fs->chunk.offset;
+    size_t nh = 0;
+
+    memset(off, 0, (len + 1) * sizeof(uint32_t));
+    for (size_t j = 0; j < len; j++) {
+        uint64_t v = fs->pos + j;
+        if (v == 0) { resid[j] = 1; continue; }
+        int tz = smc_ctz64(v);
+        resid[j] = v >> tz;
+        off[j + 1] = (uint32_t)tz;
+    }
+
+    for (size_t k = 0; k < fp->n; k++) {
+        uint64_t j = fs->next[k];
+        if (j >= len) { fs->next[k] = j - len; continue; }
+        uint64_t p = fp->p[k], inv = fp->inv[k];
+        for (; j < len; j += p) {
+            uint64_t v = resid[j] * inv, q;
+            uint32_t e = 1;
+            while (smc_divisible_inv64(v, p, inv, &q)) { v = q; e++; }
+            resid[j] = v;
+            off[j + 1] += e;
+            if (nh + e > fs->hit_cap) {
+                size_t cap = 2 * fs->hit_cap + e;
+                uint64_t *t = (uint64_t *)realloc(fs->hits, cap * sizeof(uint64_t));
+                if (t == NULL) return false;
+                fs->hits = t;
+                fs->hit_cap = cap;
+            }
+            while (e-- > 0) fs->hits[nh++] = (p << 32) | j;
+        }
+        fs->next[k] = j - len;
+    }
+
+    /* Counting sort of hits into the arena; 2s first, cofactor last */
+    for (size_t j = 0; j < len; j++) off[j + 1] += off[j] + (resid[j] > 1);
+    size_t total = off[len];
+    if (total > fs->factor_cap) {
+        uint64_t *t = (uint64_t *)realloc(fs->chunk.factor, total * sizeof(uint64_t));
+        if (t == NULL) return false;
+        fs->chunk.factor = t;
+        fs->factor_cap = total;
+    }
+    uint64_t *fac = fs->chunk.factor;
+    for (size_t j = 0; j < len; j++) {
+        uint32_t c = off[j];
+        uint64_t v = fs->pos + j;
+        if (v != 0) for (int tz = smc_ctz64(v); tz > 0; tz--) fac[c++] = 2;
+        fs->cursor[j] = c;
+    }
+    for (size_t h = 0; h < nh; h++) {
+        uint32_t j = (uint32_t)fs->hits[h];
+        fac[fs->cursor[j]++] = fs->hits[h] >> 32;
+    }
+    for (size_t j = 0; j < len; j++) {
+        if (resid[j] > 1) fac[fs->cursor[j]] = resid[j];
+    }
+
+    fs->chunk.lo = fs->pos;
+    fs->chunk.count = len;
+    fs->pos += len;
+    return true;
+}
+
+SMC_API void smc_factor_chunk_free(smc_factor_chunk *c) {
+    free(c->offset);
+    free(c->factor);
+    memset(c, 0, sizeof(*c));
+}
+
+/*
+ * Factor every integer of [lo, hi) into one arena (single-threaded).
+ * The window must have fewer than 2^32 total factors; free the result
+ * with smc_factor_chunk_free. Returns false on allocation failure.
+ */
+SMC_API bool smc_factor_window(uint64_t lo, uint64_t hi, smc_factor_chunk *out) {
+    memset(out, 0, sizeof(*out));
+    if (hi <= lo) return false;
+    smc_factor_primes fp;
+    if (!smc_factor_primes_init(&fp, hi)) return false;
+    smc_factor_sieve fs;
+    size_t len = (size_t)(hi - lo);
+    bool ok = smc_factor_sieve_init(&fs, &fp, lo, len) && smc_factor_sieve_chunk(&fs, len);
+    if (ok) {
+        *out = fs.chunk;
+        fs.chunk.offset = NULL;
+        fs.chunk.factor = NULL;
+    }
+    smc_factor_sieve_free(&fs);
+    smc_factor_primes_free(&fp);
+    return ok;
+}
+
+/*
+ * Chunk length for a sieve over nprimes primes. Residues, hit lists and
+ * factors take a few dozen bytes per integer, so small prime sets use
+ * L2/128 integers; the chunk grows with the prime count, since every
+ * chunk costs each prime an offset update, up to L2/8.
+ */
+SMC_INLINE size_t smc_factor_chunk_size(size_t nprimes) {
+#ifdef SMC_FACTOR_CHUNK
+    (void)nprimes;
+    return (size_t)SMC_FACTOR_CHUNK;
+#else
+    size_t l2 = smc_cache_sizes()->l2, n = nprimes / 4;
+    size_t lo = l2 / 128, hi = l2 / 8;
+    n = n < lo ? lo : n > hi ? hi : n;
+    return n < 1024 ? 1024 : n;
+#endif
+}
+
+typedef struct smc_factor_job {
+    uint64_t lo, hi, slice;
+    size_t chunk;
+    const smc_factor_primes *fp;
+    smc_factor_fn fn;
+    void *ctx;
+    volatile uint64_t failed;
+} smc_factor_job;
+
+SMC_API void smc_factor_range_task(void *arg, size_t index) {
+    smc_factor_job *job = (smc_factor_job *)arg;
+    uint64_t a = job->lo + (uint64_t)index * job->slice;
+    uint64_t b = job->hi - a < job->slice ? job->hi : a + job->slice;
+    smc_factor_sieve fs;
+    if (!smc_factor_sieve_init(&fs, job->fp, a, job->chunk)) {
+        smc_atomic_store64(&job->failed, 1);
+        return;
+    }
+    while (fs.pos < b) {
+        size_t len = b - fs.pos < job->chunk ? (size_t)(b - fs.pos) : job->chunk;
+        if (!smc_factor_sieve_chunk(&fs, len)) { smc_atomic_store64(&job->failed, 1); break; }
+        job->fn(job->ctx, &fs.chunk);
+    }
+    smc_factor_sieve_free(&fs);
+}
+
+/*
+ * Factor every integer of [lo, hi) on up to 'threads' threads (0 = all),
+ * passing each factored chunk to fn. The window is split into contiguous
+ * slices so every thread keeps its sieve offsets across chunks.
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_factor_range(uint64_t lo, uint64_t hi, unsigned threads,
+                              smc_factor_fn fn, void *ctx) {
+    if (hi <= lo) return true;
+    smc_factor_primes fp;
+    if (!smc_factor_primes_init(&fp, hi)) return false;
+    if (threads == 0) threads = smc_thread_count();
+
+    /* A few slices per thread for balance, each at least a few chunks */
+    uint64_t span = hi - lo;
+    size_t chunk = smc_factor_chunk_size(fp.n);
+    uint64_t slices = (uint64_t)threads * 4;
+    uint64_t min_slice = (uint64_t)chunk * 8;
+    if (span / slices < min_slice) slices = span / min_slice + 1;
+    uint64_t slice = span / slices + (span % slices != 0);
+    slices = span / slice + (span % slice != 0);
+
+    smc_factor_job job;
+    job.lo = lo;
+    job.hi = hi;
+    job.slice = slice;
+    job.chunk = chunk;
+    job.fp = &fp;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.failed = 0;
+    smc_parallel_for((size_t)slices, threads, smc_factor_range_task, &job);
+    smc_factor_primes_free(&fp);
+    return job.failed == 0;
+}
+
+/* ===========================================================================
+ * LANE-PARALLEL RHO
+ *
+ * SMC_RHO_LANES independent Brent-rho walks advance in lockstep, one per
+ * lane, and are checked with a gcd every SMC_RHO_BLOCK steps; a lane that
+ * finds a factor is refilled from the work queue. Each walk iterates
+ * y -> y^2 / R + c in the engine's Montgomery domain, which is as good a
+ * pseudo-random map mod every prime factor as y^2 + c. Engines, chosen at
+ * compile time:
+ * - AVX-512 IFMA: R = 2^52, five 52-bit multiply-adds per product, for
+ *   moduli below 2^52
+ * - AVX-512F: R = 2^64 from 32x32-bit products (64-bit low products with
+ *   AVX-512DQ), for the larger moduli
+ * - AVX2: the same on four lanes; opt-in with SMC_RHO_AVX2, as scalar
+ *   lanes measured faster where 64-bit vector products are missing
+ * - Scalar: R = 2^64; the independent lanes still overlap their multiply
+ *   chains
+ * =========================================================================== */
+
+#define SMC_RHO_LANES 16
+
+/* Steps between gcd checks */
+#ifndef SMC_RHO_BLOCK
+  #define SMC_RHO_BLOCK 256
+#endif
+
+typedef struct smc_rho_lanes {
+    uint64_t n[SMC_RHO_LANES];
+    uint64_t inv[SMC_RHO_LANES];    /* the engine's Montgomery constant for n */
+    uint64_t c[SMC_RHO_LANES];
+    uint64_t x[SMC_RHO_LANES];      /* saved point, reset at power-of-two steps */
+    uint64_t y[SMC_RHO_LANES];
+    uint64_t q[SMC_RHO_LANES];      /* product of |x - y| since the last gcd */
+} smc_rho_lanes;
+
+typedef struct smc_rho_engine {
+    uint64_t (*inv)(uint64_t n);
+    uint64_t (*mul)(uint64_t a, uint64_t b, uint64_t n, uint64_t inv);
+    void (*block)(smc_rho_lanes *L, int steps);
+    uint64_t limit;                 /* moduli must be below this */
+} smc_rho_engine;
+
+SMC_INLINE uint64_t smc_rho_addc(uint64_t y, uint64_t c, uint64_t n) {
+    return y >= n - c ? y - (n - c) : y + c;
+}
+
+SMC_API uint64_t smc_rho_inv64(uint64_t n) {
+    return smc_mont_inv64(n);
+}
+
+SMC_API uint64_t smc_rho_mul64(uint64_t a, uint64_t b, uint64_t n, uint64_t inv) {
+    return smc_mont_mul64(a, b, n, inv);
+}
+
+SMC_API void smc_rho_block_scalar(smc_rho_lanes *L, int steps) {
+    for (int s = 0; s < steps; s++) {
+        for (int l = 0; l < SMC_RHO_LANES; l++) {
+            uint64_t n = L->n[l], inv = L->inv[l], x = L->x[l];
+            uint64_t y = smc_rho_addc(smc_mont_mul64(L->y[l], L->y[l], n, inv), L->c[l], n);
+            L->y[l] = y;
+            L->q[l] = smc_mont_mul64(L->q[l], x > y ? x - y : y - x, n, inv);
+        }
+    }
+}
+
+#if defined(__AVX2__) && defined(SMC_RHO_AVX2)
+
+/* Unsigned a < b per 64-bit lane */
+SMC_INLINE __m256i smc_lt_epu64_avx2(__m256i a, __m256i b) {
+    const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(b, sign), _mm256_xor_si256(a, sign));
+}
+
+/* High half of a 64x64-bit product per lane */
+SMC_INLINE __m256i smc_mulhi64_avx2(__m256i a, __m256i b, __m256i *lo) {
+    const __m256i m32 = _mm256_set1_epi64x(0xFFFFFFFF);
+    __m256i ah = _mm256_srli_epi64(a, 32), bh = _mm256_srli_epi64(b, 32);
+    __m256i p00 = _mm256_mul_epu32(a, b), p01 = _mm256_mul_epu32(a, bh);
+    __m256i p10 = _mm256_mul_epu32(ah, b), p11 = _mm256_mul_epu32(ah, bh);
+    __m256i mid = _mm256_add_epi64(_mm256_srli_epi64(p00, 32),
+                  _mm256_add_epi64(_mm256_and_si256(p01, m32), _mm256_and_si256(p10, m32)));
+    if (lo) *lo = _mm256_or_si256(_mm256_slli_epi64(mid, 32), _mm256_and_si256(p00, m32));
+    return _mm256_add_epi64(_mm256_add_epi64(p11, _mm256_srli_epi64(mid, 32)),
+           _mm256_add_epi64(_mm256_srli_epi64(p01, 32), _mm256_srli_epi64(p10, 32)));
+}
+
+/* smc_mont_mul64 on four lanes */
+SMC_INLINE __m256i smc_mont_mul64_avx2(__m256i a, __m256i b, __m256i n, __m256i inv) {
+    __m256i lo, hi = smc_mulhi64_avx2(a, b, &lo);
+    __m256i m = _mm256_add_epi64(_mm256_mul_epu32(lo, inv), _mm256_slli_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(lo, _mm256_srli_epi64(inv, 32)),
+                         _mm256_mul_epu32(_mm256_srli_epi64(lo, 32), inv)), 32));
+    __m256i t = smc_mulhi64_avx2(m, n, NULL);
+    return _mm256_add_epi64(_mm256_sub_epi64(hi, t), _mm256_and_si256(smc_lt_epu64_avx2(hi, t), n));
+}
+
+SMC_API void smc_rho_block_avx2(smc_rho_lanes *L, int steps) {
+    for (int v = 0; v < SMC_RHO_LANES; v += 8) {
+        __m256i n[2], inv[2], nc[2], c[2], x[2], y[2], q[2];
+        for (int h = 0; h < 2; h++) {
+            n[h] = _mm256_loadu_si256((const __m256i *)(L->n + v + 4 * h));
+            inv[h] = _mm256_loadu_si256((const __m256i *)(L->inv + v + 4 * h));
+            c[h] = _mm256_loadu_si256((const __m256i *)(L->c + v + 4 * h));
+            x[h] = _mm256_loadu_si256((const __m256i *)(L->x + v + 4 * h));
+            y[h] = _mm256_loadu_si256((const __m256i *)(L->y + v + 4 * h));
+            q[h] = _mm256_loadu_si256((const __m256i *)(L->q + v + 4 * h));
+            nc[h] = _mm256_sub_epi64(n[h], c[h]);
+        }
+        for (int s = 0; s < steps; s++) {
+            for (int h = 0; h < 2; h++) {
+                __m256i t = smc_mont_mul64_avx2(y[h], y[h], n[h], inv[h]);
+                __m256i wrap = smc_lt_epu64_avx2(t, nc[h]);
+                t = _mm256_blendv_epi8(_mm256_sub_epi64(t, nc[h]), _mm256_add_epi64(t, c[h]), wrap);
+                y[h] = t;
+                __m256i d = _mm256_blendv_epi8(_mm256_sub_epi64(x[h], t), _mm256_sub_epi64(t, x[h]),
+                                               smc_lt_epu64_avx2(x[h], t));
+                q[h] = smc_mont_mul64_avx2(q[h], d, n[h], inv[h]);
+            }
+        }
+        for (int h = 0; h < 2; h++) {
+            _mm256_storeu_si256((__m256i *)(L->y + v + 4 * h), y[h]);
+            _mm256_storeu_si256((__m256i *)(L->q + v + 4 * h), q[h]);
+        }
+    }
+}
+
+#endif /* SMC_RHO_AVX2 */
+
+#if defined(__AVX512F__)
+
+/* GCC 12 reports the intrinsics' deliberately undefined lanes in C++ */
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/* High half (and optionally the low half) of a 64x64-bit product per lane */
+SMC_INLINE __m512i smc_mulhi64_avx512(__m512i a, __m512i b, __m512i *lo) {
+    const __m512i m32 = _mm512_set1_epi64(0xFFFFFFFF);
+    __m512i ah = _mm512_srli_epi64(a, 32), bh = _mm512_srli_epi64(b, 32);
+    __m512i p00 = _mm512_mul_epu32(a, b), p01 = _mm512_mul_epu32(a, bh);
+    __m512i p10 = _mm512_mul_epu32(ah, b), p11 = _mm512_mul_epu32(ah, bh);
+    __m512i mid = _mm512_add_epi64(_mm512_srli_epi64(p00, 32),
+                  _mm512_add_epi64(_mm512_and_si512(p01, m32), _mm512_and_si512(p10, m32)));
+    if (lo) *lo = _mm512_or_si512(_mm512_slli_epi64(mid, 32), _mm512_and_si512(p00, m32));
+    return _mm512_add_epi64(_mm512_add_epi64(p11, _mm512_srli_epi64(mid, 32)),
+           _mm512_add_epi64(_mm512_srli_epi64(p01, 32), _mm512_srli_epi64(p10, 32)));
+}
+
+/* smc_mont_mul64 on eight lanes */
+SMC_INLINE __m512i smc_mont_mul64_avx512(__m512i a, __m512i b, __m512i n, __m512i inv) {
+    __m512i lo, hi = smc_mulhi64_avx512(a, b, &lo);
+#if defined(__AVX512DQ__)
+    __m512i m = _mm512_mullo_epi64(lo, inv);
+#else
+    __m512i m = _mm512_add_epi64(_mm512_mul_epu32(lo, inv), _mm512_slli_epi64(
+        _mm512_add_epi64(_mm512_mul_epu32(lo, _mm512_srli_epi64(inv, 32)),
+                         _mm512_mul_epu32(_mm512_srli_epi64(lo, 32), inv)), 32));
+#endif
+    __m512i t = smc_mulhi64_avx512(m, n, NULL);
+    __m512i r = _mm512_sub_epi64(hi, t);
+    return _mm512_mask_add_epi64(r, _mm512_cmplt_epu64_mask(hi, t), r, n);
+}
+
+SMC_API void smc_rho_block_avx512(smc_rho_lanes *L, int steps) {
+    __m512i n[2], inv[2], nc[2], c[2], x[2], y[2], q[2];
+    for (int h = 0; h < 2; h++) {
+        n[h] = _mm512_loadu_si512(L->n + 8 * h);
+        inv[h] = _mm512_loadu_si512(L->inv + 8 * h);
+        c[h] = _mm512_loadu_si512(L->c + 8 * h);
+        x[h] = _mm512_loadu_si512(L->x + 8 * h);
+        y[h] = _mm512_loadu_si512(L->y + 8 * h);
+        q[h] = _mm512_loadu_si512(L->q + 8 * h);
+        nc[h] = _mm512_sub_epi64(n[h], c[h]);
+    }
+    for (int s = 0; s < steps; s++) {
+        for (int h = 0; h < 2; h++) {
+            __m512i t = smc_mont_mul64_avx512(y[h], y[h], n[h], inv[h]);
+            __mmask8 wrap = _mm512_cmpge_epu64_mask(t, nc[h]);
+            t = _mm512_mask_sub_epi64(_mm512_add_epi64(t, c[h]), wrap, t, nc[h]);
+            y[h] = t;
+            __m512i d = _mm512_sub_epi64(_mm512_max_epu64(x[h], t), _mm512_min_epu64(x[h], t));
+            q[h] = smc_mont_mul64_avx512(q[h], d, n[h], inv[h]);
+        }
+    }
+    for (int h = 0; h < 2; h++) {
+        _mm512_storeu_si512(L->y + 8 * h, y[h]);
+        _mm512_storeu_si512(L->q + 8 * h, q[h]);
+    }
+}
+
+#endif /* __AVX512F__ */
+
+#if defined(__AVX512IFMA__) && defined(__AVX512F__) && defined(__SIZEOF_INT128__)
+
+#define SMC_MASK52 ((1ULL << 52) - 1)
+
+/* -n^-1 mod 2^52 */
+SMC_API uint64_t smc_rho_inv52(uint64_t n) {
+    return (0 - smc_mont_inv64(n)) & SMC_MASK52;
+}
+
+/* a b / 2^52 mod n for n < 2^52 */
+SMC_API uint64_t smc_rho_mul52(uint64_t a, uint64_t b, uint64_t n, uint64_t inv) {
+    __uint128_t t = (__uint128_t)a * b;
+    uint64_t m = ((uint64_t)t * inv) & SMC_MASK52;
+    uint64_t r = (uint64_t)((t + (__uint128_t)m * n) >> 52);
+    return r >= n ? r - n : r;
+}
+
+/* smc_rho_mul52 on eight lanes */
+SMC_INLINE __m512i smc_mont_mul52_ifma(__m512i a, __m512i b, __m512i n, __m512i inv) {
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i lo = _mm512_madd52lo_epu64(zero, a, b);
+    __m512i hi = _mm512_madd52hi_epu64(zero, a, b);
+    __m512i m = _mm512_madd52lo_epu64(zero, lo, inv);
+    hi = _mm512_madd52hi_epu64(hi, m, n);
+    lo = _mm512_madd52lo_epu64(lo, m, n);           /* 0 or 2^52 */
+    __m512i r = _mm512_add_epi64(hi, _mm512_srli_epi64(lo, 52));
+    return _mm512_mask_sub_epi64(r, _mm512_cmpge_epu64_mask(r, n), r, n);
+}
+
+SMC_API void smc_rho_block_ifma(smc_rho_lanes *L, int steps) {
+    __m512i n[2], inv[2], nc[2], c[2], x[2], y[2], q[2];
+    for (int h = 0; h < 2; h++) {
+        n[h] = _mm512_loadu_si512(L->n + 8 * h);
+        inv[h] = _mm512_loadu_si512(L->inv + 8 * h);
+        c[h] = _mm512_loadu_si512(L->c + 8 * h);
+        x[h] = _mm512_loadu_si512(L->x + 8 * h);
+        y[h] = _mm512_loadu_si512(L->y + 8 * h);
+        q[h] = _mm512_loadu_si512(L->q + 8 * h);
+        nc[h] = _mm512_sub_epi64(n[h], c[h]);
+    }
+    for (int s = 0; s < steps; s++) {
+        for (int h = 0; h < 2; h++) {
+            __m512i t = smc_mont_mul52_ifma(y[h], y[h], n[h], inv[h]);
+            __mmask8 wrap = _mm512_cmpge_epu64_mask(t, nc[h]);
+            t = _mm512_mask_sub_epi64(_mm512_add_epi64(t, c[h]), wrap, t, nc[h]);
+            y[h] = t;
+            __m512i d = _mm512_sub_epi64(_mm512_max_epu64(x[h], t), _mm512_min_epu64(x[h], t));
+            q[h] = smc_mont_mul52_ifma(q[h], d, n[h], inv[h]);
+        }
+    }
+    for (int h = 0; h < 2; h++) {
+        _mm512_storeu_si512(L->y + 8 * h, y[h]);
+        _mm512_storeu_si512(L->q + 8 * h, q[h]);
+    }
+}
+
+#endif /* IFMA */
+
+#if defined(__AVX512F__) && defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic pop
+#endif
+
+/* Growable list of (entry, value) pairs */
+typedef struct smc_factor_pairs {
+    uint64_t *entry;
+    uint64_t *value;
+    size_t n, cap;
+} smc_factor_pairs;
+
+SMC_API void smc_factor_pairs_free(smc_factor_pairs *v) {
+    free(v->entry);
+    free(v->value);
+    memset(v, 0, sizeof(*v));
+}
+
+SMC_API bool smc_factor_pairs_push(smc_factor_pairs *v, uint64_t entry, uint64_t value) {
+    if (v->n == v->cap) {
+        size_t cap = v->cap ? 2 * v->cap : 256;
+        uint64_t *e = (uint64_t *)realloc(v->entry, cap * sizeof(uint64_t));
+        if (e == NULL) return false;
+        v->entry = e;
+        uint64_t *x = (uint64_t *)realloc(v->value, cap * sizeof(uint64_t));
+        if (x == NULL) return false;
+        v->value = x;
+        v->cap = cap;
+    }
+    v->entry[v->n] = entry;
+    v->value[v->n++] = value;
+    return true;
+}
+
+/*
+ * Split the odd composites in 'work' (all below e->limit, no factor below
+ * 337) into primes, appending (entry, prime) to 'out'. Parts that are
+ * still composite go back on 'work'. Returns false on allocation failure.
+ */
+SMC_API bool smc_rho_lanes_run(const smc_rho_engine *e, smc_factor_pairs *work,
+                               smc_factor_pairs *out) {
+    smc_rho_lanes L;
+    uint64_t entry[SMC_RHO_LANES], steps[SMC_RHO_LANES], ys[SMC_RHO_LANES];
+    bool busy[SMC_RHO_LANES];
+    const uint64_t idle_inv = e->inv(3);
+    for (int l = 0; l < SMC_RHO_LANES; l++) {
+        busy[l] = false;
+        L.n[l] = 3; L.inv[l] = idle_inv; L.c[l] = 1;
+        L.x[l] = L.y[l] = L.q[l] = 1;
+    }
+    for (;;) {
+        int active = 0;
+        for (int l = 0; l < SMC_RHO_LANES; l++) {
+            if (!busy[l] && work->n > 0) {
+                work->n--;
+                entry[l] = work->entry[work->n];
+                L.n[l] = work->value[work->n];
+                L.inv[l] = e->inv(L.n[l]);
+                L.c[l] = 1;
+                L.x[l] = L.y[l] = 2;
+                L.q[l] = 1;
+                steps[l] = 0;
+                busy[l] = true;
+            }
+            active += busy[l];
+            ys[l] = L.y[l];
+        }
+        if (active == 0) return true;
+
+        e->block(&L, SMC_RHO_BLOCK);
+
+        for (int l = 0; l < SMC_RHO_LANES; l++) {
+            if (!busy[l]) continue;
+            uint64_t n = L.n[l], inv = L.inv[l], x = L.x[l];
+            steps[l] += SMC_RHO_BLOCK;
+            uint64_t g = smc_gcd64(L.q[l], n);
+            if (g == 1) {
+                if ((steps[l] & (steps[l] - 1)) == 0) L.x[l] = L.y[l];
+                continue;
+            }
+            if (g == n) {
+                /* The block's product hit 0 mod n; replay it one step at a time */
+                uint64_t y = ys[l];
+                for (int i = 0; i < SMC_RHO_BLOCK && (g == 1 || g == n); i++) {
+                    y = smc_rho_addc(e->mul(y, y, n, inv), L.c[l], n);
+                    g = smc_gcd64(x > y ? x - y : y - x, n);
+                }
+            }
+            if (g == 1 || g == n) {
+                /* Cycle without a split: restart with the next constant */
+                L.c[l]++;
+                L.x[l] = L.y[l] = 2;
+                L.q[l] = 1;
+                steps[l] = 0;
+                continue;
+            }
+            uint64_t part[2] = {g, n / g};
+            for (int k = 0; k < 2; k++) {
+                smc_factor_pairs *dst = smc_is_prime64(part[k]) ? out : work;
+                if (!smc_factor_pairs_push(dst, entry[l], part[k])) return false;
+            }
+            busy[l] = false;
+            L.n[l] = 3; L.inv[l] = idle_inv; L.c[l] = 1;
+            L.x[l] = L.y[l] = L.q[l] = 1;
+        }
+    }
+}
+
+/* ===========================================================================
+ * BATCH FACTORIZATION
+ * =========================================================================== */
+
+/*
+ * Factor n[0 .. count) into one arena: the prime factors of n[i] are
+ * out->factor[out->offset[i] .. out->offset[i + 1]), ascending with
+ * multiplicity (out->lo is 0). Cofactors left by trial division are split
+ * by the lane-parallel rho. Needs fewer than 2^32 factors in total; free
+ * with smc_factor_chunk_free. Returns false on allocation failure.
+ */
+SMC_API bool smc_factor_batch(const uint64_t *n, size_t count, smc_factor_chunk *out) {
+    memset(out, 0, sizeof(*out));
+    smc_factor_pairs found, work, big;
+    memset(&found, 0, sizeof(found));
+    memset(&work, 0, sizeof(work));
+    memset(&big, 0, sizeof(big));
+    bool ok = true;
+
+    /* Trial division, as in smc_factor64 */
+    for (size_t i = 0; i < count && ok; i++) {
+        uint64_t m = n[i];
+        if (m < 2) continue;
+        for (int tz = smc_ctz64(m); tz > 0; tz--) ok = ok && smc_factor_pairs_push(&found, i, 2);
+        m >>= smc_ctz64(m);
+        for (size_t k = 0; k < SMC_NUM_PRIME_INV64 && m > 1; k++) {
+            uint64_t p = SMC_SMALL_PRIMES[k], q;
+            if (p * p > m) break;
+            while (smc_divisible_inv64(m, p, SMC_PRIME_INV64[k], &q)) {
+                ok = ok && smc_factor_pairs_push(&found, i, p);
+                m = q;
+            }
+        }
+        if (m == 1) continue;
+        if (smc_is_prime64(m)) ok = ok && smc_factor_pairs_push(&found, i, m);
+        else ok = ok && smc_factor_pairs_push(&work, i, m);
+    }
+
+    /* Rho: IFMA for the cofactors it can take, 64-bit lanes for the rest */
+    smc_rho_engine wide;
+    wide.inv = smc_rho_inv64;
+    wide.mul = smc_rho_mul64;
+    wide.limit = UINT64_MAX;
+#if defined(__AVX512F__)
+    wide.block = smc_rho_block_avx512;
+#elif defined(__AVX2__) && defined(SMC_RHO_AVX2)
+    wide.block = smc_rho_block_avx2;
+#else
+    wide.block = smc_rho_block_scalar;
+#endif
+#if defined(__AVX512IFMA__) && defined(__AVX512F__) && defined(__SIZEOF_INT128__)
+    smc_rho_engine narrow;
+    narrow.inv = smc_rho_inv52;
+    narrow.mul = smc_rho_mul52;
+    narrow.block = smc_rho_block_ifma;
+    narrow.limit = 1ULL << 52;
+    for (size_t k = 0; k < work.n && ok; k++)
+        if (work.value[k] >= narrow.limit) ok = smc_factor_pairs_push(&big, work.entry[k], work.value[k]);
+    size_t small = 0;
+    for (size_t k = 0; k < work.n; k++) {
+        if (work.value[k] < narrow.limit) {
+            work.entry[small] = work.entry[k];
+            work.value[small++] = work.value[k];
+        }
+    }
+    work.n = small;
+    ok = ok && smc_rho_lanes_run(&narrow, &work, &found);
+    ok = ok && smc_rho_lanes_run(&wide, &big, &found);
+#else
+    ok = ok && smc_rho_lanes_run(&wide, &work, &found);
+#endif
+
+    /* Counting sort by entry, then each entry's factors ascending */
+    if (ok) {
+        out->count = count;
+        out->offset = (uint32_t *)calloc(count + 1, sizeof(uint32_t));
+        out->factor = (uint64_t *)malloc((found.n ? found.n : 1) * sizeof(uint64_t));
+        ok = out->offset != NULL && out->factor != NULL;
+    }
+    if (ok) {
+        uint32_t *off = out->offset;
+        for (size_t k = 0; k < found.n; k++) off[found.entry[k] + 1]++;
+        for (size_t i = 0; i < count; i++) off[i + 1] += off[i];
+        /* Place using off[i] as a cursor, then shift the starts back */
+        for (size_t k = 0; k < found.n; k++) out->factor[off[found.entry[k]]++] = found.value[k];
+        for (size_t i = count; i > 0; i--) off[i] = off[i - 1];
+        off[0] = 0;
+        for (size_t i = 0; i < count; i++) {
+            uint64_t *f = out->factor + off[i];
+            int len = (int)(off[i + 1] - off[i]);
+            for (int a = 1; a < len; a++) {
+                uint64_t v = f[a];
+                int b = a;
+                while (b > 0 && f[b - 1] > v) { f[b] = f[b - 1]; b--; }
+                f[b] = v;
+            }
+        }
+    }
+    smc_factor_pairs_free(&work);
+    smc_factor_pairs_free(&big);
+    if (!ok) {
+        smc_factor_pairs_free(&found);
+        smc_factor_chunk_free(out);
+        return false;
+    }
+    smc_factor_pairs_free(&found);
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_FACTOR_H */
@@ -0,0 +1,258 @@
+/*
+ * smcPrime - Goldbach / Additive Prime Engine
+ *
+ * Counts representations n = p + q over a whole range at once:
+ * - Prime indicator over the odd numbers of [0, N] from the segmented sieve
+ * - Autoconvolution by a number-theoretic transform modulo
+ *   P = 29 * 2^57 + 1 in Montgomery form (smc_mont_mul64)
+ *
+ * A direct verification mode finds, for each even n of a window, the
+ * smallest prime p with n - p prime, testing candidates with
+ * smc_is_prime64; it works for any n < 2^64.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_GOLDBACH_H
+#define SMCPRIME_GOLDBACH_H
+
+#include "smcprime.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* NTT prime 29 * 2^57 + 1 with primitive root 3; transforms up to 2^57 */
+#define SMC_NTT_P      4179340454199820289ULL
+#define SMC_NTT_ROOT   3
+#define SMC_NTT_LOG2_MAX 57
+
+/* ===========================================================================
+ * NUMBER-THEORETIC TRANSFORM (mod SMC_NTT_P, Montgomery form)
+ * =========================================================================== */
+
+SMC_INLINE uint64_t smc_ntt_add(uint64_t a, uint64_t b) {
+    uint64_t s = a + b;
+    return s >= SMC_NTT_P ? s - SMC_NTT_P : s;
+}
+
+SMC_INLINE uint64_t smc_ntt_sub(uint64_t a, uint64_t b) {
+    return a >= b ? a - b : a - b + SMC_NTT_P;
+}
+
+typedef struct smc_ntt_stage {
+    uint64_t *a;
+    size_t half;            /* butterfly span of this stage */
+    size_t per_task;        /* butterflies per task */
+    size_t total;           /* butterflies in the stage (length / 2) */
+    uint64_t w;             /* stage root in Montgomery form */
+    uint64_t n_inv, one;
+    bool inverse;
+} smc_ntt_stage;
+
+/* Butterflies [i * per_task, ...) of one stage; twiddles advance by one multiply */
+SMC_API void smc_ntt_stage_task(void *ctx, size_t i) {
+    const smc_ntt_stage *st = (const smc_ntt_stage *)ctx;
+    const uint64_t P = SMC_NTT_P, n_inv = st->n_inv;
+    size_t b = i * st->per_task;
+    size_t end = b + st->per_task < st->total ? b + st->per_task : st->total;
+    size_t h = st->half;
+    uint64_t *a = st->a;
+    uint64_t tw = smc_mont_pow64(st->w, b % h, P, n_inv, st->one);
+    while (b < end) {
+        size_t j = b % h;
+        size_t stop = b - j + h < end ? b - j + h : end;
+        uint64_t *x = a + 2 * (b - j);
+        for (; b < stop; b++, j++) {
+            uint64_t u = x[j], v = x[j + h];
+            if (st->inverse) {
+                /* DIT: bit-reversed in, natural out */
+                v = smc_mont_mul64(v, tw, P, n_inv);
+                x[j] = smc_ntt_add(u, v);
+                x[j + h] = smc_ntt_sub(u, v);
+            } else {
+                /* DIF: natural in, bit-reversed out */
+                x[j] = smc_ntt_add(u, v);
+                x[j + h] = smc_mont_mul64(smc_ntt_sub(u, v), tw, P, n_inv);
+            }
+            tw = smc_mont_mul64(tw, st->w, P, n_inv);
+        }
+        tw = st->one;
+    }
+}
+
+/*
+ * In-place NTT of length 2^log2n (values in Montgomery form).
+ * The forward transform leaves its output in bit-reversed order and the
+ * inverse consumes that order, so convolutions need no permutation.
+ * The inverse includes the 1/n scaling.
+ */
+SMC_API void smc_ntt(uint64_t *a, unsigned log2n, bool inverse, unsigned threads) {
+    const uint64_t P = SMC_NTT_P;
+    size_t n = (size_t)1 << log2n;
+    smc_ntt_stage st;
+    st.a = a;
+    st.n_inv = smc_mont_inv64(P);
+    st.one = smc_mont_one64(P);
+    st.total = n / 2;
+    st.inverse = inverse;
+    if (threads == 0) threads = smc_thread_count();
+    size_t tasks = threads > 1 ? 4 * (size_t)threads : 1;
+    st.per_task = (st.total + tasks - 1) / tasks;
+    if (st.per_task < 4096) st.per_task = 4096;
+    size_t ntasks = (st.total + st.per_task - 1) / st.per_task;
+
+    uint64_t g = smc_to_mont64(SMC_NTT_ROOT, P);
+    for (unsigned s = 0; s < log2n; s++) {
+        /* Forward runs span n/2 .. 1, inverse runs 1 .. n/2 */
+        unsigned lg = inverse ? s + 1 : log2n - s;
+        st.half = (size_t)1 << (lg - 1);
+        uint64_t w = smc_mont_pow64(g, (P - 1) >> lg, P, st.n_inv, st.one);
+        if (inverse) w = smc_mont_pow64(w, ((uint64_t)1 << lg) - 1, P, st.n_inv, st.one);
+        st.w = w;
+        if (ntasks > 1) smc_parallel_for(ntasks, threads, smc_ntt_stage_task, &st);
+        else smc_ntt_stage_task(&st, 0);
+    }
+    if (inverse) {
+        uint64_t scale = smc_to_mont64(P - (P - 1) / n, P);   /* n^-1 mod P */
+        for (size_t i = 0; i < n; i++) a[i] = smc_mont_mul64(a[i], scale, P, st.n_inv);
+    }
+}
+
+/* ===========================================================================
+ * PAIR COUNTS BY CONVOLUTION
+ * =========================================================================== */
+
+/* Transform length (log2) and bytes of scratch smc_goldbach_counts needs */
+SMC_INLINE unsigned smc_goldbach_log2(uint64_t n_max) {
+    unsigned lg = 1;
+    while (((uint64_t)1 << lg) < n_max / 2 + 2) lg++;
+    return lg + 1;
+}
+
+/*
+ * Ordered representation counts r(n) = #{(p, q) : p + q = n, p, q prime}
+ * for every even n <= n_max, stored as counts[n / 2] (n_max / 2 + 1 entries).
+ *
+ * Scratch memory is 8 * 2^smc_goldbach_log2(n_max) bytes, about 8 * n_max
+ * to 16 * n_max. The unordered count is (r(n) + [n/2 prime]) / 2.
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_goldbach_counts(uint64_t n_max, uint32_t *counts, unsigned threads) {
+    const uint64_t P = SMC_NTT_P;
+    unsigned lg = smc_goldbach_log2(n_max);
+    if (lg > SMC_NTT_LOG2_MAX) return false;
+    size_t len = (size_t)1 << lg;
+    uint64_t *a = (uint64_t *)calloc(len, sizeof(uint64_t));
+    if (a == NULL) return false;
+
+    /* a[i] = one (Montgomery) iff 2i + 1 is an odd prime <= n_max - 3 */
+    uint64_t one = smc_mont_one64(P);
+    smc_sieve s;
+    if (n_max >= 6) {
+        if (!smc_sieve_init(&s, 3, n_max - 2)) { free(a); return false; }
+        while (smc_sieve_next(&s)) {
+            size_t words = (s.seg_bits + 63) / 64;
+            for (size_t w = 0; w < words; w++)
+                for (uint64_t m = s.bits[w]; m; m &= m - 1)
+                    a[(s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m))) / 2] = one;
+        }
+        smc_sieve_free(&s);
+    }
+
+    smc_ntt(a, lg, false, threads);
+    uint64_t n_inv = smc_mont_inv64(P);
+    for (size_t i = 0; i < len; i++) a[i] = smc_mont_mul64(a[i], a[i], P, n_inv);
+    smc_ntt(a, lg, true, threads);
+
+    /* Index k = i + j pairs odd primes summing to 2k + 2 */
+    size_t out = (size_t)(n_max / 2) + 1;
+    memset(counts, 0, out * sizeof(uint32_t));
+    for (size_t h = 2; h < out; h++) counts[h] = (uint32_t)smc_mont_mul64(a[h - 1], 1, P, n_inv);
+    if (n_max >= 4) counts[2] = 1;   /* 4 = 2 + 2 */
+    free(a);
+    return true;
+}
+
+/* ===========================================================================
+ * DIRECT VERIFICATION
+ * =========================================================================== */
+
+/* Small primes tried as p, in order */
+#ifndef SMC_GOLDBACH_PRIMES
+  #define SMC_GOLDBACH_PRIMES 8192
+#endif
+
+/* Evens per parallel task */
+#define SMC_GOLDBACH_BLOCK 65536
+
+typedef struct smc_goldbach_job {
+    uint64_t lo;                /* first even n */
+    uint64_t count;             /* evens to check */
+    uint32_t *min_p;            /* out: smallest p, or 0 if none found */
+    const uint32_t *primes;     /* odd primes 3, 5, 7, ... */
+    size_t nprimes;
+    volatile uint64_t missing;  /* n with no p in the table */
+} smc_goldbach_job;
+
+SMC_API void smc_goldbach_verify_task(void *ctx, size_t t) {
+    smc_goldbach_job *job = (smc_goldbach_job *)ctx;
+    uint64_t b = (uint64_t)t * SMC_GOLDBACH_BLOCK;
+    uint64_t e = job->count - b < SMC_GOLDBACH_BLOCK ? job->count : b + SMC_GOLDBACH_BLOCK;
+    uint64_t missing = 0;
+    for (uint64_t i = b; i < e; i++) {
+        uint64_t n = job->lo + 2 * i;
+        uint32_t found = 0;
+        if (n == 4) {
+            found = 2;
+        } else {
+            for (size_t k = 0; k < job->nprimes && job->primes[k] <= n / 2; k++) {
+                if (smc_is_prime64(n - job->primes[k])) { found = job->primes[k]; break; }
+            }
+        }
+        job->min_p[i] = found;
+        missing += found == 0 && n >= 4;
+    }
+    if (missing) smc_atomic_fetch_add64(&job->missing, missing);
+}
+
+/*
+ * For each even n in [lo, hi], the smallest prime p with n - p prime,
+ * stored as min_p[(n - lo') / 2] where lo' is lo rounded up to even.
+ * Entries for n < 4 are 0.
+ *
+ * Returns the number of n >= 4 for which no p among the first
+ * SMC_GOLDBACH_PRIMES primes worked (0 means the window is verified),
+ * or UINT64_MAX on allocation failure.
+ */
+SMC_API uint64_t smc_goldbach_verify(uint64_t lo, uint64_t hi, uint32_t *min_p, unsigned threads) {
+    if (lo == UINT64_MAX) return 0;     /* odd, and rounding up would wrap */
+    lo += lo & 1;
+    if (hi < lo) return 0;
+    size_t np = 0;
+    uint32_t *primes = smc_sieve_primes32(110000, &np);
+    if (primes == NULL) return UINT64_MAX;
+
+    smc_goldbach_job job;
+    job.lo = lo;
+    job.count = (hi - lo) / 2 + 1;
+    job.min_p = min_p;
+    job.primes = primes + 1;
+    job.nprimes = np - 1 < SMC_GOLDBACH_PRIMES ? np - 1 : SMC_GOLDBACH_PRIMES;
+    job.missing = 0;
+    size_t tasks = (size_t)((job.count + SMC_GOLDBACH_BLOCK - 1) / SMC_GOLDBACH_BLOCK);
+    smc_parallel_for(tasks, threads, smc_goldbach_verify_task, &job);
+    free(primes);
+    return job.missing;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_GOLDBACH_H */
@@ -0,0 +1,352 @@
+/*
+ * smcPrime - Succinct Prime Index (Elias-Fano)
+ *
+ * Stores the primes of a range [lo, hi) in Elias-Fano form:
+ * - l low bits per prime in a packed array
+ * - High parts as a unary-coded bitvector (n ones, (U >> l) + 1 zeros)
+ * - Sampled select1/select0 directories for O(1) nth-prime and pi(x)
+ *
+ * Around 6-7 bits per prime for ranges up to 2^36, versus 32/64 bits for
+ * a sorted integer array and ~2 ln(x) bits for an odd-only bitmap.
+ *
+ * The serialized form is a flat little header followed by 64-bit word
+ * arrays, so smc_ef_load can mmap it and query in place. Files use the
+ * host byte order.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_INDEX_H
+#define SMCPRIME_INDEX_H
+
+#include "smcprime.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__BMI2__)
+  #include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* One directory entry per this many ones (select1) or zeros (select0) */
+#define SMC_EF_SAMPLE 256
+
+#define SMC_EF_MAGIC   0x3130304645434D53ULL   /* "SMCEF001" */
+
+typedef struct smc_ef {
+    uint64_t lo, hi;            /* indexed range [lo, hi) */
+    uint64_t n;                 /* number of primes */
+    uint64_t l;                 /* low bits per element */
+    uint64_t high_bits;         /* length of the high bitvector */
+    const uint64_t *low;        /* packed low parts */
+    const uint64_t *high;       /* unary-coded high parts */
+    const uint64_t *sel1;       /* position of every SMC_EF_SAMPLE-th one */
+    const uint64_t *sel0;       /* position of every SMC_EF_SAMPLE-th zero */
+    uint64_t low_words, high_words, sel1_count, sel0_count;
+    const void *map;            /* file mapping when loaded, else NULL */
+    size_t map_len;
+    void *owned;                /* single heap block when built in memory */
+} smc_ef;
+
+/* On-disk header; word arrays follow in the order low, high, sel1, sel0 */
+typedef struct smc_ef_header {
+    uint64_t magic;
+    uint64_t lo, hi, n, l, high_bits;
+    uint64_t low_words, high_words, sel1_count, sel0_count;
+} smc_ef_header;
+
+/* ===========================================================================
+ * BIT SELECT
+ * =========================================================================== */
+
+/* Position of the r-th (0-based) set bit of x; x must have > r set bits */
+SMC_INLINE int smc_select64(uint64_t x, int r) {
+#if defined(__BMI2__)
+    return smc_ctz64(_pdep_u64(1ULL << r, x));
+#else
+    int pos = 0;
+    for (;;) {
+        int c = smc_popcount64(x & 0xFF);
+        if (r < c) break;
+        r -= c;
+        x >>= 8;
+        pos += 8;
+    }
+    while (r-- > 0) x &= x - 1;
+    return pos + smc_ctz64(x);
+#endif
+}
+
+/* Position of the i-th one (or zero when 'ones' is false) in v, using samples */
+SMC_INLINE uint64_t smc_ef_select(const uint64_t *v, const uint64_t *samples,
+                                  uint64_t i, bool ones) {
+    uint64_t pos = samples[i / SMC_EF_SAMPLE];
+    uint64_t r = i % SMC_EF_SAMPLE;
+    uint64_t w = pos >> 6;
+    uint64_t word = ones ? v[w] : ~v[w];
+    word &= ~0ULL << (pos & 63);
+    for (;;) {
+        uint64_t c = (uint64_t)smc_popcount64(word);
+        if (r < c) return (w << 6) + (uint64_t)smc_select64(word, (int)r);
+        r -= c;
+        w++;
+        word = ones ? v[w] : ~v[w];
+    }
+}
+
+SMC_INLINE uint64_t smc_ef_low(const smc_ef *ef, uint64_t i) {
+    if (ef->l == 0) return 0;
+    uint64_t bit = i * ef->l;
+    uint64_t w = bit >> 6, sh = bit & 63;
+    uint64_t x = ef->low[w] >> sh;
+    if (sh + ef->l > 64) x |= ef->low[w + 1] << (64 - sh);
+    return x & ((1ULL << ef->l) - 1);
+}
+
+/* ===========================================================================
+ * QUERIES
+ * =========================================================================== */
+
+/* k-th (0-based) prime of the range; k must be < ef->n */
+SMC_INLINE uint64_t smc_ef_nth(const smc_ef *ef, uint64_t k) {
+    uint64_t hi = smc_ef_select(ef->high, ef->sel1, k, true) - k;
+    return ef->lo + ((hi << ef->l) | smc_ef_low(ef, k));
+}
+
+/* Number of indexed primes <= x (pi(x) when lo <= 2) */
+SMC_INLINE uint64_t smc_ef_rank(const smc_ef *ef, uint64_t x) {
+    if (ef->n == 0 || x < ef->lo) return 0;
+    if (x >= ef->hi - 1) return ef->n;
+    uint64_t v = x - ef->lo;
+    uint64_t h = v >> ef->l;
+    uint64_t vl = v & ((1ULL << ef->l) - 1);
+    /* Skip all elements whose high part is below h */
+    uint64_t pos = h ? smc_ef_select(ef->high, ef->sel0, h - 1, false) + 1 : 0;
+    uint64_t k = pos - h;
+    /* Walk the (short) bucket of elements with high part == h */
+    while (k < ef->n && ((ef->high[pos >> 6] >> (pos & 63)) & 1)) {
+        if (smc_ef_low(ef, k) > vl) break;
+        k++;
+        pos++;
+    }
+    return k;
+}
+
+/* Bytes used by the encoded arrays (excluding the struct itself) */
+SMC_INLINE uint64_t smc_ef_bytes(const smc_ef *ef) {
+    return 8 * (ef->low_words + ef->high_words + ef->sel1_count + ef->sel0_count);
+}
+
+/* ===========================================================================
+ * CONSTRUCTION
+ * =========================================================================== */
+
+SMC_API void smc_ef_free(smc_ef *ef) {
+    if (ef->map) smc_unmap_file(ef->map, ef->map_len);
+    free(ef->owned);
+    memset(ef, 0, sizeof(*ef));
+}
+
+/* Point the array fields at a contiguous block laid out as on disk */
+SMC_API void smc_ef_attach(smc_ef *ef, const uint64_t *words) {
+    ef->low = words;
+    ef->high = ef->low + ef->low_words;
+    ef->sel1 = ef->high + ef->high_words;
+    ef->sel0 = ef->sel1 + ef->sel1_count;
+}
+
+/* Append element k with offset v = p - lo */
+SMC_INLINE void smc_ef_push(uint64_t *low, uint64_t *high, uint64_t l, uint64_t k, uint64_t v) {
+    if (l) {
+        uint64_t lv = v & ((1ULL << l) - 1);
+        uint64_t bit = k * l, w = bit >> 6, sh = bit & 63;
+        low[w] |= lv << sh;
+        if (sh + l > 64) low[w + 1] |= lv >> (64 - sh);
+    }
+    uint64_t pos = (v >> l) + k;
+    high[pos >> 6] |= 1ULL << (pos & 63);
+}
+
+/*
+ * Build the index of all primes in [lo, hi) from the segmented sieve.
+ *
+ * Two sieve passes: one to count (fixing n and l), one to encode, so
+ * peak memory is the final index plus one sieve segment.
+ * Returns false on allocation failure or an empty range.
+ */
+SMC_API bool smc_ef_build(smc_ef *ef, uint64_t lo, uint64_t hi) {
+    memset(ef, 0, sizeof(*ef));
+    if (hi <= lo) return false;
+    uint64_t n = smc_count_primes(lo, hi);
+    if (n == UINT64_MAX) return false;
+    uint64_t u = hi - lo;
+    uint64_t l = 0;
+    if (n > 0) while (l < 63 && (u / n) >> (l + 1)) l++;
+
+    ef->lo = lo;
+    ef->hi = hi;
+    ef->n = n;
+    ef->l = l;
+    ef->high_bits = n + (u >> l) + 1;
+    ef->low_words = (n * l + 63) / 64 + 1;
+    ef->high_words = (ef->high_bits + 63) / 64 + 1;
+    ef->sel1_count = n / SMC_EF_SAMPLE + 1;
+    ef->sel0_count = (ef->high_bits - n) / SMC_EF_SAMPLE + 1;
+
+    uint64_t total = ef->low_words + ef->high_words + ef->sel1_count + ef->sel0_count;
+    uint64_t *words = (uint64_t *)calloc((size_t)total, sizeof(uint64_t));
+    if (words == NULL) return false;
+    ef->owned = words;
+    smc_ef_attach(ef, words);
+    uint64_t *low = words;
+    uint64_t *high = low + ef->low_words;
+    uint64_t *sel1 = high + ef->high_words;
+    uint64_t *sel0 = sel1 + ef->sel1_count;
+
+    /* Encode pass */
+    uint64_t k = 0;
+    smc_sieve s;
+    if (!smc_sieve_init(&s, lo, hi)) { smc_ef_free(ef); return false; }
+    if (lo <= 2 && hi > 2) smc_ef_push(low, high, l, k++, 2 - lo);
+    while (smc_sieve_next(&s)) {
+        size_t sw = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < sw; w++) {
+            for (uint64_t m = s.bits[w]; m; m &= m - 1) {
+                uint64_t p = s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m));
+                smc_ef_push(low, high, l, k++, p - lo);
+            }
+        }
+    }
+    smc_sieve_free(&s);
+
+    /* Select directories, one word at a time */
+    uint64_t ones = 0, zeros = 0;
+    for (uint64_t w = 0; w * 64 < ef->high_bits; w++) {
+        uint64_t valid = ef->high_bits - w * 64;
+        uint64_t vmask = valid >= 64 ? ~0ULL : (1ULL << valid) - 1;
+        uint64_t x1 = high[w] & vmask, x0 = ~high[w] & vmask;
+        uint64_t c1 = (uint64_t)smc_popcount64(x1), c0 = (uint64_t)smc_popcount64(x0);
+        uint64_t next1 = (ones + SMC_EF_SAMPLE - 1) / SMC_EF_SAMPLE * SMC_EF_SAMPLE;
+        for (; next1 < ones + c1; next1 += SMC_EF_SAMPLE)
+            sel1[next1 / SMC_EF_SAMPLE] = w * 64 + (uint64_t)smc_select64(x1, (int)(next1 - ones));
+        uint64_t next0 = (zeros + SMC_EF_SAMPLE - 1) / SMC_EF_SAMPLE * SMC_EF_SAMPLE;
+        for (; next0 < zeros + c0; next0 += SMC_EF_SAMPLE)
+            sel0[next0 / SMC_EF_SAMPLE] = w * 64 + (uint64_t)smc_select64(x0, (int)(next0 - zeros));
+        ones += c1;
+        zeros += c0;
+    }
+    return true;
+}
+
+/* ===========================================================================
+ * SERIALIZATION
+ * =========================================================================== */
+
+/* Write the index to path. Returns false on I/O failure. */
+SMC_API bool smc_ef_save(const smc_ef *ef, const char *path) {
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) return false;
+    smc_ef_header h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SMC_EF_MAGIC;
+    h.lo = ef->lo; h.hi = ef->hi; h.n = ef->n; h.l = ef->l; h.high_bits = ef->high_bits;
+    h.low_words = ef->low_words; h.high_words = ef->high_words;
+    h.sel1_count = ef->sel1_count; h.sel0_count = ef->sel0_count;
+    bool ok = fwrite(&h, sizeof(h), 1, f) == 1
+        && fwrite(ef->low, 8, (size_t)ef->low_words, f) == ef->low_words
+        && fwrite(ef->high, 8, (size_t)ef->high_words, f) == ef->high_words
+        && fwrite(ef->sel1, 8, (size_t)ef->sel1_count, f) == ef->sel1_count
+        && fwrite(ef->sel0, 8, (size_t)ef->sel0_count, f) == ef->sel0_count;
+    return fclose(f) == 0 && ok;
+}
+
+/*
+ * True if the header fields of a mapped index agree with each other and
+ * with the file length: the sizes smc_ef_build derives from lo, hi and n.
+ */
+SMC_INLINE bool smc_ef_header_ok(const smc_ef_header *h, size_t len) {
+    if (len < sizeof(*h) || (len - sizeof(*h)) % 8 || h->magic != SMC_EF_MAGIC) return false;
+    uint64_t words = (len - sizeof(*h)) / 8;
+    if (h->hi <= h->lo) return false;
+    uint64_t u = h->hi - h->lo, n = h->n, l = 0;
+    if (n > u) return false;
+    if (n > 0) while (l < 63 && (u / n) >> (l + 1)) l++;
+    if (h->l != l || (u >> l) >= UINT64_MAX - n) return false;
+    uint64_t high_bits = n + (u >> l) + 1;
+    return h->high_bits == high_bits
+        && h->low_words == (n * l + 63) / 64 + 1
+        && h->high_words == (high_bits + 63) / 64 + 1
+        && h->sel1_count == n / SMC_EF_SAMPLE + 1
+        && h->sel0_count == (high_bits - n) / SMC_EF_SAMPLE + 1
+        && h->low_words <= words && h->high_words <= words - h->low_words
+        && h->sel1_count <= words - h->low_words - h->high_words
+        && h->sel0_count == words - h->low_words - h->high_words - h->sel1_count;
+}
+
+/*
+ * True if the high bitvector holds exactly n ones and the select samples
+ * point where smc_ef_build puts them, so every select stays inside the
+ * arrays. One pass over the high words.
+ */
+SMC_API bool smc_ef_select_ok(const smc_ef *ef) {
+    uint64_t ones = 0, zeros = 0;
+    for (uint64_t w = 0; w * 64 < ef->high_bits; w++) {
+        uint64_t valid = ef->high_bits - w * 64;
+        uint64_t vmask = valid >= 64 ? ~0ULL : (1ULL << valid) - 1;
+        uint64_t x1 = ef->high[w] & vmask, x0 = ~ef->high[w] & vmask;
+        uint64_t c1 = (uint64_t)smc_popcount64(x1), c0 = (uint64_t)smc_popcount64(x0);
+        if (ones + c1 > ef->n) return false;
+        uint64_t next1 = (ones + SMC_EF_SAMPLE - 1) / SMC_EF_SAMPLE * SMC_EF_SAMPLE;
+        for (; next1 < ones + c1; next1 += SMC_EF_SAMPLE)
+            if (ef->sel1[next1 / SMC_EF_SAMPLE] != w * 64 + (uint64_t)smc_select64(x1, (int)(next1 - ones))) return false;
+        uint64_t next0 = (zeros + SMC_EF_SAMPLE - 1) / SMC_EF_SAMPLE * SMC_EF_SAMPLE;
+        for (; next0 < zeros + c0; next0 += SMC_EF_SAMPLE)
+            if (ef->sel0[next0 / SMC_EF_SAMPLE] != w * 64 + (uint64_t)smc_select64(x0, (int)(next0 - zeros))) return false;
+        ones += c1;
+        zeros += c0;
+    }
+    return ones == ef->n;
+}
+
+/*
+ * Map an index written by smc_ef_save. Returns false if missing or
+ * malformed: header sizes that disagree with each other or the file
+ * length, or a high bitvector / select directory that would send a query
+ * out of bounds. The low parts are not checked; corrupt ones give wrong
+ * answers but stay in bounds.
+ */
+SMC_API bool smc_ef_load(smc_ef *ef, const char *path) {
+    memset(ef, 0, sizeof(*ef));
+    size_t len = 0;
+    const void *map = smc_map_file(path, &len);
+    if (map == NULL) return false;
+    const smc_ef_header *h = (const smc_ef_header *)map;
+    if (!smc_ef_header_ok(h, len)) {
+        smc_unmap_file(map, len);
+        return false;
+    }
+    ef->lo = h->lo; ef->hi = h->hi; ef->n = h->n; ef->l = h->l; ef->high_bits = h->high_bits;
+    ef->low_words = h->low_words; ef->high_words = h->high_words;
+    ef->sel1_count = h->sel1_count; ef->sel0_count = h->sel0_count;
+    ef->map = map;
+    ef->map_len = len;
+    smc_ef_attach(ef, (const uint64_t *)(h + 1));
+    if (!smc_ef_select_ok(ef)) {
+        smc_ef_free(ef);
+        return false;
+    }
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_INDEX_H */
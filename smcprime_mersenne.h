@@ -0,0 +1,572 @@
+/*
+ * smcPrime - Mersenne Numbers
+ *
+ * Lucas-Lehmer test for M_p = 2^p - 1:
+ * - p < 64: 64-bit special-form kernel
+ * - p < 128: 128-bit special-form kernel (needs __int128)
+ * - larger p: multiprecision Karatsuba squaring, reduced by folding the
+ *   high half back onto the low half (2^p = 1 mod M_p)
+ *
+ * Trial factoring: every factor of M_p is q = 2kp + 1 with q = +-1 (mod 8).
+ * - k splits into 4620 classes mod 4 * 3 * 5 * 7 * 11; the 960 classes
+ *   allowed by q mod 8 and the four primes run as separate tasks
+ * - Within a class, k is sieved by the primes up to
+ *   SMC_MERSENNE_TF_SIEVE in L1-sized segments
+ * - Survivors are checked sixteen at a time for 2^p = 1 (mod q), q < 2^96,
+ *   in two-limb Montgomery form: 52-bit limbs on two AVX-512 IFMA
+ *   vectors, otherwise 64-bit limbs with the sixteen chains interleaved
+ *
+ * POSIX builds using trial factoring must link with -pthread.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_MERSENNE_H
+#define SMCPRIME_MERSENNE_H
+
+#include "smcprime.h"
+#include "smcprime_mp.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX512IFMA__) && defined(__AVX512F__)
+  #include <immintrin.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===========================================================================
+ * LUCAS-LEHMER
+ * =========================================================================== */
+
+/*
+ * Deterministic primality of M_p = 2^p - 1.
+ *
+ * s_0 = 4, s_{i+1} = s_i^2 - 2 (mod M_p); M_p is prime iff s_{p-2} = 0.
+ * Returns false for composite p (M_p is then composite) and on
+ * allocation failure.
+ */
+SMC_API bool smc_lucas_lehmer(uint32_t p) {
+    if (p == 2) return true;
+    if (!smc_is_prime32(p)) return false;
+
+    if (p < 64) {
+        uint64_t m = (1ULL << p) - 1, s = 4;
+        for (uint32_t i = 0; i < p - 2; i++) {
+            s = smc_pmod_mul64(s, s, p, 1);
+            s = s >= 2 ? s - 2 : s + m - 2;
+        }
+        return s == 0;
+    }
+#if defined(__SIZEOF_INT128__)
+    if (p < 128) {
+        smc_u128 m = ((smc_u128)1 << p) - 1, s = 4;
+        for (uint32_t i = 0; i < p - 2; i++) {
+            s = smc_pmod_mul128(s, s, p, 1);
+            s = s >= 2 ? s - 2 : s + m - 2;
+        }
+        return s == 0;
+    }
+#endif
+
+    size_t n = (p + 63) / 64;
+    uint64_t *s = (uint64_t *)calloc(n, sizeof(uint64_t));
+    uint64_t *sq = (uint64_t *)malloc((2 * n + 2) * sizeof(uint64_t));
+    uint64_t *tmp = (uint64_t *)malloc((2 * n + 1) * sizeof(uint64_t));
+    uint64_t *kt = (uint64_t *)malloc(smc_mpn_mul_scratch(n) * sizeof(uint64_t));
+    if (!s || !sq || !tmp || !kt) { free(s); free(sq); free(tmp); free(kt); return false; }
+
+    uint64_t top_mask = p % 64 ? (1ULL << (p % 64)) - 1 : ~0ULL;
+    s[0] = 4;
+    for (uint32_t i = 0; i < p - 2; i++) {
+        smc_mpn_kara(sq, s, s, n, kt);
+        smc_mpn_mod_pm(sq, 2 * n, p, 1, tmp);
+        memcpy(s, sq, n * sizeof(uint64_t));
+        if (smc_mpn_normalize(s, n) > 1 || s[0] >= 2) {
+            smc_mpn_sub_1(s, s, n, 2);
+        } else {
+            /* s - 2 + M_p with s in {0, 1}: all ones minus (2 - s) */
+            uint64_t d = 2 - s[0];
+            memset(s, 0xFF, n * sizeof(uint64_t));
+            s[n - 1] &= top_mask;
+            smc_mpn_sub_1(s, s, n, d);
+        }
+    }
+    bool prime = smc_mpn_normalize(s, n) == 0;
+    free(s); free(sq); free(tmp); free(kt);
+    return prime;
+}
+
+/* ===========================================================================
+ * TRIAL FACTORING
+ * =========================================================================== */
+
+/* Sieving primes for the k classes stay below this */
+#ifndef SMC_MERSENNE_TF_SIEVE
+  #define SMC_MERSENNE_TF_SIEVE (1u << 16)
+#endif
+
+/* k mod 4 * 3 * 5 * 7 * 11 */
+#define SMC_MERSENNE_TF_CLASSES 4620
+
+/* Candidates per exponentiation batch */
+#define SMC_MERSENNE_TF_LANES 16
+
+#ifndef SMC_MASK52
+  #define SMC_MASK52 ((1ULL << 52) - 1)
+#endif
+
+/* q = 2kp + 1 as (lo, hi); false if q >= 2^96 */
+SMC_INLINE bool smc_mersenne_tf_q(uint32_t p, uint64_t k, uint64_t *lo, uint64_t *hi) {
+    *lo = smc_mul64_wide(k, 2 * (uint64_t)p, hi) + 1;
+    return *hi >> 32 == 0;
+}
+
+/* x - q if x >= q, for two-limb x < 2q < 2^97; selects rather than branches, as both are equally likely */
+SMC_INLINE void smc_sub_if_ge2(uint64_t *x0, uint64_t *x1, uint64_t q0, uint64_t q1) {
+    uint64_t b = *x0 < q0, d0 = *x0 - q0, d1 = *x1 - q1 - b;
+    uint64_t keep = 0 - (uint64_t)(*x1 < q1 + b);          /* borrow out: x < q */
+    *x0 = (*x0 & keep) | (d0 & ~keep);
+    *x1 = (*x1 & keep) | (d1 & ~keep);
+}
+
+/*
+ * a b / 2^128 mod q for two-limb a, b < q < 2^96, with inv = -q^-1 mod 2^64
+ * (coarsely integrated Montgomery, one limb of b per round).
+ */
+SMC_INLINE void smc_mont_mul2(uint64_t *r0, uint64_t *r1, uint64_t a0, uint64_t a1, uint64_t b0, uint64_t b1,
+                              uint64_t q0, uint64_t q1, uint64_t inv) {
+    uint64_t t0 = 0, t1 = 0, b[2] = {b0, b1};
+    for (int i = 0; i < 2; i++) {
+        uint64_t h0, l0 = smc_mul64_wide(a0, b[i], &h0);
+        uint64_t h1, l1 = smc_mul64_wide(a1, b[i], &h1);
+        uint64_t u0 = t0 + l0, c = u0 < l0;
+        uint64_t u1 = t1 + h0, c1 = u1 < h0;
+        u1 += c;
+        c1 += u1 < c;
+        u1 += l1;
+        c1 += u1 < l1;
+        uint64_t u2 = h1 + c1;
+        uint64_t m = u0 * inv;
+        uint64_t g0, k0 = smc_mul64_wide(m, q0, &g0);
+        uint64_t g1, k1 = smc_mul64_wide(m, q1, &g1);
+        c = u0 + k0 < k0;                       /* the low limb cancels */
+        uint64_t v1 = u1 + g0, d = v1 < g0;
+        v1 += c;
+        d += v1 < c;
+        v1 += k1;
+        d += v1 < k1;
+        t0 = v1;
+        t1 = u2 + g1 + d;
+    }
+    smc_sub_if_ge2(&t0, &t1, q0, q1);
+    *r0 = t0;
+    *r1 = t1;
+}
+
+/* 2x mod q for x < q < 2^96 */
+SMC_INLINE void smc_dbl2(uint64_t *x0, uint64_t *x1, uint64_t q0, uint64_t q1) {
+    *x1 = (*x1 << 1) | (*x0 >> 63);
+    *x0 <<= 1;
+    smc_sub_if_ge2(x0, x1, q0, q1);
+}
+
+/*
+ * 2^128 mod q for odd q < 2^96: one step of Knuth's algorithm D on the
+ * normalized divisor (2^64 mod q squared when q fits one limb).
+ */
+SMC_INLINE void smc_r128_mod2(uint64_t q0, uint64_t q1, uint64_t *r0, uint64_t *r1) {
+    uint64_t hi, lo, r;
+    if (q1 == 0) {
+        uint64_t t = UINT64_MAX % q0 + 1;
+        if (t == q0) t = 0;
+        lo = smc_mul64_wide(t, t, &hi);
+        smc_udiv128_64(hi, lo, q0, &r);
+        *r0 = r;
+        *r1 = 0;
+        return;
+    }
+    /* 2^(128 + s) / (q << s), a single quotient limb */
+    unsigned s = (unsigned)smc_clz64(q1);
+    uint64_t v1 = s ? (q1 << s) | (q0 >> (64 - s)) : q1, v0 = q0 << s, u2 = 1ULL << s;
+    uint64_t qh, rh;
+    bool rbig = false;
+    if (u2 >= v1) {
+        qh = UINT64_MAX;
+        rh = v1;
+    } else {
+        qh = smc_udiv128_64(u2, 0, v1, &rh);
+    }
+    for (;;) {
+        lo = smc_mul64_wide(qh, v0, &hi);
+        if (rbig || hi < rh || (hi == rh && lo == 0)) break;
+        qh--;
+        rh += v1;
+        rbig = rh < v1;
+    }
+    /* (u2, 0, 0) - qh * (v1, v0) */
+    uint64_t ph, pl = smc_mul64_wide(qh, v1, &ph);
+    uint64_t m1 = pl + hi, m2 = ph + (m1 < pl);
+    uint64_t d0 = 0 - lo, b = lo != 0;
+    uint64_t d1 = 0 - m1 - b;
+    b = (m1 != 0) | (b & (m1 == 0));
+    uint64_t d2 = u2 - m2 - b;
+    if (d2 >> 63) {                             /* qh was one too large */
+        d0 += v0;
+        uint64_t c = d0 < v0;
+        d1 += v1 + c;
+    }
+    *r0 = s ? (d0 >> s) | (d1 << (64 - s)) : d0;
+    *r1 = s ? d1 >> s : d1;
+}
+
+/*
+ * Bit i set iff 2k_i p + 1 divides M_p, for SMC_MERSENNE_TF_LANES values
+ * of k (all q < 2^96): 2^p by left-to-right squaring, each 1 bit of p a
+ * modular doubling, from R = 2^128 mod q. Eight independent chains at a
+ * time interleave; more spill registers.
+ */
+SMC_API unsigned smc_mersenne_tf_lanes_scalar(const uint64_t *k, uint32_t p) {
+    unsigned mask = 0;
+    for (int g = 0; g < SMC_MERSENNE_TF_LANES; g += 8) {
+        uint64_t q0[8], q1[8], inv[8], x0[8], x1[8], o0[8], o1[8];
+        for (int l = 0; l < 8; l++) {
+            smc_mersenne_tf_q(p, k[g + l], &q0[l], &q1[l]);
+            inv[l] = 0 - smc_mont_inv64(q0[l]);
+            smc_r128_mod2(q0[l], q1[l], &o0[l], &o1[l]);
+            x0[l] = o0[l];
+            x1[l] = o1[l];
+            smc_dbl2(&x0[l], &x1[l], q0[l], q1[l]);
+        }
+        for (int i = 62 - smc_clz64(p); i >= 0; i--) {
+            bool one = (p >> i) & 1;
+            for (int l = 0; l < 8; l++) {
+                smc_mont_mul2(&x0[l], &x1[l], x0[l], x1[l], x0[l], x1[l], q0[l], q1[l], inv[l]);
+                if (one) smc_dbl2(&x0[l], &x1[l], q0[l], q1[l]);
+            }
+        }
+        for (int l = 0; l < 8; l++) mask |= (unsigned)(x0[l] == o0[l] && x1[l] == o1[l]) << (g + l);
+    }
+    return mask;
+}
+
+#if defined(__AVX512IFMA__) && defined(__AVX512F__)
+
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic push
+  #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+/* x - q if x >= q, on 52-bit limb pairs */
+SMC_INLINE void smc_sub_if_ge52x2(__m512i *x0, __m512i *x1, __m512i q0, __m512i q1) {
+    const __m512i mask = _mm512_set1_epi64((long long)SMC_MASK52);
+    __m512i d0 = _mm512_sub_epi64(*x0, q0);
+    __m512i d1 = _mm512_sub_epi64(_mm512_sub_epi64(*x1, q1), _mm512_srli_epi64(d0, 63));
+    __mmask8 ge = _mm512_cmpge_epi64_mask(d1, _mm512_setzero_si512());
+    *x0 = _mm512_mask_and_epi64(*x0, ge, d0, mask);
+    *x1 = _mm512_mask_mov_epi64(*x1, ge, d1);
+}
+
+/* a b / 2^104 mod q on eight lanes, q < 2^96 as 52-bit limbs, inv = -q^-1 mod 2^52 */
+SMC_INLINE void smc_mont_mul52x2(__m512i *r0, __m512i *r1, __m512i a0, __m512i a1, __m512i b0, __m512i b1,
+                                 __m512i q0, __m512i q1, __m512i inv) {
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i mask = _mm512_set1_epi64((long long)SMC_MASK52);
+    __m512i t0 = _mm512_madd52lo_epu64(zero, a0, b0);
+    __m512i t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(zero, a0, b0), a1, b0);
+    __m512i t2 = _mm512_madd52hi_epu64(zero, a1, b0);
+    __m512i m = _mm512_madd52lo_epu64(zero, t0, inv);
+    t0 = _mm512_madd52lo_epu64(t0, m, q0);
+    t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(t1, m, q0), m, q1);
+    t2 = _mm512_madd52hi_epu64(t2, m, q1);
+    t0 = _mm512_add_epi64(t1, _mm512_srli_epi64(t0, 52));
+    t0 = _mm512_madd52lo_epu64(t0, a0, b1);
+    t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(t2, a0, b1), a1, b1);
+    t2 = _mm512_madd52hi_epu64(zero, a1, b1);
+    m = _mm512_madd52lo_epu64(zero, t0, inv);
+    t0 = _mm512_madd52lo_epu64(t0, m, q0);
+    t1 = _mm512_madd52lo_epu64(_mm512_madd52hi_epu64(t1, m, q0), m, q1);
+    t2 = _mm512_madd52hi_epu64(t2, m, q1);
+    t1 = _mm512_add_epi64(t1, _mm512_srli_epi64(t0, 52));
+    *r0 = _mm512_and_si512(t1, mask);
+    *r1 = _mm512_add_epi64(t2, _mm512_srli_epi64(t1, 52));
+    smc_sub_if_ge52x2(r0, r1, q0, q1);
+}
+
+/* 2x mod q on 52-bit limb pairs */
+SMC_INLINE void smc_dbl52x2(__m512i *x0, __m512i *x1, __m512i q0, __m512i q1) {
+    const __m512i mask = _mm512_set1_epi64((long long)SMC_MASK52);
+    __m512i l = _mm512_slli_epi64(*x0, 1);
+    *x1 = _mm512_add_epi64(_mm512_slli_epi64(*x1, 1), _mm512_srli_epi64(l, 52));
+    *x0 = _mm512_and_si512(l, mask);
+    smc_sub_if_ge52x2(x0, x1, q0, q1);
+}
+
+/* smc_mersenne_tf_lanes_scalar with R = 2^104 on two interleaved AVX-512 vectors */
+SMC_API unsigned smc_mersenne_tf_lanes_ifma(const uint64_t *k, uint32_t p) {
+    uint64_t a[SMC_MERSENNE_TF_LANES], b[SMC_MERSENNE_TF_LANES], c[SMC_MERSENNE_TF_LANES];
+    int w = 127;
+    for (int l = 0; l < SMC_MERSENNE_TF_LANES; l++) {
+        uint64_t lo, hi;
+        smc_mersenne_tf_q(p, k[l], &lo, &hi);
+        a[l] = lo & SMC_MASK52;
+        b[l] = (lo >> 52) | (hi << 12);
+        c[l] = (0 - smc_mont_inv64(lo)) & SMC_MASK52;
+        int bits = hi ? 127 - smc_clz64(hi) : 63 - smc_clz64(lo);
+        if (bits < w) w = bits;
+    }
+    /* R mod q by doubling the power of two below the smallest q */
+    __m512i q0[2], q1[2], inv[2], o0[2], o1[2], x0[2], x1[2];
+    for (int h = 0; h < 2; h++) {
+        q0[h] = _mm512_loadu_si512(a + 8 * h);
+        q1[h] = _mm512_loadu_si512(b + 8 * h);
+        inv[h] = _mm512_loadu_si512(c + 8 * h);
+        o0[h] = _mm512_set1_epi64(w < 52 ? (long long)(1ULL << w) : 0);
+        o1[h] = _mm512_set1_epi64(w < 52 ? 0 : (long long)(1ULL << (w - 52)));
+    }
+    for (int i = w; i < 104; i++) {
+        for (int h = 0; h < 2; h++) smc_dbl52x2(&o0[h], &o1[h], q0[h], q1[h]);
+    }
+    for (int h = 0; h < 2; h++) {
+        x0[h] = o0[h];
+        x1[h] = o1[h];
+        smc_dbl52x2(&x0[h], &x1[h], q0[h], q1[h]);
+    }
+    for (int i = 62 - smc_clz64(p); i >= 0; i--) {
+        bool one = (p >> i) & 1;
+        for (int h = 0; h < 2; h++) {
+            smc_mont_mul52x2(&x0[h], &x1[h], x0[h], x1[h], x0[h], x1[h], q0[h], q1[h], inv[h]);
+            if (one) smc_dbl52x2(&x0[h], &x1[h], q0[h], q1[h]);
+        }
+    }
+    unsigned mask = 0;
+    for (int h = 0; h < 2; h++) {
+        mask |= (unsigned)(_mm512_cmpeq_epi64_mask(x0[h], o0[h]) & _mm512_cmpeq_epi64_mask(x1[h], o1[h])) << (8 * h);
+    }
+    return mask;
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+  #pragma GCC diagnostic pop
+#endif
+
+#define smc_mersenne_tf_lanes smc_mersenne_tf_lanes_ifma
+#else
+#define smc_mersenne_tf_lanes smc_mersenne_tf_lanes_scalar
+#endif
+
+/* Whether 2kp + 1 divides M_p (false for q >= 2^96) */
+SMC_API bool smc_mersenne_tf_test(uint32_t p, uint64_t k) {
+    uint64_t lo, hi, ks[SMC_MERSENNE_TF_LANES];
+    if (k == 0 || !smc_mersenne_tf_q(p, k, &lo, &hi)) return false;
+    for (int l = 0; l < SMC_MERSENNE_TF_LANES; l++) ks[l] = k;
+    return smc_mersenne_tf_lanes(ks, p) & 1;
+}
+
+typedef struct smc_mersenne_tf_stats {
+    uint64_t candidates;        /* k in the range */
+    uint64_t tested;            /* survivors of the sieve, exponentiated */
+    double seconds;
+    double rate;                /* tested per second per thread */
+} smc_mersenne_tf_stats;
+
+typedef struct smc_mersenne_tf_job {
+    uint32_t p;
+    uint64_t k_lo, k_hi;
+    const uint32_t *primes;     /* sieving primes from 13 */
+    const uint32_t *pinv;       /* (2p * 4620)^-1 mod r, 0 if r = p */
+    const uint32_t *p2;         /* 2p mod r */
+    size_t np;
+    const uint16_t *classes;
+    volatile uint64_t best;     /* smallest k found, UINT64_MAX if none */
+    volatile uint64_t tested;
+    volatile uint64_t failed;
+} smc_mersenne_tf_job;
+
+SMC_INLINE void smc_mersenne_tf_flush(smc_mersenne_tf_job *job, uint64_t *ks, unsigned n) {
+    for (unsigned l = n; l < SMC_MERSENNE_TF_LANES; l++) ks[l] = ks[0];
+    unsigned hit = smc_mersenne_tf_lanes(ks, job->p) & ((1u << n) - 1);
+    for (; hit; hit &= hit - 1) {
+        uint64_t k = ks[smc_ctz64(hit)], cur = smc_atomic_load64(&job->best);
+        while (k < cur && !smc_atomic_cas64(&job->best, cur, k)) cur = smc_atomic_load64(&job->best);
+    }
+}
+
+/* One class c: k = c + 4620 i, sieved in segments of i */
+SMC_API void smc_mersenne_tf_task(void *arg, size_t index) {
+    smc_mersenne_tf_job *job = (smc_mersenne_tf_job *)arg;
+    const uint64_t m = SMC_MERSENNE_TF_CLASSES;
+    uint64_t c = job->classes[index];
+    uint64_t i_lo = job->k_lo > c ? (job->k_lo - c + m - 1) / m : 0;
+    uint64_t i_hi = job->k_hi > c ? (job->k_hi - c + m - 1) / m : 0;
+    if (i_hi <= i_lo) return;
+
+    size_t seg_bits = smc_sieve_segment_bytes(job->np) * 8;
+    uint64_t *bits = (uint64_t *)malloc(seg_bits / 8);
+    uint32_t *next = (uint32_t *)malloc((job->np + 1) * sizeof(uint32_t));
+    if (bits == NULL || next == NULL) {
+        free(bits);
+        free(next);
+        smc_atomic_store64(&job->failed, 1);
+        return;
+    }
+    /* first i >= i_lo with r | 2p (c + 4620 i) + 1 */
+    for (size_t j = 0; j < job->np; j++) {
+        uint64_t r = job->primes[j];
+        if (job->pinv[j] == 0) { next[j] = UINT32_MAX; continue; }
+        uint64_t t = (job->p2[j] * (c % r) + 1) % r;
+        uint64_t root = (r - t) % r * job->pinv[j] % r;
+        next[j] = (uint32_t)((root + r - i_lo % r) % r);
+    }
+
+    uint64_t ks[SMC_MERSENNE_TF_LANES], tested = 0;
+    unsigned nk = 0;
+    for (uint64_t base = i_lo; base < i_hi; base += seg_bits) {
+        size_t len = i_hi - base < seg_bits ? (size_t)(i_hi - base) : seg_bits;
+        memset(bits, 0xFF, seg_bits / 8);
+        for (size_t j = 0; j < job->np; j++) {
+            uint32_t r = job->primes[j];
+            size_t o = next[j];
+            if (o == UINT32_MAX) continue;
+            for (; o < len; o += r) bits[o / 64] &= ~(1ULL << (o % 64));
+            next[j] = (uint32_t)(o - len);
+        }
+        size_t words = (len + 63) / 64;
+        if (len % 64) bits[words - 1] &= (1ULL << (len % 64)) - 1;
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t b = bits[w]; b; b &= b - 1) {
+                ks[nk++] = c + m * (base + 64 * w + (uint64_t)smc_ctz64(b));
+                if (nk == SMC_MERSENNE_TF_LANES) {
+                    smc_mersenne_tf_flush(job, ks, nk);
+                    tested += nk;
+                    nk = 0;
+                }
+            }
+        }
+    }
+    if (nk) smc_mersenne_tf_flush(job, ks, nk);
+    tested += nk;
+    smc_atomic_fetch_add64(&job->tested, tested);
+    free(bits);
+    free(next);
+}
+
+/*
+ * Smallest k in [k_lo, k_hi) with 2kp + 1 dividing M_p, for prime p > 11
+ * and every q = 2kp + 1 in the range below 2^96; 0 if there is none,
+ * UINT64_MAX on invalid input or allocation failure. Sieving primes
+ * stop below 2 k_lo p + 1, so none of them can be q itself. The classes
+ * run on up to 'threads' threads (0 = all); st (may be NULL) receives the
+ * counts and the throughput.
+ */
+SMC_API uint64_t smc_mersenne_tf_range(uint32_t p, uint64_t k_lo, uint64_t k_hi, unsigned threads,
+                                       smc_mersenne_tf_stats *st) {
+    uint64_t lo, hi;
+    if (k_lo == 0) k_lo = 1;
+    if (st) memset(st, 0, sizeof(*st));
+    if (p <= 11 || !smc_is_prime32(p) || (k_hi > k_lo && !smc_mersenne_tf_q(p, k_hi - 1, &lo, &hi)))
+        return UINT64_MAX;
+    if (k_hi <= k_lo) return 0;
+    double start = smc_seconds();
+    if (threads == 0) threads = smc_thread_count();
+
+    /* classes with q = +-1 (mod 8) and q prime to 3, 5, 7, 11 */
+    uint16_t *classes = (uint16_t *)malloc(SMC_MERSENNE_TF_CLASSES * sizeof(uint16_t));
+    if (classes == NULL) return UINT64_MAX;
+    size_t nc = 0;
+    for (uint32_t c = 0; c < SMC_MERSENNE_TF_CLASSES; c++) {
+        uint64_t q8 = (2 * (uint64_t)p * c + 1) % 8;
+        if (q8 != 1 && q8 != 7) continue;
+        bool ok = true;
+        for (uint32_t r = 3; r <= 11 && ok; r += 2) {
+            if (r != 9) ok = (2 * (uint64_t)p * c + 1) % r != 0;
+        }
+        if (ok) classes[nc++] = (uint16_t)c;
+    }
+
+    uint64_t qmin = 2 * (uint64_t)p * k_lo + 1;
+    uint32_t limit = k_lo > UINT32_MAX / 2 / p || qmin > SMC_MERSENNE_TF_SIEVE ? SMC_MERSENNE_TF_SIEVE : (uint32_t)qmin;
+    size_t np = 0;
+    uint32_t *primes = smc_sieve_primes32(limit > 13 ? limit - 1 : 13, &np);
+    uint32_t *aux = (uint32_t *)malloc((2 * np + 1) * sizeof(uint32_t));
+    if (primes == NULL || aux == NULL) {
+        free(classes);
+        free(primes);
+        free(aux);
+        return UINT64_MAX;
+    }
+    /* drop 2 .. 11 */
+    size_t skip = 0;
+    while (skip < np && primes[skip] < 13) skip++;
+    np -= skip;
+    memmove(primes, primes + skip, np * sizeof(uint32_t));
+    uint32_t *pinv = aux, *p2 = aux + np;
+    for (size_t j = 0; j < np; j++) {
+        uint32_t r = primes[j];
+        p2[j] = (uint32_t)(2 * (uint64_t)p % r);
+        uint64_t step = (uint64_t)p2[j] * (SMC_MERSENNE_TF_CLASSES % r) % r;
+        pinv[j] = step ? (uint32_t)smc_modinv64(step, r) : 0;
+    }
+
+    smc_mersenne_tf_job job;
+    job.p = p;
+    job.k_lo = k_lo;
+    job.k_hi = k_hi;
+    job.primes = primes;
+    job.pinv = pinv;
+    job.p2 = p2;
+    job.np = np;
+    job.classes = classes;
+    job.best = UINT64_MAX;
+    job.tested = 0;
+    job.failed = 0;
+    smc_parallel_for(nc, threads, smc_mersenne_tf_task, &job);
+    free(classes);
+    free(primes);
+    free(aux);
+    if (job.failed) return UINT64_MAX;
+
+    if (st) {
+        st->candidates = k_hi - k_lo;
+        st->tested = job.tested;
+        st->seconds = smc_seconds() - start;
+        unsigned used = (size_t)threads < nc ? threads : (unsigned)nc;
+        st->rate = st->seconds > 0 ? (double)job.tested / st->seconds / used : 0;
+    }
+    return job.best == UINT64_MAX ? 0 : job.best;
+}
+
+/* Smallest k >= 1 with 2kp + 1 >= 2^bits (bits <= 96); UINT64_MAX if it needs more than 64 bits */
+SMC_API uint64_t smc_mersenne_tf_k(uint32_t p, unsigned bits) {
+    if (bits > 96) return UINT64_MAX;
+    uint64_t x[2], q[2];
+    x[0] = bits >= 64 ? UINT64_MAX : (1ULL << bits) - 1;
+    x[1] = bits > 64 ? (1ULL << (bits - 64)) - 1 : 0;
+    uint64_t r = smc_mpn_divrem_1(q, x, 2, 2 * (uint64_t)p);
+    if (q[1] != 0 || (r != 0 && q[0] == UINT64_MAX)) return UINT64_MAX;
+    uint64_t k = q[0] + (r != 0);
+    return k ? k : 1;
+}
+
+/*
+ * Trial-factor M_p over q in [2^bits_lo, 2^bits_hi), bits_hi <= 96, as
+ * smc_mersenne_tf_range; the factor is 2kp + 1 for the k returned.
+ */
+SMC_API uint64_t smc_mersenne_tf(uint32_t p, unsigned bits_lo, unsigned bits_hi, unsigned threads,
+                                 smc_mersenne_tf_stats *st) {
+    if (p == 0) return UINT64_MAX;
+    uint64_t k_lo = smc_mersenne_tf_k(p, bits_lo), k_hi = smc_mersenne_tf_k(p, bits_hi);
+    if (k_lo == UINT64_MAX || k_hi == UINT64_MAX) return UINT64_MAX;
+    return smc_mersenne_tf_range(p, k_lo, k_hi, threads, st);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_MERSENNE_H */
@@ -0,0 +1,566 @@
+/*
+ * smcPrime - Multiprecision Arithmetic
+ *
+ * Natural numbers as little-endian arrays of 64-bit limbs, in the style of
+ * GMP's mpn layer: callers own the buffers and pass limb counts.
+ * - Add/subtract/shift/compare, single-limb multiply-accumulate
+ * - Schoolbook multiplication and squaring below SMC_MP_KARATSUBA limbs,
+ *   Karatsuba above
+ * - Schoolbook division (Knuth's algorithm D) and Euclid's gcd
+ * - Special-form reduction modulo 2^k - c (Mersenne and pseudo-Mersenne)
+ *   for multi-limb values and for 128-bit operands
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_MP_H
+#define SMCPRIME_MP_H
+
+#include "smcprime.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Operand size (limbs) from which multiplication switches to Karatsuba */
+#ifndef SMC_MP_KARATSUBA
+  #define SMC_MP_KARATSUBA 32
+#endif
+
+/* ===========================================================================
+ * BASIC OPERATIONS
+ * =========================================================================== */
+
+/* Limb count without leading zeros */
+SMC_INLINE size_t smc_mpn_normalize(const uint64_t *a, size_t n) {
+    while (n > 0 && a[n - 1] == 0) n--;
+    return n;
+}
+
+SMC_INLINE int smc_mpn_cmp(const uint64_t *a, const uint64_t *b, size_t n) {
+    while (n-- > 0) {
+        if (a[n] != b[n]) return a[n] > b[n] ? 1 : -1;
+    }
+    return 0;
+}
+
+/* r = a + b (n limbs each); returns the carry. r may alias a or b. */
+SMC_INLINE uint64_t smc_mpn_add_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+    uint64_t cy = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t s = a[i] + cy;
+        cy = s < cy;
+        r[i] = s + b[i];
+        cy += r[i] < s;
+    }
+    return cy;
+}
+
+/* r = a - b (n limbs each); returns the borrow. r may alias a or b. */
+SMC_INLINE uint64_t smc_mpn_sub_n(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n) {
+    uint64_t bw = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = a[i] - b[i];
+        uint64_t b1 = d > a[i];
+        r[i] = d - bw;
+        bw = b1 + (r[i] > d);
+    }
+    return bw;
+}
+
+/* r = a + v (n limbs); returns the carry */
+SMC_INLINE uint64_t smc_mpn_add_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t v) {
+    for (size_t i = 0; i < n; i++) {
+        r[i] = a[i] + v;
+        v = r[i] < v;
+    }
+    return v;
+}
+
+/* r = a - v (n limbs); returns the borrow */
+SMC_INLINE uint64_t smc_mpn_sub_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t v) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x = a[i];
+        r[i] = x - v;
+        v = r[i] > x;
+    }
+    return v;
+}
+
+/* r = a + b with an >= bn; returns the carry */
+SMC_INLINE uint64_t smc_mpn_add(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+    uint64_t cy = smc_mpn_add_n(r, a, b, bn);
+    return smc_mpn_add_1(r + bn, a + bn, an - bn, cy);
+}
+
+/* r = a - b with an >= bn; returns the borrow */
+SMC_INLINE uint64_t smc_mpn_sub(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+    uint64_t bw = smc_mpn_sub_n(r, a, b, bn);
+    return smc_mpn_sub_1(r + bn, a + bn, an - bn, bw);
+}
+
+/* r = a << cnt (0 < cnt < 64); returns the bits shifted out */
+SMC_INLINE uint64_t smc_mpn_lshift(uint64_t *r, const uint64_t *a, size_t n, unsigned cnt) {
+    uint64_t out = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t x = a[i];
+        r[i] = (x << cnt) | out;
+        out = x >> (64 - cnt);
+    }
+    return out;
+}
+
+/* r = a >> cnt (0 < cnt < 64); returns the bits shifted out (at the top) */
+SMC_INLINE uint64_t smc_mpn_rshift(uint64_t *r, const uint64_t *a, size_t n, unsigned cnt) {
+    uint64_t out = 0;
+    for (size_t i = n; i-- > 0;) {
+        uint64_t x = a[i];
+        r[i] = (x >> cnt) | out;
+        out = x << (64 - cnt);
+    }
+    return out;
+}
+
+/* r = a * v (n limbs); returns the high limb */
+SMC_INLINE uint64_t smc_mpn_mul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t v) {
+    uint64_t cy = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t hi, lo = smc_mul64_wide(a[i], v, &hi);
+        lo += cy;
+        r[i] = lo;
+        cy = hi + (lo < cy);
+    }
+    return cy;
+}
+
+/* r += a * v (n limbs); returns the high limb */
+SMC_INLINE uint64_t smc_mpn_addmul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t v) {
+    uint64_t cy = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t hi, lo = smc_mul64_wide(a[i], v, &hi);
+        lo += cy;
+        hi += lo < cy;
+        uint64_t x = r[i] + lo;
+        hi += x < lo;
+        r[i] = x;
+        cy = hi;
+    }
+    return cy;
+}
+
+/* r -= a * v (n limbs); returns the borrow out of the top limb */
+SMC_INLINE uint64_t smc_mpn_submul_1(uint64_t *r, const uint64_t *a, size_t n, uint64_t v) {
+    uint64_t cy = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t hi, lo = smc_mul64_wide(a[i], v, &hi);
+        lo += cy;
+        hi += lo < cy;
+        uint64_t x = r[i];
+        r[i] = x - lo;
+        cy = hi + (r[i] > x);
+    }
+    return cy;
+}
+
+/* ===========================================================================
+ * MULTIPLICATION
+ * =========================================================================== */
+
+/* r = a * b (an + bn limbs); r must not overlap the inputs */
+SMC_API void smc_mpn_mul_basecase(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+    r[an] = smc_mpn_mul_1(r, a, an, b[0]);
+    for (size_t j = 1; j < bn; j++) r[an + j] = smc_mpn_addmul_1(r + j, a, an, b[j]);
+}
+
+/* r = a^2 (2n limbs): off-diagonal products once, doubled, plus squares */
+SMC_API void smc_mpn_sqr_basecase(uint64_t *r, const uint64_t *a, size_t n) {
+    memset(r, 0, 2 * n * sizeof(uint64_t));
+    for (size_t i = 1; i < n; i++) r[n + i - 1] = smc_mpn_addmul_1(r + 2 * i - 1, a + i, n - i, a[i - 1]);
+    r[2 * n - 1] = smc_mpn_lshift(r, r, 2 * n - 1, 1);
+    uint64_t cy = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t hi, lo = smc_mul64_wide(a[i], a[i], &hi);
+        uint64_t t = r[2 * i] + cy;
+        uint64_t c1 = t < cy;
+        r[2 * i] = t + lo;
+        c1 += r[2 * i] < lo;
+        t = r[2 * i + 1] + c1;
+        uint64_t c2 = t < c1;
+        r[2 * i + 1] = t + hi;
+        cy = c2 + (r[2 * i + 1] < hi);
+    }
+}
+
+/* Scratch limbs Karatsuba needs for n-limb operands */
+SMC_INLINE size_t smc_mpn_mul_scratch(size_t n) {
+    return 4 * n + 16 * 64;
+}
+
+/*
+ * Karatsuba on n-limb a and b (b == a squares), with h = ceil(n / 2):
+ * a*b = z0 + ((a0 + a1)(b0 + b1) - z0 - z2) B^h + z2 B^2h
+ */
+SMC_API void smc_mpn_kara(uint64_t *r, const uint64_t *a, const uint64_t *b, size_t n, uint64_t *tmp) {
+    bool sqr = a == b;
+    if (n < SMC_MP_KARATSUBA) {
+        if (sqr) smc_mpn_sqr_basecase(r, a, n);
+        else smc_mpn_mul_basecase(r, a, n, b, n);
+        return;
+    }
+    size_t h = (n + 1) / 2, l = n - h;
+    uint64_t *sa = tmp, *sb = tmp + h + 1, *z1 = tmp + 2 * h + 2, *next = z1 + 2 * h + 2;
+
+    /* z0 and z2 straight into r */
+    smc_mpn_kara(r, a, b, h, next);
+    smc_mpn_kara(r + 2 * h, a + h, sqr ? a + h : b + h, l, next);
+
+    sa[h] = smc_mpn_add(sa, a, h, a + h, l);
+    if (!sqr) sb[h] = smc_mpn_add(sb, b, h, b + h, l);
+    smc_mpn_kara(z1, sa, sqr ? sa : sb, h + 1, next);
+
+    /* z1 -= z0 + z2, then add at offset h */
+    smc_mpn_sub(z1, z1, 2 * h + 2, r, 2 * h);
+    smc_mpn_sub(z1, z1, 2 * h + 2, r + 2 * h, 2 * l);
+    size_t z1n = smc_mpn_normalize(z1, 2 * h + 2);
+    smc_mpn_add(r + h, r + h, 2 * n - h, z1, z1n);
+}
+
+/*
+ * r = a * b (an + bn limbs, an >= bn >= 1); r must not overlap the inputs.
+ * Unbalanced operands are multiplied in bn-limb blocks of a.
+ */
+SMC_API void smc_mpn_mul(uint64_t *r, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+    if (bn < SMC_MP_KARATSUBA) {
+        smc_mpn_mul_basecase(r, a, an, b, bn);
+        return;
+    }
+    uint64_t *tmp = (uint64_t *)malloc((smc_mpn_mul_scratch(bn) + 2 * bn) * sizeof(uint64_t));
+    if (tmp == NULL) {
+        smc_mpn_mul_basecase(r, a, an, b, bn);
+        return;
+    }
+    if (an == bn) {
+        smc_mpn_kara(r, a, b, bn, tmp);
+    } else {
+        uint64_t *prod = tmp + smc_mpn_mul_scratch(bn);
+        memset(r, 0, (an + bn) * sizeof(uint64_t));
+        for (size_t i = 0; i < an; i += bn) {
+            size_t len = an - i < bn ? an - i : bn;
+            if (len == bn) smc_mpn_kara(prod, a + i, b, bn, tmp);
+            else smc_mpn_mul_basecase(prod, b, bn, a + i, len);
+            smc_mpn_add(r + i, r + i, an + bn - i, prod, len + bn);
+        }
+    }
+    free(tmp);
+}
+
+/* r = a^2 (2n limbs); r must not overlap a */
+SMC_API void smc_mpn_sqr(uint64_t *r, const uint64_t *a, size_t n) {
+    if (n < SMC_MP_KARATSUBA) {
+        smc_mpn_sqr_basecase(r, a, n);
+        return;
+    }
+    uint64_t *tmp = (uint64_t *)malloc(smc_mpn_mul_scratch(n) * sizeof(uint64_t));
+    if (tmp == NULL) {
+        smc_mpn_sqr_basecase(r, a, n);
+        return;
+    }
+    smc_mpn_kara(r, a, a, n, tmp);
+    free(tmp);
+}
+
+/* ===========================================================================
+ * DIVISION AND GCD
+ * =========================================================================== */
+
+/*
+ * (hi * 2^64 + lo) / d for hi < d; the remainder goes to *rem. One divq on
+ * x86-64, otherwise a 128-bit division, or two 32-bit digit steps of
+ * Knuth's algorithm D without __int128 (Hacker's Delight divlu).
+ */
+SMC_INLINE uint64_t smc_udiv128_64(uint64_t hi, uint64_t lo, uint64_t d, uint64_t *rem) {
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t q, r;
+    __asm__("divq %4" : "=a"(q), "=d"(r) : "a"(lo), "d"(hi), "rm"(d));
+    *rem = r;
+    return q;
+#elif defined(__SIZEOF_INT128__)
+    __uint128_t x = ((__uint128_t)hi << 64) | lo;
+    *rem = (uint64_t)(x % d);
+    return (uint64_t)(x / d);
+#else
+    const uint64_t b = 1ULL << 32;
+    unsigned s = (unsigned)smc_clz64(d);
+    if (s) {
+        d <<= s;
+        hi = (hi << s) | (lo >> (64 - s));
+        lo <<= s;
+    }
+    uint64_t d1 = d >> 32, d0 = (uint32_t)d, l1 = lo >> 32, l0 = (uint32_t)lo;
+    uint64_t q1 = hi / d1, rh = hi - q1 * d1;
+    while (q1 >= b || q1 * d0 > ((rh << 32) | l1)) {
+        q1--;
+        rh += d1;
+        if (rh >= b) break;
+    }
+    uint64_t mid = (hi << 32) + l1 - q1 * d;
+    uint64_t q0 = mid / d1;
+    rh = mid - q0 * d1;
+    while (q0 >= b || q0 * d0 > ((rh << 32) | l0)) {
+        q0--;
+        rh += d1;
+        if (rh >= b) break;
+    }
+    *rem = ((mid << 32) + l0 - q0 * d) >> s;
+    return (q1 << 32) | q0;
+#endif
+}
+
+/* q = a / d (n limbs; q may alias a or be NULL); returns a mod d */
+SMC_INLINE uint64_t smc_mpn_divrem_1(uint64_t *q, const uint64_t *a, size_t n, uint64_t d) {
+    uint64_t r = 0;
+    for (size_t i = n; i-- > 0;) {
+        uint64_t t = smc_udiv128_64(r, a[i], d, &r);
+        if (q) q[i] = t;
+    }
+    return r;
+}
+
+/* Scratch limbs smc_mpn_divrem_with needs */
+SMC_INLINE size_t smc_mpn_divrem_scratch(size_t an, size_t dn) {
+    return an + 1 + dn;
+}
+
+/*
+ * smc_mpn_divrem with caller scratch of smc_mpn_divrem_scratch(an, dn)
+ * limbs; r may alias a. Quotient digits are estimated from the top two limbs of the
+ * normalized divisor, so at most one add-back per digit is needed.
+ */
+SMC_API void smc_mpn_divrem_with(uint64_t *q, uint64_t *r, const uint64_t *a, size_t an,
+                                 const uint64_t *d, size_t dn, uint64_t *tmp) {
+    if (dn == 1) {
+        uint64_t rem = smc_mpn_divrem_1(q, a, an, d[0]);
+        if (r) r[0] = rem;
+        return;
+    }
+    uint64_t *u = tmp, *v = tmp + an + 1;
+    unsigned s = (unsigned)smc_clz64(d[dn - 1]);
+    if (s) {
+        smc_mpn_lshift(v, d, dn, s);
+        u[an] = smc_mpn_lshift(u, a, an, s);
+    } else {
+        memcpy(v, d, dn * sizeof(uint64_t));
+        memcpy(u, a, an * sizeof(uint64_t));
+        u[an] = 0;
+    }
+    uint64_t v1 = v[dn - 1], v2 = v[dn - 2];
+    for (size_t j = an - dn + 1; j-- > 0;) {
+        uint64_t *uj = u + j;
+        uint64_t qhat, rhat;
+        bool big;   /* rhat >= 2^64: the estimate can no longer be too large */
+        if (uj[dn] >= v1) {
+            qhat = ~0ULL;
+            rhat = uj[dn - 1] + v1;
+            big = rhat < v1;
+        } else {
+            qhat = smc_udiv128_64(uj[dn], uj[dn - 1], v1, &rhat);
+            big = false;
+        }
+        while (!big) {
+            uint64_t ph, pl = smc_mul64_wide(qhat, v2, &ph);
+            if (ph < rhat || (ph == rhat && pl <= uj[dn - 2])) break;
+            qhat--;
+            rhat += v1;
+            big = rhat < v1;
+        }
+        uint64_t bw = smc_mpn_submul_1(uj, v, dn, qhat), top = uj[dn];
+        uj[dn] = top - bw;
+        if (top < bw) {
+            qhat--;
+            uj[dn] += smc_mpn_add_n(uj, uj, v, dn);
+        }
+        if (q) q[j] = qhat;
+    }
+    if (r == NULL) return;
+    if (s) smc_mpn_rshift(r, u, dn, s);
+    else memcpy(r, u, dn * sizeof(uint64_t));
+}
+
+/*
+ * Schoolbook division (Knuth's algorithm D): q = a / d (an - dn + 1 limbs)
+ * and r = a mod d (dn limbs), for an >= dn >= 1 and d[dn - 1] != 0.
+ * Either output may be NULL; neither may overlap the inputs.
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_mpn_divrem(uint64_t *q, uint64_t *r, const uint64_t *a, size_t an,
+                            const uint64_t *d, size_t dn) {
+    uint64_t *tmp = NULL;
+    if (dn > 1) {
+        tmp = (uint64_t *)malloc(smc_mpn_divrem_scratch(an, dn) * sizeof(uint64_t));
+        if (tmp == NULL) return false;
+    }
+    smc_mpn_divrem_with(q, r, a, an, d, dn, tmp);
+    free(tmp);
+    return true;
+}
+
+/*
+ * g = gcd(a, b) for nonzero a and b by Euclid's algorithm, g having room
+ * for min(an, bn) limbs. Each step is one division, linear in the size
+ * for the small quotients that dominate; single limbs finish in hardware.
+ * Returns the limb count of g, or 0 on allocation failure.
+ */
+SMC_API size_t smc_mpn_gcd(uint64_t *g, const uint64_t *a, size_t an, const uint64_t *b, size_t bn) {
+    an = smc_mpn_normalize(a, an);
+    bn = smc_mpn_normalize(b, bn);
+    if (an < bn || (an == bn && smc_mpn_cmp(a, b, an) < 0)) {
+        const uint64_t *t = a; a = b; b = t;
+        size_t tn = an; an = bn; bn = tn;
+    }
+    uint64_t *buf = (uint64_t *)malloc((2 * an + 2 * bn + 1) * sizeof(uint64_t));
+    if (buf == NULL) return 0;
+    uint64_t *x = buf, *y = buf + an, *tmp = buf + an + bn;
+    size_t xn = an, yn = bn;
+    memcpy(x, a, an * sizeof(uint64_t));
+    memcpy(y, b, bn * sizeof(uint64_t));
+    /* x >= y throughout; x = y, y = x mod y until y fits a limb */
+    while (yn > 1) {
+        smc_mpn_divrem_with(NULL, x, x, xn, y, yn, tmp);
+        size_t rn = smc_mpn_normalize(x, yn);
+        uint64_t *t = x; x = y; y = t;
+        xn = yn;
+        yn = rn;
+    }
+    size_t gn;
+    if (yn == 0) {
+        memcpy(g, x, xn * sizeof(uint64_t));
+        gn = xn;
+    } else {
+        uint64_t u = y[0], w = smc_mpn_divrem_1(NULL, x, xn, u);
+        while (w) {
+            uint64_t t = u % w;
+            u = w;
+            w = t;
+        }
+        g[0] = u;
+        gn = 1;
+    }
+    free(buf);
+    return gn;
+}
+
+/* ===========================================================================
+ * SPECIAL-FORM REDUCTION (multi-limb)
+ * =========================================================================== */
+
+/*
+ * Reduce x (xn limbs, modified in place) modulo m = 2^k - c, c < 2^63.
+ * Folds x = H * 2^k + L into H * c + L until x < 2^k, then subtracts m
+ * once if needed. The result occupies the low ceil(k / 64) limbs of x.
+ * x needs room for xn + 2 limbs and tmp for xn + 1.
+ */
+SMC_API void smc_mpn_mod_pm(uint64_t *x, size_t xn, uint64_t k, uint64_t c, uint64_t *tmp) {
+    size_t kw = (size_t)(k / 64), kb = (size_t)(k % 64);
+    size_t rn = kw + (kb != 0);
+    for (;;) {
+        xn = smc_mpn_normalize(x, xn);
+        if (xn < rn || (xn == rn && (kb == 0 || (x[rn - 1] >> kb) == 0))) break;
+        /* H = x >> k */
+        size_t hn = xn - kw;
+        if (kb) smc_mpn_rshift(tmp, x + kw, hn, (unsigned)kb);
+        else memcpy(tmp, x + kw, hn * sizeof(uint64_t));
+        hn = smc_mpn_normalize(tmp, hn);
+        /* L = x mod 2^k, cleared above bit k */
+        if (kb) x[kw] &= (1ULL << kb) - 1;
+        memset(x + rn, 0, (xn - rn) * sizeof(uint64_t));
+        /* x = L + H * c */
+        uint64_t top = c == 1 ? 0 : smc_mpn_mul_1(tmp, tmp, hn, c);
+        tmp[hn] = top;
+        size_t tn = hn + 1;
+        size_t n = tn > rn ? tn : rn;
+        if (n + 1 > xn) memset(x + xn, 0, (n + 1 - xn) * sizeof(uint64_t));
+        x[n] = smc_mpn_add(x, x, n, tmp, tn);
+        xn = n + 1;
+    }
+    /* x < 2^k < 2m: subtract m = 2^k - c once, i.e. x + c - 2^k */
+    uint64_t mtop = kb ? (1ULL << kb) : 0;
+    bool ge;
+    if (c == 0) {
+        ge = false;
+    } else {
+        /* x >= m  <=>  x + c >= 2^k */
+        memcpy(tmp, x, rn * sizeof(uint64_t));
+        tmp[rn] = smc_mpn_add_1(tmp, tmp, rn, c);
+        ge = kb ? (tmp[rn - 1] >= mtop) : (tmp[rn] != 0);
+        if (ge) {
+            if (kb) tmp[rn - 1] -= mtop;
+            memcpy(x, tmp, rn * sizeof(uint64_t));
+        }
+    }
+}
+
+/* ===========================================================================
+ * SPECIAL-FORM 128-BIT ARITHMETIC
+ * =========================================================================== */
+
+#if defined(__SIZEOF_INT128__)
+
+typedef __uint128_t smc_u128;
+
+/* Full 128x128 -> 256-bit product as four limbs */
+SMC_INLINE void smc_mul128_wide(smc_u128 a, smc_u128 b, uint64_t r[4]) {
+    uint64_t a0 = (uint64_t)a, a1 = (uint64_t)(a >> 64);
+    uint64_t b0 = (uint64_t)b, b1 = (uint64_t)(b >> 64);
+    smc_u128 p00 = (smc_u128)a0 * b0, p01 = (smc_u128)a0 * b1;
+    smc_u128 p10 = (smc_u128)a1 * b0, p11 = (smc_u128)a1 * b1;
+    smc_u128 mid = (p00 >> 64) + (uint64_t)p01 + (uint64_t)p10;
+    smc_u128 top = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+    r[0] = (uint64_t)p00;
+    r[1] = (uint64_t)mid;
+    r[2] = (uint64_t)top;
+    r[3] = (uint64_t)(top >> 64);
+}
+
+/* a * b mod (2^k - c) for 64 < k <= 128, operands below the modulus */
+SMC_INLINE smc_u128 smc_pmod_mul128(smc_u128 a, smc_u128 b, unsigned k, uint64_t c) {
+    uint64_t x[6], tmp[5];
+    smc_mul128_wide(a, b, x);
+    if (c == 1 && k < 128) {
+        /* Mersenne: H + L < 2m without leaving 128 bits */
+        smc_u128 lo = ((smc_u128)x[1] << 64) | x[0], hi = ((smc_u128)x[3] << 64) | x[2];
+        smc_u128 m = ((smc_u128)1 << k) - 1;
+        smc_u128 r = ((hi << (128 - k)) | (lo >> k)) + (lo & m);
+        return r >= m ? r - m : r;
+    }
+    smc_mpn_mod_pm(x, 4, k, c, tmp);
+    return ((smc_u128)x[1] << 64) | x[0];
+}
+
+/*
+ * base^exp mod (2^k - c). Callers pick this for moduli known to have the
+ * form (as smc_lucas_lehmer does); nothing dispatches here automatically,
+ * since 128-bit Montgomery (smcprime128.h) measured as fast for 2^127 - 1
+ * and 3-5x faster for c > 1.
+ */
+SMC_INLINE smc_u128 smc_pmod_pow128(smc_u128 base, smc_u128 exp, unsigned k, uint64_t c) {
+    smc_u128 r = 1;
+    smc_u128 m = (k == 128 ? 0 : ((smc_u128)1 << k)) - c;
+    base %= m;
+    while (exp) {
+        if (exp & 1) r = smc_pmod_mul128(r, base, k, c);
+        base = smc_pmod_mul128(base, base, k, c);
+        exp >>= 1;
+    }
+    return r;
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_MP_H */
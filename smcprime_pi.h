@@ -0,0 +1,183 @@
+/*
+ * smcPrime - Prime-Counting Estimates and Bounds
+ *
+ * Analytic approximations and proven bounds for pi(x) and the n-th prime:
+ * - smc_li(x), smc_riemann_r(x): logarithmic integral and Riemann's R,
+ *   within a fraction of a percent of pi(x) (R within ~sqrt(x))
+ * - smc_pi_upper / smc_pi_lower: Dusart / Rosser-Schoenfeld bounds
+ * - smc_pi_range_upper: bound for [lo, hi), using Montgomery-Vaughan's
+ *   Brun-Titchmarsh inequality for short windows
+ * - smc_nth_prime_upper / smc_nth_prime_lower: Dusart / Rosser bounds
+ *
+ * The enumeration APIs size their output once from these bounds. All
+ * arithmetic is double precision with a self-contained logarithm, so the
+ * header needs no libm; bounds are widened slightly to absorb rounding.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_PI_H
+#define SMCPRIME_PI_H
+
+#include "smcprime.h"
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===========================================================================
+ * ELEMENTARY FUNCTIONS
+ * =========================================================================== */
+
+/* Natural logarithm for normal x > 0: exponent split plus an atanh series */
+SMC_INLINE double smc_ln(double x) {
+    uint64_t b;
+    memcpy(&b, &x, sizeof(b));
+    int e = (int)((b >> 52) & 0x7FF) - 1023;
+    b = (b & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+    double m;
+    memcpy(&m, &b, sizeof(m));
+    if (m > 1.4142135623730951) { m *= 0.5; e++; }
+    /* ln m = 2 atanh(s), |s| < 0.172: eleven terms reach 1e-18 */
+    double s = (m - 1) / (m + 1), s2 = s * s, t = s, sum = 0;
+    for (int k = 1; k < 24; k += 2) {
+        sum += t / k;
+        t *= s2;
+    }
+    return e * 0.69314718055994530942 + 2 * sum;
+}
+
+/* ===========================================================================
+ * ESTIMATES
+ * =========================================================================== */
+
+/* li(x) = gamma + ln ln x + sum (ln x)^k / (k k!), for x > 1 (0 otherwise) */
+SMC_API double smc_li(double x) {
+    if (x <= 1) return 0;
+    double L = smc_ln(x), t = 1, sum = 0;
+    for (int k = 1; k < 1000; k++) {
+        t *= L / k;
+        double term = t / k;
+        sum += term;
+        if (k > L && term < sum * 1e-17) break;
+    }
+    return 0.57721566490153286061 + smc_ln(L) + sum;
+}
+
+/*
+ * Riemann's R(x) = 1 + sum (ln x)^k / (k k! zeta(k + 1)) (Gram series),
+ * for x >= 1. zeta is summed to n = 10 with an Euler-Maclaurin tail, the
+ * powers n^-s advancing by one multiply per term.
+ */
+SMC_API double smc_riemann_r(double x) {
+    if (x < 1) return 0;
+    double L = smc_ln(x), t = 1, sum = 1;
+    double pw[11];                          /* pw[n] = n^-(k+1) */
+    for (int n = 2; n <= 10; n++) pw[n] = 1.0 / n;
+    for (int k = 1; k < 1000; k++) {
+        double s = k + 1, zeta = 1;
+        if (s <= 64) {                      /* beyond, zeta(s) = 1 in doubles */
+            for (int n = 2; n <= 10; n++) {
+                pw[n] /= n;
+                zeta += pw[n];
+            }
+            double p10 = pw[10];
+            zeta += p10 * (10 / (s - 1) - 0.5 + s / 120 - s * (s + 1) * (s + 2) / 720000);
+        }
+        t *= L / k;
+        double term = t / (k * zeta);
+        sum += term;
+        if (k > L && term < sum * 1e-17) break;
+    }
+    return sum;
+}
+
+/* ===========================================================================
+ * BOUNDS
+ *
+ * pi(x) <= min((x + 1) / 2, 1.25506 x / ln x, Dusart 2018 (x > 1))
+ * pi(x) >= x / ln x (1 + 1/ln x + 2/ln^2 x) (x >= 88789), weaker forms below
+ * p_n  >= n (ln n + ln ln n - 1)                           (n >= 2)
+ * p_n  <= n (ln n + ln ln n - 1 + (ln ln n - 2) / ln n)     (n >= 688383)
+ * p_n  <= n (ln n + ln ln n)                               (n >= 6)
+ * =========================================================================== */
+
+/* Round a bound outward by a relative 1e-9 and one unit */
+SMC_INLINE uint64_t smc_bound_up(double v) {
+    v = v * (1 + 1e-9) + 1;
+    return v >= 18446744073709549568.0 ? UINT64_MAX : (uint64_t)v;
+}
+
+SMC_INLINE uint64_t smc_bound_down(double v) {
+    v = v * (1 - 1e-9) - 1;
+    return v <= 0 ? 0 : (uint64_t)v;
+}
+
+/* Upper bound on pi(x) */
+SMC_API uint64_t smc_pi_upper(uint64_t x) {
+    if (x < 2) return 0;
+    uint64_t odd = x / 2 + 1;               /* 2 and the odd numbers 3..x */
+    if (x < 17) return odd;
+    double xd = (double)x, L = smc_ln(xd);
+    double rs = 1.25506 * xd / L;
+    double du = xd / L * (1 + 1 / L + 2 / (L * L) + 7.59 / (L * L * L));
+    uint64_t b = smc_bound_up(rs < du ? rs : du);
+    return b < odd ? b : odd;
+}
+
+/* Lower bound on pi(x) */
+SMC_API uint64_t smc_pi_lower(uint64_t x) {
+    static const uint8_t small[17] = {0, 0, 1, 2, 2, 3, 3, 4, 4, 4, 4, 5, 5, 6, 6, 6, 6};
+    if (x < 17) return small[x];
+    double xd = (double)x, L = smc_ln(xd);
+    double v = xd / L;
+    if (x >= 88789) v *= 1 + 1 / L + 2 / (L * L);
+    else if (x >= 599) v *= 1 + 1 / L;
+    return smc_bound_down(v);
+}
+
+/*
+ * Upper bound on the number of primes in [lo, hi): the smallest of the
+ * odd-number count, pi_upper(hi - 1) - pi_lower(lo - 1), and the
+ * Brun-Titchmarsh bound 2y / ln y (y = hi - lo, Montgomery-Vaughan 1973).
+ */
+SMC_API uint64_t smc_pi_range_upper(uint64_t lo, uint64_t hi) {
+    if (hi <= lo || hi <= 2) return 0;
+    if (lo < 2) lo = 2;
+    uint64_t y = hi - lo;
+    uint64_t b = y / 2 + 1 + (lo == 2);
+    uint64_t lower = smc_pi_lower(lo - 1), upper = smc_pi_upper(hi - 1);
+    if (upper - lower < b) b = upper - lower;
+    if (y > 16) {
+        double yd = (double)y;
+        uint64_t bt = smc_bound_up(2 * yd / smc_ln(yd));
+        if (bt < b) b = bt;
+    }
+    return b;
+}
+
+/* Upper bound on the n-th prime (p_1 = 2); UINT64_MAX if beyond 64 bits */
+SMC_API uint64_t smc_nth_prime_upper(uint64_t n) {
+    static const uint8_t small[6] = {0, 2, 3, 5, 7, 11};
+    if (n < 6) return small[n];
+    double nd = (double)n, L = smc_ln(nd), LL = smc_ln(L);
+    double v = nd * (L + LL);
+    if (n >= 688383) v = nd * (L + LL - 1 + (LL - 2) / L);
+    return smc_bound_up(v);
+}
+
+/* Lower bound on the n-th prime (p_1 = 2) */
+SMC_API uint64_t smc_nth_prime_lower(uint64_t n) {
+    if (n < 6) return smc_nth_prime_upper(n);
+    double nd = (double)n, L = smc_ln(nd);
+    uint64_t v = smc_bound_down(nd * (L + smc_ln(L) - 1));
+    return v > 2 * n ? v : 2 * n;           /* p_n > 2n for n >= 5 */
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_PI_H */
@@ -0,0 +1,634 @@
+/*
+ * smcPrime - Special-Purpose Factoring
+ *
+ * Finders for factors with structure that Pollard rho does not exploit,
+ * for 64-bit and (with __int128) 128-bit odd composites:
+ * - smc_pm1_*: Pollard p - 1, for a prime factor p with p - 1 smooth
+ * - smc_pp1_*: Williams p + 1 on Lucas sequences V_k(P), for p + 1 smooth
+ *   (or p - 1, depending on the seed P)
+ * - smc_fermat_* / smc_lehman_*: factors close to sqrt(n), or close to
+ *   a small rational multiple of each other
+ *
+ * Stage 1 raises to E, the product of the largest powers <= B1 of all
+ * primes <= B1, built once per plan from the library's sieve. For p - 1
+ * the base is 3, so E is walked left to right and every multiply by the
+ * base is two additions. Stage 2 covers one prime q in (B1, B2] per
+ * multiply with baby steps j and giant steps kD (D = 210, q = kD -+ j).
+ * Products are gcd'd with n in batches of SMC_PM1_GCD_BATCH primes; a
+ * batch that finds every factor at once is replayed a prime at a time.
+ *
+ * All finders return a non-trivial factor of n, or n on failure.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_PM1_H
+#define SMCPRIME_PM1_H
+
+#include "smcprime.h"
+#include "smcprime_mp.h"
+#include "smcprime_sieve.h"
+#include "smcprime_factor.h"
+#include "smcprime128.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Stage-2 primes per gcd */
+#ifndef SMC_PM1_GCD_BATCH
+  #define SMC_PM1_GCD_BATCH 1024
+#endif
+
+/* Stage-2 giant step */
+#define SMC_PM1_D 210
+
+/* ===========================================================================
+ * PLANS
+ * =========================================================================== */
+
+typedef struct smc_pm1_plan {
+    uint32_t B1, B2;
+    uint64_t *E;                /* stage-1 exponent, little-endian limbs */
+    size_t En;
+    uint32_t *pp;               /* largest power <= B1 of each prime <= B1 */
+    size_t npp;
+    uint32_t *primes;           /* stage-2 primes in (B1, B2] */
+    size_t np;
+} smc_pm1_plan;
+
+SMC_API void smc_pm1_plan_free(smc_pm1_plan *pl) {
+    free(pl->E);
+    free(pl->pp);
+    free(pl->primes);
+    memset(pl, 0, sizeof(*pl));
+}
+
+/* Product of w[0 .. cnt) into r (cnt limbs); returns its limb count, 0 on allocation failure */
+SMC_API size_t smc_pm1_product(uint64_t *r, const uint64_t *w, size_t cnt) {
+    if (cnt <= 16) {
+        size_t n = 1;
+        r[0] = w[0];
+        for (size_t i = 1; i < cnt; i++) {
+            uint64_t c = smc_mpn_mul_1(r, r, n, w[i]);
+            if (c) r[n++] = c;
+        }
+        return n;
+    }
+    size_t h = cnt / 2;
+    uint64_t *t = (uint64_t *)malloc(cnt * sizeof(uint64_t));
+    if (t == NULL) return 0;
+    size_t an = smc_pm1_product(t, w, h), bn = smc_pm1_product(t + h, w + h, cnt - h);
+    if (an == 0 || bn == 0) { free(t); return 0; }
+    if (an >= bn) smc_mpn_mul(r, t, an, t + h, bn);
+    else smc_mpn_mul(r, t + h, bn, t, an);
+    free(t);
+    return smc_mpn_normalize(r, an + bn);
+}
+
+/*
+ * Bounds for stage 1 (primes <= B1) and stage 2 (one prime in (B1, B2]);
+ * B2 = 0 picks 100 * B1. One plan serves any number of inputs.
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_pm1_plan_init(smc_pm1_plan *pl, uint32_t B1, uint32_t B2) {
+    memset(pl, 0, sizeof(*pl));
+    if (B1 < 2) B1 = 2;
+    uint64_t b2 = B2 ? B2 : (uint64_t)B1 * 100;
+    if (b2 > UINT32_MAX - SMC_PM1_D) b2 = UINT32_MAX - SMC_PM1_D;
+    if (b2 < B1) b2 = B1;
+    B2 = (uint32_t)b2;
+    pl->B1 = B1;
+    pl->B2 = B2;
+
+    size_t np = 0;
+    uint32_t *all = smc_sieve_primes32(B2, &np);
+    if (all == NULL) return false;
+    size_t n1 = 0;
+    while (n1 < np && all[n1] <= B1) n1++;
+    pl->pp = (uint32_t *)malloc((n1 + 1) * sizeof(uint32_t));
+    pl->primes = (uint32_t *)malloc((np - n1 + 1) * sizeof(uint32_t));
+    uint64_t *words = (uint64_t *)malloc((n1 + 1) * sizeof(uint64_t));
+    pl->E = (uint64_t *)malloc((n1 + 1) * sizeof(uint64_t));
+    if (!pl->pp || !pl->primes || !words || !pl->E) {
+        free(all); free(words); smc_pm1_plan_free(pl);
+        return false;
+    }
+
+    /* Prime powers, packed into as few 64-bit words as fit */
+    size_t nw = 0;
+    uint64_t w = 1;
+    for (size_t i = 0; i < n1; i++) {
+        uint64_t q = all[i];
+        while (q * all[i] <= B1) q *= all[i];
+        pl->pp[i] = (uint32_t)q;
+        if (w > UINT64_MAX / q) { words[nw++] = w; w = 1; }
+        w *= q;
+    }
+    words[nw++] = w;
+    pl->npp = n1;
+    memcpy(pl->primes, all + n1, (np - n1) * sizeof(uint32_t));
+    pl->np = np - n1;
+    free(all);
+
+    pl->En = smc_pm1_product(pl->E, words, nw);
+    free(words);
+    if (pl->En == 0) { smc_pm1_plan_free(pl); return false; }
+    return true;
+}
+
+/* ===========================================================================
+ * 64-BIT HELPERS
+ * =========================================================================== */
+
+SMC_INLINE uint64_t smc_mont_add64(uint64_t a, uint64_t b, uint64_t n) {
+    return a >= n - b ? a - (n - b) : a + b;
+}
+
+SMC_INLINE uint64_t smc_mont_sub64(uint64_t a, uint64_t b, uint64_t n) {
+    return a >= b ? a - b : a - b + n;
+}
+
+/* V_k(V) for the Lucas sequence V_0 = 2, V_1 = V, V_{i+1} = V V_i - V_{i-1}; *next = V_{k+1} */
+SMC_INLINE uint64_t smc_lucas_v64(uint64_t V, uint64_t k, uint64_t two, uint64_t *next,
+                                  uint64_t n, uint64_t n_inv) {
+    uint64_t a = two, b = V;
+    for (int i = k ? 63 - smc_clz64(k) : -1; i >= 0; i--) {
+        uint64_t ab = smc_mont_sub64(smc_mont_mul64(a, b, n, n_inv), V, n);
+        if ((k >> i) & 1) {
+            a = ab;
+            b = smc_mont_sub64(smc_mont_mul64(b, b, n, n_inv), two, n);
+        } else {
+            b = ab;
+            a = smc_mont_sub64(smc_mont_mul64(a, a, n, n_inv), two, n);
+        }
+    }
+    if (next) *next = b;
+    return a;
+}
+
+/*
+ * Stage 2 on the stage-1 residue x (Montgomery form). For p - 1
+ * (lucas false) the terms are x^(kD) - x^j, zero mod p when the order of
+ * x mod p divides q = kD - j. For p + 1 (lucas true) x is V_E and the
+ * terms are V_kD - V_j, zero when the order divides q = kD -+ j.
+ */
+SMC_API uint64_t smc_pm1_stage2_64(uint64_t x, bool lucas, const smc_pm1_plan *pl,
+                                   uint64_t n, uint64_t n_inv, uint64_t one) {
+    if (pl->np == 0) return n;
+    const uint64_t D = SMC_PM1_D;
+    uint64_t baby[SMC_PM1_D + 1], two = smc_mont_add64(one, one, n);
+    uint64_t step, giant, prev = 0, k;
+
+    if (lucas) {
+        /* V_j for j <= D / 2; V_D = V_{D/2}^2 - 2 */
+        baby[0] = two;
+        baby[1] = x;
+        for (uint64_t j = 2; j <= D / 2; j++)
+            baby[j] = smc_mont_sub64(smc_mont_mul64(x, baby[j - 1], n, n_inv), baby[j - 2], n);
+        step = smc_mont_sub64(smc_mont_mul64(baby[D / 2], baby[D / 2], n, n_inv), two, n);
+        k = (pl->primes[0] + D / 2) / D;
+        if (k == 0) {
+            giant = two;            /* V_0; V_-D = V_D */
+            prev = step;
+        } else {
+            prev = smc_lucas_v64(step, k - 1, two, &giant, n, n_inv);
+        }
+    } else {
+        baby[0] = one;
+        for (uint64_t j = 1; j <= D; j++) baby[j] = smc_mont_mul64(baby[j - 1], x, n, n_inv);
+        step = baby[D];
+        k = (pl->primes[0] + D - 1) / D;
+        giant = smc_mont_pow64(step, k, n, n_inv, one);
+    }
+
+    /* Batches of SMC_PM1_GCD_BATCH primes; a batch reaching n is replayed term by term */
+    size_t i0 = 0;
+    uint64_t k0 = k, giant0 = giant, prev0 = prev, acc = one;
+    for (size_t i = 0; i < pl->np; i++) {
+        uint64_t q = pl->primes[i];
+        uint64_t kq = lucas ? (q + D / 2) / D : (q + D - 1) / D;
+        while (k < kq) {
+            if (lucas) {
+                uint64_t t = smc_mont_sub64(smc_mont_mul64(giant, step, n, n_inv), prev, n);
+                prev = giant;
+                giant = t;
+            } else {
+                giant = smc_mont_mul64(giant, step, n, n_inv);
+            }
+            k++;
+        }
+        uint64_t j = k * D > q ? k * D - q : q - k * D;
+        acc = smc_mont_mul64(acc, smc_mont_sub64(giant, baby[j], n), n, n_inv);
+
+        if (i + 1 - i0 < SMC_PM1_GCD_BATCH && i + 1 < pl->np) continue;
+        uint64_t g = smc_gcd64(acc, n);
+        if (g == n) {
+            /* Replay the batch one term at a time */
+            k = k0;
+            giant = giant0;
+            prev = prev0;
+            for (size_t r = i0; r <= i; r++) {
+                q = pl->primes[r];
+                kq = lucas ? (q + D / 2) / D : (q + D - 1) / D;
+                while (k < kq) {
+                    if (lucas) {
+                        uint64_t t = smc_mont_sub64(smc_mont_mul64(giant, step, n, n_inv), prev, n);
+                        prev = giant;
+                        giant = t;
+                    } else {
+                        giant = smc_mont_mul64(giant, step, n, n_inv);
+                    }
+                    k++;
+                }
+                j = k * D > q ? k * D - q : q - k * D;
+                g = smc_gcd64(smc_mont_sub64(giant, baby[j], n), n);
+                if (g != 1) return g;
+            }
+            return n;
+        }
+        if (g != 1) return g;
+        i0 = i + 1;
+        k0 = k;
+        giant0 = giant;
+        prev0 = prev;
+        acc = one;
+    }
+    return n;
+}
+
+/* ===========================================================================
+ * 64-BIT P - 1 AND P + 1
+ * =========================================================================== */
+
+/* Pollard p - 1 with base 3 on odd composite n (no factor 3) */
+SMC_API uint64_t smc_pm1_64(uint64_t n, const smc_pm1_plan *pl) {
+    uint64_t n_inv = smc_mont_inv64(n), one = smc_mont_one64(n);
+    uint64_t three = smc_mont_add64(smc_mont_add64(one, one, n), one, n);
+
+    /* 3^E left to right: a squaring per bit, two additions per set bit */
+    uint64_t x = one;
+    for (size_t l = pl->En; l-- > 0;) {
+        uint64_t e = pl->E[l];
+        for (int b = 63; b >= 0; b--) {
+            x = smc_mont_mul64(x, x, n, n_inv);
+            if ((e >> b) & 1) x = smc_mont_add64(smc_mont_add64(x, x, n), x, n);
+        }
+    }
+    uint64_t g = smc_gcd64(smc_mont_sub64(x, one, n), n);
+    if (g == n) {
+        /* Every factor at once: redo with a gcd after each prime power */
+        x = three;
+        for (size_t i = 0; i < pl->npp; i++) {
+            x = smc_mont_pow64(x, pl->pp[i], n, n_inv, one);
+            g = smc_gcd64(smc_mont_sub64(x, one, n), n);
+            if (g != 1) return g;
+        }
+        return n;
+    }
+    if (g != 1) return g;
+    return smc_pm1_stage2_64(x, false, pl, n, n_inv, one);
+}
+
+/*
+ * Williams p + 1 with seed P >= 3 on odd composite n. Finds p when p + 1
+ * is smooth and P^2 - 4 is a non-residue mod p, or p - 1 is smooth and it
+ * is a residue; retry with other seeds (about half succeed).
+ */
+SMC_API uint64_t smc_pp1_64(uint64_t n, const smc_pm1_plan *pl, uint64_t P) {
+    uint64_t n_inv = smc_mont_inv64(n), one = smc_mont_one64(n);
+    uint64_t two = smc_mont_add64(one, one, n);
+    uint64_t V = P % n ? smc_mont_small64(P % n, n, one) : 0;
+
+    /* V_E by a Lucas ladder over the bits of E */
+    uint64_t a = two, b = V;
+    for (size_t l = pl->En; l-- > 0;) {
+        uint64_t e = pl->E[l];
+        for (int i = 63; i >= 0; i--) {
+            uint64_t ab = smc_mont_sub64(smc_mont_mul64(a, b, n, n_inv), V, n);
+            if ((e >> i) & 1) {
+                a = ab;
+                b = smc_mont_sub64(smc_mont_mul64(b, b, n, n_inv), two, n);
+            } else {
+                b = ab;
+                a = smc_mont_sub64(smc_mont_mul64(a, a, n, n_inv), two, n);
+            }
+        }
+    }
+    uint64_t g = smc_gcd64(smc_mont_sub64(a, two, n), n);
+    if (g == n) {
+        a = V;
+        for (size_t i = 0; i < pl->npp; i++) {
+            a = smc_lucas_v64(a, pl->pp[i], two, NULL, n, n_inv);
+            g = smc_gcd64(smc_mont_sub64(a, two, n), n);
+            if (g != 1) return g;
+        }
+        return n;
+    }
+    if (g != 1) return g;
+    return smc_pm1_stage2_64(a, true, pl, n, n_inv, one);
+}
+
+/* ===========================================================================
+ * 64-BIT CLOSE FACTORS
+ * =========================================================================== */
+
+/* Whether x is a perfect square: residue filters mod 64 and 63, then an integer root */
+SMC_INLINE bool smc_is_square64(uint64_t x, uint64_t *root) {
+    if (!((0x0202021202030213ULL >> (x & 63)) & 1)) return false;
+    if (!((0x0402483012450293ULL >> (x % 63)) & 1)) return false;
+    uint64_t r = smc_isqrt64(x);
+    if (root) *root = r;
+    return r * r == x;
+}
+
+/*
+ * Fermat's method on odd n: a = ceil(sqrt(n)), ceil(sqrt(n)) + 1, ...
+ * until a^2 - n is a square b^2 (then n = (a - b)(a + b)), for at most
+ * 'steps' values of a. Finds p, q with |p - q| up to about
+ * 2 sqrt(2 steps) n^(1/4) in 'steps' steps.
+ */
+SMC_API uint64_t smc_fermat64(uint64_t n, uint64_t steps) {
+    uint64_t a = smc_isqrt64(n), b;
+    if (a * a == n) return a;
+    a++;
+    uint64_t r = a * a - n;     /* exact even when a * a wraps: r < 2a */
+    for (uint64_t s = 0; s < steps; s++) {
+        if (smc_is_square64(r, &b)) return a - b > 1 ? a - b : n;
+        r += 2 * a + 1;
+        a++;
+        if (r < 2 * a - 1) break;   /* a^2 - n left 64 bits */
+    }
+    return n;
+}
+
+#if defined(__SIZEOF_INT128__)
+
+/* ===========================================================================
+ * 128-BIT HELPERS
+ * =========================================================================== */
+
+SMC_INLINE smc_u128 smc_gcd128(smc_u128 a, smc_u128 b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    while ((a | b) >> 64) {
+        if (a < b) { smc_u128 t = a; a = b; b = t; }
+        if (b == 0) return a;
+        a %= b;
+    }
+    return smc_gcd64((uint64_t)a, (uint64_t)b);
+}
+
+/* floor(sqrt(x)): Newton from above, starting from the root of the top 64 bits */
+SMC_INLINE uint64_t smc_isqrt128(smc_u128 x) {
+    if ((x >> 64) == 0) return smc_isqrt64((uint64_t)x);
+    int s = (64 - smc_clz64((uint64_t)(x >> 64)) + 1) & ~1;
+    smc_u128 r = ((smc_u128)smc_isqrt64((uint64_t)(x >> s)) + 1) << (s / 2), y;
+    while ((y = (r + x / r) >> 1) < r) r = y;
+    return (uint64_t)r;
+}
+
+/* floor(cbrt(x)) by Newton's iteration from above */
+SMC_INLINE uint64_t smc_icbrt128(smc_u128 x) {
+    if (x < 8) return x ? 1 : 0;
+    uint64_t hi = (uint64_t)(x >> 64);
+    int bits = hi ? 128 - smc_clz64(hi) : 64 - smc_clz64((uint64_t)x);
+    smc_u128 r = (smc_u128)1 << ((bits + 2) / 3), y;
+    while ((y = (2 * r + x / (r * r)) / 3) < r) r = y;
+    return (uint64_t)r;
+}
+
+SMC_INLINE bool smc_is_square128_root(smc_u128 x, uint64_t *root) {
+    if ((x >> 64) == 0) return smc_is_square64((uint64_t)x, root);
+    if (!((0x0202021202030213ULL >> ((uint64_t)x & 63)) & 1)) return false;
+    if (!((0x0402483012450293ULL >> smc_mod128_64(x, 63)) & 1)) return false;
+    uint64_t r = smc_isqrt128(x);
+    if (root) *root = r;
+    return (smc_u128)r * r == x;
+}
+
+SMC_INLINE smc_u128 smc_lucas_v128(const smc_mont128 *m, smc_u128 V, uint64_t k, smc_u128 two, smc_u128 *next) {
+    smc_u128 a = two, b = V;
+    for (int i = k ? 63 - smc_clz64(k) : -1; i >= 0; i--) {
+        smc_u128 ab = smc_mont128_sub(m, smc_mont128_mul(m, a, b), V);
+        if ((k >> i) & 1) {
+            a = ab;
+            b = smc_mont128_sub(m, smc_mont128_mul(m, b, b), two);
+        } else {
+            b = ab;
+            a = smc_mont128_sub(m, smc_mont128_mul(m, a, a), two);
+        }
+    }
+    if (next) *next = b;
+    return a;
+}
+
+/* As smc_pm1_stage2_64 */
+SMC_API smc_u128 smc_pm1_stage2_128(const smc_mont128 *m, smc_u128 x, bool lucas, const smc_pm1_plan *pl) {
+    smc_u128 n = m->n;
+    if (pl->np == 0) return n;
+    const uint64_t D = SMC_PM1_D;
+    smc_u128 baby[SMC_PM1_D + 1], two = smc_mont128_add(m, m->one, m->one);
+    smc_u128 step, giant, prev = 0;
+    uint64_t k;
+
+    if (lucas) {
+        baby[0] = two;
+        baby[1] = x;
+        for (uint64_t j = 2; j <= D / 2; j++)
+            baby[j] = smc_mont128_sub(m, smc_mont128_mul(m, x, baby[j - 1]), baby[j - 2]);
+        step = smc_mont128_sub(m, smc_mont128_mul(m, baby[D / 2], baby[D / 2]), two);
+        k = (pl->primes[0] + D / 2) / D;
+        if (k == 0) {
+            giant = two;
+            prev = step;
+        } else {
+            prev = smc_lucas_v128(m, step, k - 1, two, &giant);
+        }
+    } else {
+        baby[0] = m->one;
+        for (uint64_t j = 1; j <= D; j++) baby[j] = smc_mont128_mul(m, baby[j - 1], x);
+        step = baby[D];
+        k = (pl->primes[0] + D - 1) / D;
+        giant = smc_mont128_pow(m, step, k);
+    }
+
+    size_t i0 = 0;
+    uint64_t k0 = k;
+    smc_u128 giant0 = giant, prev0 = prev, acc = m->one;
+    for (size_t i = 0; i < pl->np; i++) {
+        uint64_t q = pl->primes[i];
+        uint64_t kq = lucas ? (q + D / 2) / D : (q + D - 1) / D;
+        while (k < kq) {
+            if (lucas) {
+                smc_u128 t = smc_mont128_sub(m, smc_mont128_mul(m, giant, step), prev);
+                prev = giant;
+                giant = t;
+            } else {
+                giant = smc_mont128_mul(m, giant, step);
+            }
+            k++;
+        }
+        uint64_t j = k * D > q ? k * D - q : q - k * D;
+        acc = smc_mont128_mul(m, acc, smc_mont128_sub(m, giant, baby[j]));
+
+        if (i + 1 - i0 < SMC_PM1_GCD_BATCH && i + 1 < pl->np) continue;
+        smc_u128 g = smc_gcd128(acc, n);
+        if (g == n) {
+            k = k0;
+            giant = giant0;
+            prev = prev0;
+            for (size_t r = i0; r <= i; r++) {
+                q = pl->primes[r];
+                kq = lucas ? (q + D / 2) / D : (q + D - 1) / D;
+                while (k < kq) {
+                    if (lucas) {
+                        smc_u128 t = smc_mont128_sub(m, smc_mont128_mul(m, giant, step), prev);
+                        prev = giant;
+                        giant = t;
+                    } else {
+                        giant = smc_mont128_mul(m, giant, step);
+                    }
+                    k++;
+                }
+                j = k * D > q ? k * D - q : q - k * D;
+                g = smc_gcd128(smc_mont128_sub(m, giant, baby[j]), n);
+                if (g != 1) return g;
+            }
+            return n;
+        }
+        if (g != 1) return g;
+        i0 = i + 1;
+        k0 = k;
+        giant0 = giant;
+        prev0 = prev;
+        acc = m->one;
+    }
+    return n;
+}
+
+/* ===========================================================================
+ * 128-BIT P - 1 AND P + 1
+ * =========================================================================== */
+
+/* As smc_pm1_64 */
+SMC_API smc_u128 smc_pm1_128(smc_u128 n, const smc_pm1_plan *pl) {
+    smc_mont128 m;
+    smc_mont128_init(&m, n);
+    smc_u128 x = m.one;
+    for (size_t l = pl->En; l-- > 0;) {
+        uint64_t e = pl->E[l];
+        for (int b = 63; b >= 0; b--) {
+            x = smc_mont128_mul(&m, x, x);
+            if ((e >> b) & 1) x = smc_mont128_add(&m, smc_mont128_add(&m, x, x), x);
+        }
+    }
+    smc_u128 g = smc_gcd128(smc_mont128_sub(&m, x, m.one), n);
+    if (g == n) {
+        x = smc_mont128_mul_small(&m, m.one, 3);
+        for (size_t i = 0; i < pl->npp; i++) {
+            x = smc_mont128_pow(&m, x, pl->pp[i]);
+            g = smc_gcd128(smc_mont128_sub(&m, x, m.one), n);
+            if (g != 1) return g;
+        }
+        return n;
+    }
+    if (g != 1) return g;
+    return smc_pm1_stage2_128(&m, x, false, pl);
+}
+
+/* As smc_pp1_64 */
+SMC_API smc_u128 smc_pp1_128(smc_u128 n, const smc_pm1_plan *pl, uint64_t P) {
+    smc_mont128 m;
+    smc_mont128_init(&m, n);
+    smc_u128 two = smc_mont128_add(&m, m.one, m.one);
+    smc_u128 V = smc_mont128_mul_small(&m, m.one, P);
+    smc_u128 a = two, b = V;
+    for (size_t l = pl->En; l-- > 0;) {
+        uint64_t e = pl->E[l];
+        for (int i = 63; i >= 0; i--) {
+            smc_u128 ab = smc_mont128_sub(&m, smc_mont128_mul(&m, a, b), V);
+            if ((e >> i) & 1) {
+                a = ab;
+                b = smc_mont128_sub(&m, smc_mont128_mul(&m, b, b), two);
+            } else {
+                b = ab;
+                a = smc_mont128_sub(&m, smc_mont128_mul(&m, a, a), two);
+            }
+        }
+    }
+    smc_u128 g = smc_gcd128(smc_mont128_sub(&m, a, two), n);
+    if (g == n) {
+        a = V;
+        for (size_t i = 0; i < pl->npp; i++) {
+            a = smc_lucas_v128(&m, a, pl->pp[i], two, NULL);
+            g = smc_gcd128(smc_mont128_sub(&m, a, two), n);
+            if (g != 1) return g;
+        }
+        return n;
+    }
+    if (g != 1) return g;
+    return smc_pm1_stage2_128(&m, a, true, pl);
+}
+
+/* ===========================================================================
+ * 128-BIT AND LEHMAN CLOSE FACTORS
+ * =========================================================================== */
+
+/* As smc_fermat64 */
+SMC_API smc_u128 smc_fermat128(smc_u128 n, uint64_t steps) {
+    smc_u128 a = smc_isqrt128(n);
+    uint64_t b;
+    if (a * a == n) return a;
+    a++;
+    smc_u128 r = a * a - n;
+    for (uint64_t s = 0; s < steps; s++) {
+        if (smc_is_square128_root(r, &b)) return a - b > 1 ? a - b : n;
+        r += 2 * a + 1;
+        a++;
+        if (r < 2 * a - 1) break;
+    }
+    return n;
+}
+
+/*
+ * Lehman's method on odd n: for k = 1 .. kmax, a from ceil(sqrt(4kn))
+ * up to sqrt(4kn) + n^(1/6) / (4 sqrt(k)), but at most 'steps' values (0 = all),
+ * look for a^2 - 4kn = b^2; then gcd(a + b, n) splits n. Finds p, q with
+ * p / q close to a ratio u / v with uv <= kmax, where Fermat needs
+ * p / q close to 1. Stops early once 4kn would leave 128 bits.
+ */
+SMC_API smc_u128 smc_lehman128(smc_u128 n, uint64_t kmax, uint64_t steps) {
+    uint64_t c = smc_icbrt128(n);
+    for (uint64_t k = 1; k <= kmax; k++) {
+        if (n > (~(smc_u128)0 >> 2) / k) break;
+        smc_u128 kn4 = 4 * (smc_u128)k * n;
+        smc_u128 a = smc_isqrt128(kn4);
+        if (a * a < kn4) a++;
+        uint64_t w = smc_isqrt64(c / (16 * k));             /* n^(1/6) / (4 sqrt(k)) */
+        smc_u128 amax = a + (steps && steps - 1 < w ? steps - 1 : w);
+        uint64_t b;
+        for (; a <= amax; a++) {
+            if (!smc_is_square128_root(a * a - kn4, &b)) continue;
+            smc_u128 g = smc_gcd128((a + b) % n, n);
+            if (g > 1 && g < n) return g;
+        }
+    }
+    return n;
+}
+
+/* As smc_lehman128, for 64-bit n */
+SMC_API uint64_t smc_lehman64(uint64_t n, uint64_t kmax, uint64_t steps) {
+    return (uint64_t)smc_lehman128(n, kmax, steps);
+}
+
+#endif /* __SIZEOF_INT128__ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_PM1_H */
@@ -0,0 +1,835 @@
+/*
+ * smcPrime - Primes among Polynomial Values
+ *
+ * Finds the n in [lo, hi) for which f(n) is prime, for an integer
+ * polynomial f (e.g. n^2 + 1), by sieving the index n rather than the value:
+ * - The roots of f modulo each sieving prime p are found once per plan:
+ *   directly for linear f, with a modular square root for quadratics, and
+ *   by splitting gcd(x^p - x, f) (Cantor-Zassenhaus) otherwise
+ * - Each root r then crosses off n = r, r + p, r + 2p, ... in cache-sized
+ *   segments; threads take contiguous slices of the index range
+ * - Survivors whose value is above bound^2 are confirmed with
+ *   smc_is_prime64; the few small n where f(n) may itself be a sieving
+ *   prime are tested directly
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_POLY_H
+#define SMCPRIME_POLY_H
+
+#include "smcprime.h"
+#include "smcprime_sieve.h"
+#include "smcprime_sys.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Highest supported degree */
+#ifndef SMC_POLY_MAX_DEGREE
+  #define SMC_POLY_MAX_DEGREE 8
+#endif
+
+/* Primes up to this find their roots by trying every residue */
+#define SMC_POLY_SMALL_P 64
+
+/* Limits on the default sieving bound; see smc_poly_default_bound */
+#ifndef SMC_POLY_MIN_BOUND
+  #define SMC_POLY_MIN_BOUND 1024
+#endif
+#ifndef SMC_POLY_MAX_BOUND
+  #define SMC_POLY_MAX_BOUND (1u << 30)
+#endif
+
+/* Sieve offsets are kept in 32 bits, which caps any bound at 2^31 */
+#define SMC_POLY_BOUND_LIMIT (1u << 31)
+
+/* Sieving primes handed to one root-finding task */
+#define SMC_POLY_ROOT_BLOCK 4096
+
+/* f(n) = c[0] + c[1] n + ... + c[deg] n^deg */
+typedef struct smc_poly {
+    unsigned deg;
+    int64_t c[SMC_POLY_MAX_DEGREE + 1];
+} smc_poly;
+
+/*
+ * f(n) into *v. Returns false if f(n) is negative or does not fit 64 bits
+ * (or an intermediate Horner value does not).
+ */
+SMC_API bool smc_poly_eval(const smc_poly *f, uint64_t n, uint64_t *v) {
+    uint64_t mag = 0;
+    bool neg = false;
+    for (int i = (int)f->deg; i >= 0; i--) {
+        uint64_t hi;
+        mag = smc_mul64_wide(mag, n, &hi);
+        if (hi) return false;
+        int64_t c = f->c[i];
+        uint64_t cm = c < 0 ? 0 - (uint64_t)c : (uint64_t)c;
+        if (mag == 0 || neg == (c < 0)) {
+            if (mag + cm < mag) return false;
+            if (mag == 0) neg = c < 0;
+            mag += cm;
+        } else if (mag >= cm) {
+            mag -= cm;
+        } else {
+            mag = cm - mag;
+            neg = !neg;
+        }
+    }
+    *v = mag;
+    return !neg || mag == 0;
+}
+
+/* ===========================================================================
+ * POLYNOMIALS MOD p
+ *
+ * Coefficients ascending, reduced mod a prime p < 2^32, so any product of
+ * two fits 64 bits. Degree -1 is the zero polynomial.
+ * =========================================================================== */
+
+SMC_INLINE int smc_polyp_trim(const uint64_t *a, int d) {
+    while (d >= 0 && a[d] == 0) d--;
+    return d;
+}
+
+/*
+ * Divide a (degree da) by monic m (degree dm >= 1): the remainder
+ * replaces a and its degree is returned; the quotient goes to q unless NULL.
+ */
+SMC_API int smc_polyp_divrem(uint64_t *a, int da, const uint64_t *m, int dm, uint64_t p, uint64_t *q) {
+    for (int i = da; i >= dm; i--) {
+        uint64_t t = a[i];
+        if (q) q[i - dm] = t;
+        if (t == 0) continue;
+        for (int j = 0; j < dm; j++) a[i - dm + j] = (a[i - dm + j] + (p - t) * m[j]) % p;
+        a[i] = 0;
+    }
+    return smc_polyp_trim(a, da < dm - 1 ? da : dm - 1);
+}
+
+/* a b mod m into out (room for dm coefficients); returns the degree */
+SMC_API int smc_polyp_mulmod(uint64_t *out, const uint64_t *a, int da, const uint64_t *b, int db,
+                             const uint64_t *m, int dm, uint64_t p) {
+    uint64_t t[2 * SMC_POLY_MAX_DEGREE + 1];
+    if (da < 0 || db < 0) return -1;
+    memset(t, 0, (size_t)(da + db + 1) * sizeof(uint64_t));
+    for (int i = 0; i <= da; i++)
+        for (int j = 0; j <= db; j++) t[i + j] = (t[i + j] + a[i] * b[j] % p) % p;
+    int d = smc_polyp_divrem(t, da + db, m, dm, p, NULL);
+    memcpy(out, t, (size_t)(d + 1) * sizeof(uint64_t));
+    return d;
+}
+
+/* base^e mod m into out (room for dm coefficients); base has degree < dm */
+SMC_API int smc_polyp_powmod(uint64_t *out, const uint64_t *base, int db, uint64_t e,
+                             const uint64_t *m, int dm, uint64_t p) {
+    out[0] = 1;
+    int d = 0;
+    for (int i = 63 - smc_clz64(e | 1); i >= 0; i--) {
+        d = smc_polyp_mulmod(out, out, d, out, d, m, dm, p);
+        if ((e >> i) & 1) d = smc_polyp_mulmod(out, out, d, base, db, m, dm, p);
+    }
+    return e ? d : 0;
+}
+
+/* Scale a to a monic polynomial in place */
+SMC_INLINE void smc_polyp_monic(uint64_t *a, int d, uint64_t p) {
+    uint64_t inv = smc_modinv64(a[d], p);
+    for (int i = 0; i <= d; i++) a[i] = a[i] * inv % p;
+}
+
+/* Monic gcd(a, b) into a (both overwritten); returns its degree */
+SMC_API int smc_polyp_gcd(uint64_t *a, int da, uint64_t *b, int db, uint64_t p) {
+    while (db >= 0) {
+        smc_polyp_monic(b, db, p);
+        da = db > 0 ? smc_polyp_divrem(a, da, b, db, p, NULL) : -1;
+        uint64_t t[SMC_POLY_MAX_DEGREE + 1];
+        memcpy(t, a, sizeof(t));
+        memcpy(a, b, sizeof(t));
+        memcpy(b, t, sizeof(t));
+        int td = da;
+        da = db;
+        db = td;
+    }
+    if (da >= 0) smc_polyp_monic(a, da, p);
+    return da;
+}
+
+/*
+ * A square root of a modulo an odd prime p, or UINT32_MAX if a is a
+ * non-residue. One exponentiation in Montgomery form for p = 3 (mod 4)
+ * and, by Atkin's formula, for p = 5 (mod 8); Tonelli-Shanks otherwise.
+ */
+SMC_API uint32_t smc_sqrtmod32(uint32_t a, uint32_t p) {
+    a %= p;
+    if (a == 0) return 0;
+    uint32_t n_inv = smc_mont_inv32(p), one = (UINT32_MAX % p) + 1;
+    uint32_t am = (uint32_t)(((uint64_t)a << 32) % p), x;
+    if ((p & 3) == 3) {
+        x = smc_mont_pow32(am, (p + 1) / 4, p, n_inv, one);
+    } else if ((p & 7) == 5) {
+        /* b = (2a)^((p-5)/8), i = 2a b^2 (a square root of -1), x = a b (i - 1) */
+        uint32_t a2 = am >= p - am ? am - (p - am) : am + am;
+        uint32_t b = smc_mont_pow32(a2, (p - 5) / 8, p, n_inv, one);
+        uint32_t i = smc_mont_mul32(smc_mont_mul32(a2, b, p, n_inv), b, p, n_inv);
+        x = smc_mont_mul32(smc_mont_mul32(am, b, p, n_inv), i >= one ? i - one : i + (p - one), p, n_inv);
+    } else {
+        uint32_t q = p - 1, s = 0;
+        while ((q & 1) == 0) { q >>= 1; s++; }
+
+        /* x = a^((q+1)/2) and t = a^q, so x^2 = a t; a is a residue iff t^(2^(s-1)) = 1 */
+        uint32_t y = smc_mont_pow32(am, (q - 1) / 2, p, n_inv, one);
+        x = smc_mont_mul32(y, am, p, n_inv);
+        uint32_t t = smc_mont_mul32(y, x, p, n_inv), u = t;
+        for (uint32_t i = 1; i < s; i++) u = smc_mont_mul32(u, u, p, n_inv);
+        if (u != one) return UINT32_MAX;
+
+        /* A non-residue z: by reciprocity, (q / p) = (p mod q / q) for odd primes q as p = 1 (mod 4) */
+        uint32_t z = 0, neg_one = p - one;
+        for (size_t i = 0; i < SMC_NUM_PRIME_INV64 && z == 0; i++) {
+            uint32_t ell = SMC_SMALL_PRIMES[i];
+            if (ell < p && smc_powmod32(p % ell, (ell - 1) / 2, ell) == ell - 1) z = ell;
+        }
+        if (z == 0)
+            for (z = 3; smc_mont_pow32(smc_mont_small32(z, p, one), (p - 1) / 2, p, n_inv, one) != neg_one; z++) {}
+        uint32_t c = smc_mont_pow32(smc_mont_small32(z, p, one), q, p, n_inv, one);
+        while (t != one) {
+            uint32_t i = 0;
+            for (u = t; u != one; i++) u = smc_mont_mul32(u, u, p, n_inv);
+            uint32_t b = c;
+            for (uint32_t j = i + 1; j < s; j++) b = smc_mont_mul32(b, b, p, n_inv);
+            x = smc_mont_mul32(x, b, p, n_inv);
+            c = smc_mont_mul32(b, b, p, n_inv);
+            t = smc_mont_mul32(t, c, p, n_inv);
+            s = i;
+        }
+        return smc_mont_mul32(x, 1, p, n_inv);
+    }
+    if (smc_mont_mul32(x, x, p, n_inv) != am) return UINT32_MAX;
+    return smc_mont_mul32(x, 1, p, n_inv);
+}
+
+/* Distinct roots of a x^2 + b x + c mod an odd prime p (a != 0) */
+SMC_API unsigned smc_polyp_quadratic(uint64_t a, uint64_t b, uint64_t c, uint64_t p, uint32_t *roots) {
+    uint64_t disc = (b * b % p + p - 4 * a % p * c % p) % p;
+    uint32_t s = smc_sqrtmod32((uint32_t)disc, (uint32_t)p);
+    if (s == UINT32_MAX) return 0;
+    uint64_t inv = (p + 1) / 2;
+    if (a != 1) inv = inv * smc_modinv64(a, p) % p;
+    roots[0] = (uint32_t)((p - b + s) % p * inv % p);
+    if (s == 0) return 1;
+    roots[1] = (uint32_t)((2 * p - b - s) % p * inv % p);
+    return 2;
+}
+
+/* Roots of a monic, squarefree g (degree dg) that splits into linear factors mod p */
+SMC_API unsigned smc_polyp_split(const uint64_t *g, int dg, uint64_t p, uint32_t *roots) {
+    if (dg <= 0) return 0;
+    if (dg == 1) { roots[0] = (uint32_t)((p - g[0]) % p); return 1; }
+    if (dg == 2) return smc_polyp_quadratic(1, g[1], g[0], p, roots);
+
+    /* gcd((x + delta)^((p-1)/2) - 1, g) takes the roots r with r + delta a residue */
+    for (uint64_t delta = 1;; delta++) {
+        uint64_t h[SMC_POLY_MAX_DEGREE + 1] = {0}, a[SMC_POLY_MAX_DEGREE + 1] = {0};
+        uint64_t base[2] = {delta % p, 1};
+        int dh = smc_polyp_powmod(h, base, 1, (p - 1) / 2, g, dg, p);
+        if (dh < 0) { h[0] = 0; dh = 0; }
+        h[0] = (h[0] + p - 1) % p;
+        dh = smc_polyp_trim(h, dh);
+        memcpy(a, g, (size_t)(dg + 1) * sizeof(uint64_t));
+        int da = smc_polyp_gcd(a, dg, h, dh, p);
+        if (da <= 0 || da >= dg) continue;
+
+        uint64_t r[SMC_POLY_MAX_DEGREE + 1], q[SMC_POLY_MAX_DEGREE + 1];
+        memcpy(r, g, (size_t)(dg + 1) * sizeof(uint64_t));
+        smc_polyp_divrem(r, dg, a, da, p, q);
+        unsigned k = smc_polyp_split(a, da, p, roots);
+        return k + smc_polyp_split(q, dg - da, p, roots + k);
+    }
+}
+
+/*
+ * Distinct roots of f modulo a prime p < 2^32 into roots (room for
+ * SMC_POLY_MAX_DEGREE entries); returns how many. A polynomial with every
+ * coefficient divisible by p has no roots reported.
+ */
+SMC_API unsigned smc_poly_roots_mod(const smc_poly *f, uint32_t p, uint32_t *roots) {
+    uint64_t a[SMC_POLY_MAX_DEGREE + 1] = {0};
+    for (unsigned i = 0; i <= f->deg; i++) {
+        int64_t r = f->c[i] % (int64_t)p;
+        a[i] = (uint64_t)(r < 0 ? r + (int64_t)p : r);
+    }
+    int d = smc_polyp_trim(a, (int)f->deg);
+    if (d <= 0) return 0;
+
+    if (p <= SMC_POLY_SMALL_P) {
+        unsigned k = 0;
+        for (uint64_t x = 0; x < p; x++) {
+            uint64_t v = 0;
+            for (int i = d; i >= 0; i--) v = (v * x + a[i]) % p;
+            if (v == 0) roots[k++] = (uint32_t)x;
+        }
+        return k;
+    }
+    if (d == 1) {
+        roots[0] = (uint32_t)((p - a[0]) * smc_modinv64(a[1], p) % p);
+        return 1;
+    }
+    if (d == 2) return smc_polyp_quadratic(a[2], a[1], a[0], p, roots);
+
+    /* The roots are those of gcd(x^p - x, f) */
+    smc_polyp_monic(a, d, p);
+    uint64_t x[2] = {0, 1}, g[SMC_POLY_MAX_DEGREE + 1] = {0};
+    int dg = smc_polyp_powmod(g, x, 1, p, a, d, p);
+    if (dg < 1) { g[1] = 0; dg = 1; }
+    g[1] = (g[1] + p - 1) % p;
+    dg = smc_polyp_trim(g, dg);
+    uint64_t m[SMC_POLY_MAX_DEGREE + 1];
+    memcpy(m, a, sizeof(m));
+    dg = smc_polyp_gcd(m, d, g, dg, p);
+    return smc_polyp_split(m, dg, p, roots);
+}
+
+/* ===========================================================================
+ * SIEVE PLAN
+ *
+ * The root table shared by every range and thread: one entry (p, r) per
+ * root r of f mod p, for the primes p <= bound.
+ * =========================================================================== */
+
+typedef struct smc_poly_plan {
+    smc_poly f;
+    uint64_t bound;
+    uint32_t *p;            /* sieving prime of each entry, ascending */
+    uint32_t *r;            /* f(r) = 0 (mod p) */
+    size_t n;
+    size_t nword;           /* leading entries with p < 64, sieved by word patterns */
+    uint64_t *pattern;      /* per such prime, p words: the bits to clear at each phase */
+    uint64_t small_end;     /* f(n) may be <= bound below this: tested directly */
+} smc_poly_plan;
+
+SMC_API void smc_poly_plan_free(smc_poly_plan *pl) {
+    free(pl->p);
+    free(pl->r);
+    free(pl->pattern);
+    memset(pl, 0, sizeof(*pl));
+}
+
+/*
+ * Sieving bound for n in [lo, hi): sqrt of the largest |f(n)|, which makes
+ * every survivor prime, capped at SMC_POLY_MAX_BOUND and at the range
+ * length (a prime above it crosses off at most one n per root). Roots of
+ * cubics and beyond cost about ten times a square root, so for those the
+ * cap is a sixteenth of the range.
+ */
+SMC_API uint64_t smc_poly_default_bound(const smc_poly *f, uint64_t lo, uint64_t hi) {
+    uint64_t m = 0, top = hi ? hi - 1 : 0;
+    for (int i = (int)f->deg; i >= 0; i--) {
+        uint64_t h, c = f->c[i] < 0 ? 0 - (uint64_t)f->c[i] : (uint64_t)f->c[i];
+        m = smc_mul64_wide(m, top, &h);
+        if (h || m + c < m) { m = UINT64_MAX; break; }
+        m += c;
+    }
+    uint64_t b = (uint64_t)smc_isqrt64(m) + 1;
+    uint64_t span = hi > lo ? hi - lo : 0;
+    if (f->deg > 2) span /= 16;
+    if (span < SMC_POLY_MIN_BOUND) span = SMC_POLY_MIN_BOUND;
+    if (b > span) b = span;
+    return b > SMC_POLY_MAX_BOUND ? SMC_POLY_MAX_BOUND : b;
+}
+
+/*
+ * Smallest N with |f(n)| > bound for every n >= N, from
+ * |f(n)| >= n^(d-1) (|c_d| n - sum of the lower |c_i|), which grows once
+ * positive. UINT64_MAX for constants and when f has content above 1, so
+ * that every value is tested directly.
+ */
+SMC_API uint64_t smc_poly_small_end(const smc_poly *f, uint64_t bound) {
+    unsigned d = f->deg;
+    uint64_t g = 0, s = 0;
+    for (unsigned i = 0; i <= d; i++) {
+        uint64_t c = f->c[i] < 0 ? 0 - (uint64_t)f->c[i] : (uint64_t)f->c[i];
+        uint64_t x = g, y = c;
+        while (y) { uint64_t t = x % y; x = y; y = t; }
+        g = x;
+        if (i < d) s = s + c < s ? UINT64_MAX : s + c;
+    }
+    if (d == 0 || g != 1) return UINT64_MAX;
+    uint64_t a = f->c[d] < 0 ? 0 - (uint64_t)f->c[d] : (uint64_t)f->c[d];
+
+    /* Lower bound at n, saturating */
+    #define SMC_POLY_LOWER(n, out) do { \
+        uint64_t h_, v_ = smc_mul64_wide(a, (n), &h_); \
+        if (h_) v_ = UINT64_MAX; \
+        v_ = v_ > s ? v_ - s : 0; \
+        for (unsigned k_ = 1; k_ < d && v_ && v_ != UINT64_MAX; k_++) { \
+            v_ = smc_mul64_wide(v_, (n), &h_); \
+            if (h_) v_ = UINT64_MAX; \
+        } \
+        (out) = v_; \
+    } while (0)
+
+    uint64_t lo = s / a + 1, v;
+    SMC_POLY_LOWER(lo, v);
+    if (v > bound) return lo;
+    uint64_t hi = lo;
+    do {
+        lo = hi;
+        if (hi > UINT64_MAX / 2) return UINT64_MAX;
+        hi *= 2;
+        SMC_POLY_LOWER(hi, v);
+    } while (v <= bound);
+    while (hi - lo > 1) {
+        uint64_t mid = lo + (hi - lo) / 2;
+        SMC_POLY_LOWER(mid, v);
+        if (v > bound) hi = mid; else lo = mid;
+    }
+    #undef SMC_POLY_LOWER
+    return hi;
+}
+
+typedef struct smc_poly_root_job {
+    const smc_poly *f;
+    const uint32_t *primes;
+    size_t np;
+    uint32_t **p, **r;      /* per block output */
+    size_t *n;
+    volatile uint64_t failed;
+    bool disc;              /* quadratic with discriminant -+2^e m, m odd */
+    bool disc_neg;
+    int disc_e;
+    uint64_t disc_m;
+} smc_poly_root_job;
+
+/*
+ * (D / p) for the discriminant of a quadratic job, by reciprocity: one
+ * remainder and a Jacobi symbol below m, where the square root would spend
+ * an exponentiation to find that half the primes give no roots.
+ */
+SMC_API int smc_poly_disc_symbol(const smc_poly_root_job *job, uint32_t p) {
+    int t = job->disc_neg && (p & 3) == 3 ? -1 : 1;
+    if ((job->disc_e & 1) && ((p & 7) == 3 || (p & 7) == 5)) t = -t;
+    uint64_t n = job->disc_m, a = p % n;
+    if ((n & 3) == 3 && (p & 3) == 3) t = -t;
+    while (a != 0) {
+        int z = smc_ctz64(a);
+        a >>= z;
+        if ((z & 1) && ((n & 7) == 3 || (n & 7) == 5)) t = -t;
+        uint64_t x = a;
+        a = n;
+        n = x;
+        if ((a & 3) == 3 && (n & 3) == 3) t = -t;
+        a %= n;
+    }
+    return n == 1 ? t : 0;
+}
+
+SMC_API void smc_poly_root_task(void *arg, size_t index) {
+    smc_poly_root_job *job = (smc_poly_root_job *)arg;
+    size_t a = index * SMC_POLY_ROOT_BLOCK;
+    size_t b = job->np - a < SMC_POLY_ROOT_BLOCK ? job->np : a + SMC_POLY_ROOT_BLOCK;
+    size_t cap = (b - a) * (job->f->deg < 2 ? 1 : job->f->deg), k = 0;
+    uint32_t *p = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    uint32_t *r = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    if (p == NULL || r == NULL) {
+        free(p);
+        free(r);
+        smc_atomic_store64(&job->failed, 1);
+        return;
+    }
+    uint64_t lead = job->f->c[2] < 0 ? 0 - (uint64_t)job->f->c[2] : (uint64_t)job->f->c[2];
+    for (size_t i = a; i < b; i++) {
+        uint32_t q = job->primes[i];
+        if (job->disc && q > SMC_POLY_SMALL_P && lead % q && smc_poly_disc_symbol(job, q) < 0) continue;
+        unsigned m = smc_poly_roots_mod(job->f, q, r + k);
+        for (unsigned j = 0; j < m; j++) p[k + j] = job->primes[i];
+        k += m;
+    }
+    job->p[index] = p;
+    job->r[index] = r;
+    job->n[index] = k;
+}
+
+/*
+ * Find the roots of f (degree 1 .. SMC_POLY_MAX_DEGREE) modulo every prime
+ * up to bound (at most SMC_POLY_BOUND_LIMIT) on up to 'threads' threads (0 = all).
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_poly_plan_init(smc_poly_plan *pl, const smc_poly *f, uint64_t bound, unsigned threads) {
+    memset(pl, 0, sizeof(*pl));
+    if (f->deg > SMC_POLY_MAX_DEGREE) return false;
+    if (bound > SMC_POLY_BOUND_LIMIT) bound = SMC_POLY_BOUND_LIMIT;
+    pl->f = *f;
+    while (pl->f.deg > 0 && pl->f.c[pl->f.deg] == 0) pl->f.deg--;
+    pl->bound = bound;
+    pl->small_end = smc_poly_small_end(&pl->f, bound);
+    if (pl->small_end == UINT64_MAX) return true;
+
+    size_t np = 0;
+    uint32_t *primes = smc_sieve_primes32((uint32_t)bound, &np);
+    if (primes == NULL) return false;
+    size_t blocks = (np + SMC_POLY_ROOT_BLOCK - 1) / SMC_POLY_ROOT_BLOCK;
+    smc_poly_root_job job;
+    job.f = &pl->f;
+    job.primes = primes;
+    job.np = np;
+    job.disc = false;
+    const int64_t *c = pl->f.c;
+    if (pl->f.deg == 2 && c[0] > -(1LL << 30) && c[0] < (1LL << 30) && c[1] > -(1LL << 31) &&
+        c[1] < (1LL << 31) && c[2] > -(1LL << 30) && c[2] < (1LL << 30)) {
+        int64_t d = c[1] * c[1] - 4 * c[2] * c[0];
+        uint64_t m = d < 0 ? 0 - (uint64_t)d : (uint64_t)d;
+        job.disc = d != 0;
+        job.disc_neg = d < 0;
+        job.disc_e = job.disc ? smc_ctz64(m) : 0;
+        job.disc_m = job.disc ? m >> job.disc_e : 1;
+    }
+    job.p = (uint32_t **)calloc(blocks + 1, sizeof(uint32_t *));
+    job.r = (uint32_t **)calloc(blocks + 1, sizeof(uint32_t *));
+    job.n = (size_t *)calloc(blocks + 1, sizeof(size_t));
+    job.failed = job.p == NULL || job.r == NULL || job.n == NULL;
+    if (!job.failed) smc_parallel_for(blocks, threads, smc_poly_root_task, &job);
+
+    size_t total = 0;
+    for (size_t i = 0; !job.failed && i < blocks; i++) total += job.n[i];
+    if (!job.failed) {
+        pl->p = (uint32_t *)malloc((total + 1) * sizeof(uint32_t));
+        pl->r = (uint32_t *)malloc((total + 1) * sizeof(uint32_t));
+        if (pl->p == NULL || pl->r == NULL) job.failed = 1;
+    }
+    for (size_t i = 0; i < blocks && job.p && job.r && job.n; i++) {
+        if (!job.failed) {
+            memcpy(pl->p + pl->n, job.p[i], job.n[i] * sizeof(uint32_t));
+            memcpy(pl->r + pl->n, job.r[i], job.n[i] * sizeof(uint32_t));
+            pl->n += job.n[i];
+        }
+        free(job.p[i]);
+        free(job.r[i]);
+    }
+    free(job.p);
+    free(job.r);
+    free(job.n);
+    free(primes);
+    if (job.failed) { smc_poly_plan_free(pl); return false; }
+
+    /* Bit i of word 'phase' is set iff phase + i is a root mod p */
+    size_t words = 0;
+    while (pl->nword < pl->n && pl->p[pl->nword] < 64) {
+        if (pl->nword == 0 || pl->p[pl->nword] != pl->p[pl->nword - 1]) words += pl->p[pl->nword];
+        pl->nword++;
+    }
+    pl->pattern = (uint64_t *)calloc(words + 1, sizeof(uint64_t));
+    if (pl->pattern == NULL) { smc_poly_plan_free(pl); return false; }
+    for (size_t k = 0, at = 0; k < pl->nword; k++) {
+        uint32_t p = pl->p[k];
+        if (k && p != pl->p[k - 1]) at += pl->p[k - 1];
+        for (uint32_t phase = 0; phase < p; phase++)
+            for (uint32_t i = 0; i < 64; i++)
+                if ((phase + i) % p == pl->r[k]) pl->pattern[at + phase] |= 1ULL << i;
+    }
+    return true;
+}
+
+/* ===========================================================================
+ * INDEX SIEVE ITERATOR
+ *
+ * After each successful smc_poly_sieve_next call, bit i of 'bits' is set
+ * iff f(seg_lo + i) is prime, for i < seg_bits.
+ *
+ * Entries with p below 64 apply precomputed word patterns; the others
+ * below the segment length keep their next offset in an array, the
+ * smallest of them working through the segment one L1 block at a time.
+ * The rest hit a segment at most once per root, so scanning them every
+ * segment would dominate: each waits instead in the bucket of the segment
+ * it hits next, and moves on to a later bucket once used.
+ * =========================================================================== */
+
+/* Hits per bucket block */
+#define SMC_POLY_BUCKET 1024
+
+typedef struct smc_poly_hit {
+    uint32_t p;
+    uint32_t off;           /* bit within the segment */
+} smc_poly_hit;
+
+typedef struct smc_poly_sieve {
+    const smc_poly_plan *pl;
+    uint64_t lo, span;      /* range [lo, lo + span) */
+    uint64_t pos;           /* next n to sieve */
+    uint64_t seg;           /* segments done */
+    uint64_t seg_lo;        /* n represented by bit 0 */
+    size_t seg_bits, seg_cap;
+    int shift;              /* seg_cap = 2^shift */
+    uint64_t *bits;
+    size_t sub_bits;        /* L1-sized block of the segment */
+    size_t nsub;            /* entries with p < sub_bits */
+    size_t nsmall;          /* entries with p < seg_cap */
+    uint32_t *next;         /* per small entry: next offset, from the segment start */
+    smc_poly_hit *pool;     /* blocks of SMC_POLY_BUCKET hits */
+    uint32_t *link;         /* per block: next block of its bucket, or of the free list */
+    uint32_t *head, *fill;  /* per bucket: newest block (UINT32_MAX if none), hits in it */
+    uint32_t free_block;
+    size_t nbuckets;        /* a power of two past the longest jump */
+} smc_poly_sieve;
+
+SMC_API void smc_poly_sieve_free(smc_poly_sieve *s) {
+    free(s->bits);
+    free(s->next);
+    free(s->pool);
+    free(s->link);
+    free(s->head);
+    free(s->fill);
+    memset(s, 0, sizeof(*s));
+}
+
+/* Queue a hit at bit 'off' of segment t */
+SMC_INLINE void smc_poly_sieve_push(smc_poly_sieve *s, uint64_t t, uint32_t p, uint32_t off) {
+    size_t b = (size_t)(t & (s->nbuckets - 1));
+    uint32_t h = s->head[b];
+    if (h == UINT32_MAX || s->fill[b] == SMC_POLY_BUCKET) {
+        uint32_t n = s->free_block;
+        s->free_block = s->link[n];
+        s->link[n] = h;
+        s->head[b] = h = n;
+        s->fill[b] = 0;
+    }
+    smc_poly_hit *e = s->pool + (size_t)h * SMC_POLY_BUCKET + s->fill[b]++;
+    e->p = p;
+    e->off = off;
+}
+
+/* Prepare to sieve n in [lo, hi). Returns false on allocation failure. */
+SMC_API bool smc_poly_sieve_init(smc_poly_sieve *s, const smc_poly_plan *pl, uint64_t lo, uint64_t hi) {
+    memset(s, 0, sizeof(*s));
+    s->pl = pl;
+    s->lo = s->pos = lo;
+    s->span = hi > lo ? hi - lo : 0;
+    if (hi <= lo) return true;
+
+    size_t bytes = smc_sieve_segment_bytes(pl->n);
+    s->shift = 63 - smc_clz64((uint64_t)bytes * 8);
+    while (s->shift > 6 && (1ULL << (s->shift - 1)) >= s->span) s->shift--;
+    s->seg_cap = (size_t)1 << s->shift;
+    s->sub_bits = smc_cache_sizes()->l1d * 8;
+    if (s->sub_bits == 0 || s->sub_bits > s->seg_cap) s->sub_bits = s->seg_cap;
+    while (s->nsub < pl->n && pl->p[s->nsub] < s->sub_bits) s->nsub++;
+    s->nsmall = s->nsub;
+    while (s->nsmall < pl->n && pl->p[s->nsmall] < s->seg_cap) s->nsmall++;
+
+    /* First offsets; buckets get room for the large entries that hit the range */
+    uint32_t *first = (uint32_t *)malloc((pl->n + 1) * sizeof(uint32_t));
+    if (first == NULL) return false;
+    size_t live = 0;
+    uint32_t m = 0;
+    for (size_t k = 0; k < pl->n; k++) {
+        uint32_t p = pl->p[k];
+        if (k == 0 || p != pl->p[k - 1]) m = (uint32_t)(lo % p);
+        first[k] = pl->r[k] >= m ? pl->r[k] - m : pl->r[k] + (p - m);
+        live += k >= s->nsmall && first[k] < s->span;
+    }
+    size_t blocks = (live + SMC_POLY_BUCKET - 1) / SMC_POLY_BUCKET;
+    s->nbuckets = 2;
+    while (s->nbuckets < (pl->bound >> s->shift) + 2) s->nbuckets *= 2;
+    blocks += s->nbuckets + 1;
+
+    s->bits = (uint64_t *)malloc(s->seg_cap / 8);
+    s->next = (uint32_t *)malloc((s->nsmall + 1) * sizeof(uint32_t));
+    s->pool = (smc_poly_hit *)malloc(blocks * SMC_POLY_BUCKET * sizeof(smc_poly_hit));
+    s->link = (uint32_t *)malloc(blocks * sizeof(uint32_t));
+    s->head = (uint32_t *)malloc(s->nbuckets * sizeof(uint32_t));
+    s->fill = (uint32_t *)calloc(s->nbuckets, sizeof(uint32_t));
+    if (s->bits == NULL || s->next == NULL || s->pool == NULL || s->link == NULL ||
+        s->head == NULL || s->fill == NULL) {
+        free(first);
+        smc_poly_sieve_free(s);
+        return false;
+    }
+    for (size_t i = 0; i < blocks; i++) s->link[i] = i + 1 < blocks ? (uint32_t)(i + 1) : UINT32_MAX;
+    for (size_t i = 0; i < s->nbuckets; i++) s->head[i] = UINT32_MAX;
+
+    for (size_t k = 0; k < pl->n; k++) {
+        uint32_t o = first[k];
+        if (k < s->nsmall) s->next[k] = o;
+        else if (o < s->span) smc_poly_sieve_push(s, o >> s->shift, pl->p[k], o & (uint32_t)(s->seg_cap - 1));
+    }
+    free(first);
+    return true;
+}
+
+/* Sieve the next segment of indices. Returns false once exhausted. */
+SMC_API bool smc_poly_sieve_next(smc_poly_sieve *s) {
+    uint64_t done = s->pos - s->lo;
+    if (done >= s->span) return false;
+    const smc_poly_plan *pl = s->pl;
+    uint64_t b0 = s->pos;
+    size_t len = s->span - done < s->seg_cap ? (size_t)(s->span - done) : s->seg_cap;
+    size_t words = (len + 63) / 64;
+    uint64_t *bits = s->bits;
+
+    memset(bits, 0xFF, words * 8);
+    if (len & 63) bits[words - 1] = (1ULL << (len & 63)) - 1;
+
+    /* Primes below 64 clear whole words; the phase advances by 64 mod p */
+    const uint64_t *pat = pl->pattern;
+    for (size_t k = 0; k < pl->nword; k++) {
+        uint32_t p = pl->p[k];
+        if (k + 1 < pl->nword && pl->p[k + 1] == p) continue;
+        uint32_t phase = (uint32_t)(b0 % p), step = 64 % p;
+        for (size_t w = 0; w < words; w++) {
+            bits[w] &= ~pat[phase];
+            phase += step;
+            if (phase >= p) phase -= p;
+        }
+        pat += p;
+    }
+
+    /* Primes below the L1 block size cross off one block at a time */
+    for (size_t at = 0; at < len; at += s->sub_bits) {
+        uint32_t end = (uint32_t)(len - at < s->sub_bits ? len : at + s->sub_bits);
+        for (size_t k = pl->nword; k < s->nsub; k++) {
+            uint32_t j = s->next[k], p = pl->p[k];
+            for (; j < end; j += p) bits[j >> 6] &= ~(1ULL << (j & 63));
+            s->next[k] = j;
+        }
+    }
+    for (size_t k = pl->nword; k < s->nsub; k++) s->next[k] -= (uint32_t)len;
+
+    for (size_t k = s->nsub; k < s->nsmall; k++) {
+        uint32_t j = s->next[k], p = pl->p[k];
+        for (; j < len; j += p) bits[j >> 6] &= ~(1ULL << (j & 63));
+        s->next[k] = j - (uint32_t)len;
+    }
+
+    /* This segment's bucket; each hit moves on to the segment of its next one */
+    uint32_t mask = (uint32_t)(s->seg_cap - 1);
+    size_t b = (size_t)(s->seg & (s->nbuckets - 1));
+    uint32_t h = s->head[b], cnt = s->fill[b];
+    s->head[b] = UINT32_MAX;
+    s->fill[b] = 0;
+    while (h != UINT32_MAX) {
+        const smc_poly_hit *e = s->pool + (size_t)h * SMC_POLY_BUCKET;
+        for (uint32_t i = 0; i < cnt; i++) {
+            uint32_t off = e[i].off, p = e[i].p;
+            bits[off >> 6] &= ~(1ULL << (off & 63));
+            uint64_t at = (uint64_t)off + p;
+            uint64_t t = s->seg + (at >> s->shift);
+            if ((t << s->shift) + (at & mask) < s->span) smc_poly_sieve_push(s, t, p, (uint32_t)at & mask);
+        }
+        uint32_t n = s->link[h];
+        s->link[h] = s->free_block;
+        s->free_block = h;
+        h = n;
+        cnt = SMC_POLY_BUCKET;
+    }
+
+    /* Where f(n) may be a sieving prime, or nothing was sieved, test directly */
+    uint64_t v, sq = pl->bound * pl->bound;
+    size_t direct = pl->small_end <= b0 ? 0 : pl->small_end - b0 < len ? (size_t)(pl->small_end - b0) : len;
+    for (size_t i = 0; i < direct; i++) {
+        bool prime = smc_poly_eval(&pl->f, b0 + i, &v) && smc_is_prime64(v);
+        if (prime) bits[i >> 6] |= 1ULL << (i & 63);
+        else bits[i >> 6] &= ~(1ULL << (i & 63));
+    }
+    for (size_t w = direct / 64; w < words; w++) {
+        uint64_t m = bits[w];
+        if (w == direct / 64) m &= ~((1ULL << (direct & 63)) - 1);
+        for (; m; m &= m - 1) {
+            uint64_t i = 64 * (uint64_t)w + (uint64_t)smc_ctz64(m);
+            if (!smc_poly_eval(&pl->f, b0 + i, &v) || (v > sq && !smc_is_prime64(v)))
+                bits[w] &= ~(1ULL << (i & 63));
+        }
+    }
+    s->seg_lo = b0;
+    s->seg_bits = len;
+    s->pos = b0 + len;
+    s->seg++;
+    return true;
+}
+
+/* ===========================================================================
+ * RANGE HELPERS
+ * =========================================================================== */
+
+/* Receives each finished segment; runs concurrently on several threads */
+typedef void (*smc_poly_fn)(void *ctx, const smc_poly_sieve *s);
+
+typedef struct smc_poly_job {
+    const smc_poly_plan *pl;
+    uint64_t lo, hi, slice;
+    smc_poly_fn fn;
+    void *ctx;
+    volatile uint64_t failed;
+} smc_poly_job;
+
+SMC_API void smc_poly_range_task(void *arg, size_t index) {
+    smc_poly_job *job = (smc_poly_job *)arg;
+    uint64_t a = job->lo + (uint64_t)index * job->slice;
+    uint64_t b = job->hi - a < job->slice ? job->hi : a + job->slice;
+    smc_poly_sieve s;
+    if (!smc_poly_sieve_init(&s, job->pl, a, b)) {
+        smc_atomic_store64(&job->failed, 1);
+        return;
+    }
+    while (smc_poly_sieve_next(&s)) job->fn(job->ctx, &s);
+    smc_poly_sieve_free(&s);
+}
+
+/*
+ * Sieve n in [lo, hi) with a plan on up to 'threads' threads (0 = all),
+ * passing each segment to fn. Starting a slice costs a pass over every
+ * plan entry, so each thread takes one contiguous slice.
+ * Returns false on allocation failure.
+ */
+SMC_API bool smc_poly_range(const smc_poly_plan *pl, uint64_t lo, uint64_t hi, unsigned threads,
+                            smc_poly_fn fn, void *ctx) {
+    if (hi <= lo) return true;
+    if (threads == 0) threads = smc_thread_count();
+    uint64_t span = hi - lo;
+    uint64_t seg = (uint64_t)smc_sieve_segment_bytes(pl->n) * 8;
+    uint64_t slices = threads;
+    if (span / slices < seg) slices = span / seg + 1;
+    uint64_t slice = span / slices + (span % slices != 0);
+    slices = span / slice + (span % slice != 0);
+
+    smc_poly_job job;
+    job.pl = pl;
+    job.lo = lo;
+    job.hi = hi;
+    job.slice = slice;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.failed = 0;
+    smc_parallel_for((size_t)slices, threads, smc_poly_range_task, &job);
+    return job.failed == 0;
+}
+
+SMC_API void smc_poly_count_fn(void *ctx, const smc_poly_sieve *s) {
+    uint64_t c = 0;
+    for (size_t w = 0; w < (s->seg_bits + 63) / 64; w++) c += (uint64_t)smc_popcount64(s->bits[w]);
+    smc_atomic_fetch_add64((volatile uint64_t *)ctx, c);
+}
+
+/*
+ * Number of n in [lo, hi) with f(n) prime, sieving to
+ * smc_poly_default_bound on up to 'threads' threads (0 = all).
+ * UINT64_MAX on allocation failure.
+ */
+SMC_API uint64_t smc_poly_count(const smc_poly *f, uint64_t lo, uint64_t hi, unsigned threads) {
+    smc_poly_plan pl;
+    if (!smc_poly_plan_init(&pl, f, smc_poly_default_bound(f, lo, hi), threads)) return UINT64_MAX;
+    volatile uint64_t c = 0;
+    bool ok = smc_poly_range(&pl, lo, hi, threads, smc_poly_count_fn, (void *)&c);
+    smc_poly_plan_free(&pl);
+    return ok ? c : UINT64_MAX;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_POLY_H */
@@ -0,0 +1,576 @@
+/*
+ * smcPrime - Proth Numbers
+ *
+ * Searches for primes N = k * 2^n + 1 (odd k) over a grid of k and n:
+ * - Sieve: for each prime p up to a bound, 2^n = -1/k (mod p) is solved
+ *   for every k of the grid at once, by baby-step giant-step on the
+ *   discrete logarithm of 2 in Montgomery form; each solution clears (k, n)
+ * - The sieve runs over the primes in chunks on several threads, reports
+ *   candidates removed per second after each chunk, and saves and resumes
+ *   its state through a checkpoint file
+ * - Survivors get Proth's test: for k < 2^n, N is prime iff
+ *   a^((N-1)/2) = -1 (mod N) for a quadratic non-residue a. The squarings
+ *   use Karatsuba and a special-form reduction (2^n = -1/k mod N) that
+ *   costs one single-limb division per step
+ *
+ * POSIX builds must link with -pthread.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_PROTH_H
+#define SMCPRIME_PROTH_H
+
+#include "smcprime.h"
+#include "smcprime128.h"
+#include "smcprime_mp.h"
+#include "smcprime_sieve.h"
+#include "smcprime_cache.h"
+#include "smcprime_sys.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Cap on the baby steps (hash table entries) per sieving prime */
+#ifndef SMC_PROTH_MAX_BABY
+  #define SMC_PROTH_MAX_BABY (1u << 16)
+#endif
+
+/* k values sharing one modular inversion */
+#ifndef SMC_PROTH_K_BLOCK
+  #define SMC_PROTH_K_BLOCK 1024
+#endif
+
+/* Estimated modular multiplications per thread between progress reports */
+#ifndef SMC_PROTH_CHUNK_WORK
+  #define SMC_PROTH_CHUNK_WORK (1ULL << 28)
+#endif
+
+/* Sieving primes must stay below this */
+#define SMC_PROTH_P_LIMIT (1ULL << 62)
+
+#define SMC_PROTH_MAGIC 0x31485450434D53ULL   /* "SMCPTH1" */
+
+/* ===========================================================================
+ * PROTH TEST
+ * =========================================================================== */
+
+/*
+ * x (xn <= 2 * nl limbs, x < N^2, room for 2 * nl + 2) modulo
+ * N = k * 2^n + 1 (nl limbs, in nmod): with x = H * 2^n + L and
+ * H = q * k + r, x = r * 2^n + L - q (mod N), where both r * 2^n + L and q
+ * are below N. The result is left in x[0 .. nl). h takes xn limbs.
+ */
+SMC_API void smc_proth_reduce(uint64_t *x, size_t xn, uint64_t k, uint32_t n,
+                              const uint64_t *nmod, size_t nl, uint64_t *h) {
+    size_t w = n / 64;
+    unsigned b = n % 64;
+    size_t hn = xn - w;
+    if (b) smc_mpn_rshift(h, x + w, hn, b);
+    else memcpy(h, x + w, hn * sizeof(uint64_t));
+    hn = smc_mpn_normalize(h, hn);
+    uint64_t r = hn ? smc_mpn_divrem_1(h, h, hn, k) : 0;
+    hn = smc_mpn_normalize(h, hn);
+
+    /* L, then r placed at bit n */
+    memset(x + w + 1, 0, (2 * nl + 1 - w) * sizeof(uint64_t));
+    if (b) {
+        x[w] = (x[w] & ((1ULL << b) - 1)) | (r << b);
+        x[w + 1] = r >> (64 - b);
+    } else {
+        x[w] = r;
+    }
+    if (smc_mpn_sub(x, x, nl, h, hn)) smc_mpn_add_n(x, x, nmod, nl);
+}
+
+/*
+ * Proth's theorem for N = k * 2^n + 1: 1 if N is prime, 0 if composite,
+ * -1 if undecided. Even k is folded into n first. N below 2^64 goes to
+ * smc_is_prime64 and k >= 2^n to smc_is_prime128 (undecided without
+ * __int128). Otherwise a is the first small prime with (N / a) = -1, found
+ * by reciprocity from N mod a (undecided if none is, which includes square
+ * N, or on allocation failure), and N is prime iff a^(k 2^(n-1)) = -1.
+ */
+SMC_API int smc_proth_test(uint64_t k, uint32_t n) {
+    if (k == 0) return 0;
+    while (!(k & 1)) {
+        if (n == UINT32_MAX) return -1;
+        k >>= 1;
+        n++;
+    }
+    unsigned kbits = 64 - (unsigned)smc_clz64(k);
+    if ((uint64_t)n + kbits <= 63) return smc_is_prime64((k << n) + 1) ? 1 : 0;
+    if (n < 64 && (k >> n) != 0) {
+#if defined(__SIZEOF_INT128__)
+        return smc_is_prime128(((smc_u128)k << n) + 1) ? 1 : 0;
+#else
+        return -1;
+#endif
+    }
+
+    uint32_t a = 0;
+    for (int i = 0; i < SMC_NUM_PRIME_INV64; i++) {
+        uint32_t q = SMC_SMALL_PRIMES[i];
+        uint32_t t = (uint32_t)(((k % q) * smc_powmod32(2, n, q) + 1) % q);
+        if (t == 0) return 0;                   /* N > 2^64 > q */
+        if (smc_powmod32(t, (q - 1) / 2, q) == q - 1) { a = q; break; }
+    }
+    if (a == 0) return -1;
+
+    size_t nl = ((size_t)n + kbits + 63) / 64;
+    uint64_t *buf = (uint64_t *)calloc(6 * nl + 4 + smc_mpn_mul_scratch(nl), sizeof(uint64_t));
+    if (buf == NULL) return -1;
+    uint64_t *nmod = buf, *s = nmod + nl, *x = s + nl, *h = x + 2 * nl + 2, *kt = h + 2 * nl + 2;
+    nmod[n / 64] = k << (n % 64);
+    if (n % 64 && n / 64 + 1 < nl) nmod[n / 64 + 1] = k >> (64 - n % 64);
+    nmod[0] |= 1;
+
+    /* s = a^k, then n - 1 squarings */
+    s[0] = a;
+    for (int i = (int)kbits - 2; i >= 0; i--) {
+        smc_mpn_kara(x, s, s, nl, kt);
+        smc_proth_reduce(x, 2 * nl, k, n, nmod, nl, h);
+        if ((k >> i) & 1) {
+            x[nl] = smc_mpn_mul_1(x, x, nl, a);
+            smc_proth_reduce(x, nl + 1, k, n, nmod, nl, h);
+        }
+        memcpy(s, x, nl * sizeof(uint64_t));
+    }
+    for (uint32_t i = 1; i < n; i++) {
+        smc_mpn_kara(x, s, s, nl, kt);
+        smc_proth_reduce(x, 2 * nl, k, n, nmod, nl, h);
+        memcpy(s, x, nl * sizeof(uint64_t));
+    }
+    s[0]++;                                     /* s = N - 1 <=> s + 1 = N */
+    int prime = smc_mpn_cmp(s, nmod, nl) == 0;
+    free(buf);
+    return prime;
+}
+
+/* ===========================================================================
+ * GRID SIEVE
+ *
+ * Candidate (k, n) for odd k in [k_lo, k_hi) and n in [n_lo, n_hi) is bit
+ * n - n_lo of row (k - k_lo) / 2, set while the candidate survives. Every
+ * prime in [3, p_done) has been sieved out; 2 never divides N.
+ * =========================================================================== */
+
+typedef struct smc_proth_sieve {
+    uint64_t k_lo, k_hi;        /* k_lo odd */
+    uint32_t n_lo, n_hi;
+    uint64_t nk;                /* odd k in the grid */
+    uint64_t p_done;
+    uint64_t remaining;         /* candidates still set */
+    size_t row_words;
+    uint64_t *bits;
+} smc_proth_sieve;
+
+SMC_API void smc_proth_sieve_free(smc_proth_sieve *s) {
+    free(s->bits);
+    memset(s, 0, sizeof(*s));
+}
+
+/*
+ * Grid of odd k in [k_lo, k_hi) by n in [n_lo, n_hi), n_lo >= 1, with every
+ * candidate set. Returns false on an empty grid or allocation failure.
+ */
+SMC_API bool smc_proth_sieve_init(smc_proth_sieve *s, uint64_t k_lo, uint64_t k_hi,
+                                  uint32_t n_lo, uint32_t n_hi) {
+    memset(s, 0, sizeof(*s));
+    k_lo |= 1;
+    if (k_hi <= k_lo || n_hi <= n_lo || n_lo == 0) return false;
+    s->k_lo = k_lo;
+    s->k_hi = k_hi;
+    s->n_lo = n_lo;
+    s->n_hi = n_hi;
+    s->nk = (k_hi - k_lo + 1) / 2;
+    s->p_done = 3;
+    uint32_t span = n_hi - n_lo;
+    s->row_words = ((size_t)span + 63) / 64;
+    if (s->nk > SIZE_MAX / 8 / s->row_words) return false;
+    s->bits = (uint64_t *)malloc((size_t)s->nk * s->row_words * sizeof(uint64_t));
+    if (s->bits == NULL) return false;
+    uint64_t tail = span % 64 ? (1ULL << (span % 64)) - 1 : ~0ULL;
+    for (uint64_t i = 0; i < s->nk; i++) {
+        uint64_t *row = s->bits + i * s->row_words;
+        memset(row, 0xFF, s->row_words * sizeof(uint64_t));
+        row[s->row_words - 1] = tail;
+    }
+    s->remaining = s->nk * span;
+    return true;
+}
+
+/* Whether k * 2^n + 1 is still a candidate (k odd and inside the grid) */
+SMC_INLINE bool smc_proth_sieve_has(const smc_proth_sieve *s, uint64_t k, uint32_t n) {
+    uint64_t i = (k - s->k_lo) / 2, j = n - s->n_lo;
+    return (s->bits[i * s->row_words + j / 64] >> (j % 64)) & 1;
+}
+
+/* Per-thread tables for smc_proth_sieve_prime */
+typedef struct smc_proth_scratch {
+    uint64_t *key;              /* 2^j R mod p, UINT64_MAX = empty */
+    uint32_t *val;              /* j */
+    unsigned shift;             /* 64 - log2(table size) */
+    uint32_t m;                 /* baby steps */
+    uint64_t *kr, *pre;         /* one block of k R mod p and prefix products */
+} smc_proth_scratch;
+
+SMC_API void smc_proth_scratch_free(smc_proth_scratch *w) {
+    free(w->key);
+    free(w->val);
+    free(w->kr);
+    free(w->pre);
+    memset(w, 0, sizeof(*w));
+}
+
+/*
+ * Baby steps balancing the m table inserts against the nk * span / m giant
+ * steps, capped by SMC_PROTH_MAX_BABY and the span.
+ */
+SMC_API uint32_t smc_proth_baby_steps(const smc_proth_sieve *s) {
+    uint64_t span = s->n_hi - s->n_lo;
+    uint64_t prod = s->nk > UINT64_MAX / span ? UINT64_MAX : s->nk * span;
+    uint64_t m = smc_isqrt64(prod);
+    if (m > SMC_PROTH_MAX_BABY) m = SMC_PROTH_MAX_BABY;
+    if (m > span) m = span;
+    return m ? (uint32_t)m : 1;
+}
+
+SMC_API bool smc_proth_scratch_init(smc_proth_scratch *w, const smc_proth_sieve *s) {
+    memset(w, 0, sizeof(*w));
+    w->m = smc_proth_baby_steps(s);
+    unsigned bits = 1;
+    while ((1ULL << bits) < 2ULL * w->m) bits++;
+    w->shift = 64 - bits;
+    w->key = (uint64_t *)malloc(((size_t)1 << bits) * sizeof(uint64_t));
+    w->val = (uint32_t *)malloc(((size_t)1 << bits) * sizeof(uint32_t));
+    w->kr = (uint64_t *)malloc(SMC_PROTH_K_BLOCK * sizeof(uint64_t));
+    w->pre = (uint64_t *)malloc(SMC_PROTH_K_BLOCK * sizeof(uint64_t));
+    if (!w->key || !w->val || !w->kr || !w->pre) {
+        smc_proth_scratch_free(w);
+        return false;
+    }
+    return true;
+}
+
+SMC_INLINE uint32_t smc_proth_lookup(const smc_proth_scratch *w, uint64_t x) {
+    size_t mask = ((size_t)1 << (64 - w->shift)) - 1;
+    for (size_t h = (size_t)((x * 0x9E3779B97F4A7C15ULL) >> w->shift);; h = (h + 1) & mask) {
+        if (w->key[h] == x) return w->val[h];
+        if (w->key[h] == UINT64_MAX) return UINT32_MAX;
+    }
+}
+
+/* Clear (k, n) unless N = p itself; returns 1 if it was still set */
+SMC_INLINE uint64_t smc_proth_clear(smc_proth_sieve *s, uint64_t i, uint32_t j, uint64_t p) {
+    uint64_t n = (uint64_t)s->n_lo + j;
+    if (n < 64 && ((p - 1) & ((1ULL << n) - 1)) == 0 && ((p - 1) >> n) == s->k_lo + 2 * i) return 0;
+    uint64_t bit = 1ULL << (j % 64);
+    uint64_t old = smc_atomic_fetch_and64(s->bits + i * s->row_words + j / 64, ~bit);
+    return (old & bit) != 0;
+}
+
+/*
+ * Sieve one odd prime 3 <= p < SMC_PROTH_P_LIMIT; returns the candidates
+ * removed. Safe to run concurrently for different p.
+ *
+ * The baby steps store 2^j for j < m (fewer once 2^j returns to 1, which
+ * gives the order of 2 directly); k * 2^n = -1 becomes
+ * 2^j = t * 2^(-i m) with t = -2^(-n_lo) / k and n = n_lo + i m + j. The
+ * inverses of a block of k take one extended Euclid and three
+ * multiplications each (Montgomery's trick), and t's factor rides along.
+ */
+SMC_API uint64_t smc_proth_sieve_prime(smc_proth_sieve *s, uint64_t p, smc_proth_scratch *w) {
+    uint64_t ni = smc_mont_inv64(p), one = smc_mont_one64(p);
+    uint64_t span = s->n_hi - s->n_lo, removed = 0;
+    uint32_t m = w->m, ord = 0;
+    size_t mask = ((size_t)1 << (64 - w->shift)) - 1;
+
+    memset(w->key, 0xFF, (mask + 1) * sizeof(uint64_t));
+    uint64_t x = one;
+    for (uint32_t j = 0; j < m; j++) {
+        if (j && x == one) { ord = j; break; }
+        size_t h = (size_t)((x * 0x9E3779B97F4A7C15ULL) >> w->shift);
+        while (w->key[h] != UINT64_MAX) h = (h + 1) & mask;
+        w->key[h] = x;
+        w->val[h] = j;
+        x = x >= p - x ? x - (p - x) : x + x;
+    }
+    uint64_t half = smc_mont_small64((p + 1) / 2, p, one);
+    uint64_t giant = smc_mont_pow64(half, m, p, ni, one);
+    uint64_t c = smc_mont_pow64(half, s->n_lo, p, ni, one);
+    c = c ? p - c : 0;
+    uint64_t two = one >= p - one ? one - (p - one) : one + one;
+
+    uint64_t kr = smc_to_mont64(s->k_lo % p, p);
+    for (uint64_t i0 = 0; i0 < s->nk; i0 += SMC_PROTH_K_BLOCK) {
+        size_t len = s->nk - i0 < SMC_PROTH_K_BLOCK ? (size_t)(s->nk - i0) : SMC_PROTH_K_BLOCK;
+        uint64_t acc = one;
+        for (size_t i = 0; i < len; i++) {
+            w->kr[i] = kr;
+            if (kr) acc = smc_mont_mul64(acc, kr, p, ni);
+            w->pre[i] = acc;
+            kr = kr >= p - two ? kr - (p - two) : kr + two;
+        }
+        /* inv = c / prod(k), in Montgomery form */
+        uint64_t inv = smc_to_mont64(smc_modinv64(smc_mont_mul64(acc, 1, p, ni), p), p);
+        inv = smc_mont_mul64(inv, c, p, ni);
+        for (size_t i = len; i-- > 0;) {
+            if (w->kr[i] == 0) continue;        /* p | k: N = 1 mod p */
+            uint64_t t = i ? smc_mont_mul64(inv, w->pre[i - 1], p, ni) : inv;
+            inv = smc_mont_mul64(inv, w->kr[i], p, ni);
+            uint64_t row = i0 + i;
+            if (ord) {
+                uint32_t j = smc_proth_lookup(w, t);
+                if (j == UINT32_MAX) continue;
+                for (uint64_t e = j; e < span; e += ord) removed += smc_proth_clear(s, row, (uint32_t)e, p);
+            } else {
+                for (uint64_t e = 0; e < span; e += m) {
+                    uint32_t j = smc_proth_lookup(w, t);
+                    if (j != UINT32_MAX && e + j < span) removed += smc_proth_clear(s, row, (uint32_t)(e + j), p);
+                    t = smc_mont_mul64(t, giant, p, ni);
+                }
+            }
+        }
+    }
+    return removed;
+}
+
+/* Progress after each chunk of sieving primes */
+typedef struct smc_proth_progress {
+    uint64_t p_done;            /* every prime below has been sieved */
+    uint64_t primes;            /* sieving primes used by this run */
+    uint64_t removed;           /* candidates removed by this run */
+    uint64_t remaining;
+    double seconds;             /* since the run started */
+    double rate;                /* candidates removed per second, last chunk */
+} smc_proth_progress;
+
+/* Called between chunks, when s is consistent (e.g. to save a checkpoint); false stops the run */
+typedef bool (*smc_proth_progress_fn)(void *ctx, const smc_proth_sieve *s, const smc_proth_progress *pr);
+
+typedef struct smc_proth_job {
+    smc_proth_sieve *s;
+    uint64_t lo, hi, slice;
+    volatile uint64_t removed, primes, failed;
+} smc_proth_job;
+
+SMC_API void smc_proth_sieve_task(void *arg, size_t index) {
+    smc_proth_job *job = (smc_proth_job *)arg;
+    uint64_t a = job->lo + (uint64_t)index * job->slice;
+    uint64_t b = job->hi - a < job->slice ? job->hi : a + job->slice;
+    smc_proth_scratch w;
+    smc_sieve it;
+    if (!smc_proth_scratch_init(&w, job->s)) {
+        smc_atomic_store64(&job->failed, 1);
+        return;
+    }
+    if (!smc_sieve_init(&it, a, b)) {
+        smc_proth_scratch_free(&w);
+        smc_atomic_store64(&job->failed, 1);
+        return;
+    }
+    uint64_t removed = 0, primes = 0;
+    while (smc_sieve_next(&it)) {
+        for (size_t i = 0; i < (it.seg_bits + 63) / 64; i++) {
+            for (uint64_t bits = it.bits[i]; bits; bits &= bits - 1) {
+                uint64_t p = it.seg_lo + 2 * (64 * (uint64_t)i + (uint64_t)smc_ctz64(bits));
+                if (p < 3) continue;
+                removed += smc_proth_sieve_prime(job->s, p, &w);
+                primes++;
+            }
+        }
+    }
+    smc_sieve_free(&it);
+    smc_proth_scratch_free(&w);
+    smc_atomic_fetch_add64(&job->removed, removed);
+    smc_atomic_fetch_add64(&job->primes, primes);
+}
+
+/*
+ * Sieve the grid with every prime in [p_done, p_hi) (p_hi at most
+ * SMC_PROTH_P_LIMIT) on up to 'threads' threads (0 = all). The primes go in
+ * chunks sized from SMC_PROTH_CHUNK_WORK, each split between the threads;
+ * after each chunk p_done and remaining are updated and fn (may be NULL)
+ * gets the progress. Returns false on allocation failure, with the failed
+ * chunk left for the next run.
+ */
+SMC_API bool smc_proth_sieve_run(smc_proth_sieve *s, uint64_t p_hi, unsigned threads,
+                                 smc_proth_progress_fn fn, void *ctx) {
+    if (p_hi > SMC_PROTH_P_LIMIT) p_hi = SMC_PROTH_P_LIMIT;
+    if (threads == 0) threads = smc_thread_count();
+    uint64_t span = s->n_hi - s->n_lo;
+    uint32_t m = smc_proth_baby_steps(s);
+    /* per prime: m inserts, 4 multiplications and span / m giant steps per k */
+    double cost = (double)m + (double)s->nk * (4.0 + (double)((span + m - 1) / m));
+    double per_chunk = (double)SMC_PROTH_CHUNK_WORK * threads / cost;
+    if (per_chunk < threads) per_chunk = threads;
+
+    smc_proth_progress pr;
+    memset(&pr, 0, sizeof(pr));
+    double start = smc_seconds(), last = start;
+    while (s->p_done < p_hi) {
+        /* primes near p are ln(p) ~ 0.69 log2(p) apart */
+        uint64_t lo = s->p_done;
+        double gap = 0.69 * (64 - smc_clz64(lo));
+        double width = per_chunk * gap;
+        uint64_t hi = width >= (double)(p_hi - lo) ? p_hi : lo + (uint64_t)width + 1;
+
+        smc_proth_job job;
+        job.s = s;
+        job.lo = lo;
+        job.hi = hi;
+        uint64_t slices = threads;
+        job.slice = (hi - lo) / slices + ((hi - lo) % slices != 0);
+        slices = (hi - lo) / job.slice + ((hi - lo) % job.slice != 0);
+        job.removed = 0;
+        job.primes = 0;
+        job.failed = 0;
+        smc_parallel_for((size_t)slices, threads, smc_proth_sieve_task, &job);
+        if (job.failed) {
+            /* the chunk's other slices may have cleared bits: recount */
+            uint64_t left = 0;
+            for (size_t i = 0; i < (size_t)s->nk * s->row_words; i++) left += (uint64_t)smc_popcount64(s->bits[i]);
+            s->remaining = left;
+            return false;
+        }
+        s->p_done = hi;
+        s->remaining -= job.removed;
+
+        double now = smc_seconds();
+        pr.p_done = hi;
+        pr.primes += job.primes;
+        pr.removed += job.removed;
+        pr.remaining = s->remaining;
+        pr.seconds = now - start;
+        pr.rate = now > last ? (double)job.removed / (now - last) : 0;
+        last = now;
+        if (fn && !fn(ctx, s, &pr)) break;
+    }
+    return true;
+}
+
+/* ===========================================================================
+ * CHECKPOINTS
+ * =========================================================================== */
+
+typedef struct smc_proth_header {
+    uint64_t magic;
+    uint64_t k_lo, k_hi;
+    uint64_t n_lo, n_hi;
+    uint64_t p_done;
+    uint64_t remaining;
+    uint64_t checksum;          /* smc_prime_cache_hash of the bitmap */
+} smc_proth_header;
+
+SMC_INLINE uint64_t smc_proth_sum(const smc_proth_header *h, const uint64_t *bits, size_t len) {
+    uint64_t seed = h->k_lo ^ (h->k_hi << 7) ^ (h->n_lo << 32) ^ (h->n_hi << 48) ^ h->p_done ^ (h->remaining << 3);
+    return smc_prime_cache_hash(seed, bits, len);
+}
+
+/*
+ * Write the sieve state to path.<pid>.tmp and rename it over path, so an
+ * interrupted save leaves the previous checkpoint. Returns false on I/O failure.
+ */
+SMC_API bool smc_proth_sieve_save(const smc_proth_sieve *s, const char *path) {
+    size_t len = (size_t)s->nk * s->row_words * sizeof(uint64_t);
+    smc_proth_header h;
+    memset(&h, 0, sizeof(h));
+    h.magic = SMC_PROTH_MAGIC;
+    h.k_lo = s->k_lo;
+    h.k_hi = s->k_hi;
+    h.n_lo = s->n_lo;
+    h.n_hi = s->n_hi;
+    h.p_done = s->p_done;
+    h.remaining = s->remaining;
+    h.checksum = smc_proth_sum(&h, s->bits, len);
+
+    size_t plen = strlen(path);
+    char *tmp = (char *)malloc(plen + 32);
+    if (tmp == NULL) return false;
+    snprintf(tmp, plen + 32, "%s.%lu.tmp", path, smc_process_id());
+    FILE *f = fopen(tmp, "wb");
+    bool ok = f != NULL;
+    if (ok) {
+        ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(s->bits, 1, len, f) == len;
+        ok = fclose(f) == 0 && ok;
+        ok = ok && smc_replace_file(tmp, path);
+        if (!ok) remove(tmp);
+    }
+    free(tmp);
+    return ok;
+}
+
+/* Resume from a checkpoint. Returns false if missing, invalid or out of memory. */
+SMC_API bool smc_proth_sieve_load(smc_proth_sieve *s, const char *path) {
+    memset(s, 0, sizeof(*s));
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return false;
+    smc_proth_header h;
+    bool ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == SMC_PROTH_MAGIC
+        && h.n_lo <= UINT32_MAX && h.n_hi <= UINT32_MAX && (h.k_lo & 1)
+        && smc_proth_sieve_init(s, h.k_lo, h.k_hi, (uint32_t)h.n_lo, (uint32_t)h.n_hi);
+    if (ok) {
+        size_t len = (size_t)s->nk * s->row_words * sizeof(uint64_t);
+        ok = fread(s->bits, 1, len, f) == len && fgetc(f) == EOF
+            && h.checksum == smc_proth_sum(&h, s->bits, len);
+        s->p_done = h.p_done;
+        s->remaining = h.remaining;
+    }
+    fclose(f);
+    if (!ok) smc_proth_sieve_free(s);
+    return ok;
+}
+
+/* ===========================================================================
+ * TESTING THE SURVIVORS
+ * =========================================================================== */
+
+/* Receives every tested candidate with its smc_proth_test result; runs concurrently */
+typedef void (*smc_proth_fn)(void *ctx, uint64_t k, uint32_t n, int result);
+
+typedef struct smc_proth_test_job {
+    const smc_proth_sieve *s;
+    smc_proth_fn fn;
+    void *ctx;
+    volatile uint64_t primes;
+} smc_proth_test_job;
+
+SMC_API void smc_proth_test_task(void *arg, size_t index) {
+    smc_proth_test_job *job = (smc_proth_test_job *)arg;
+    const smc_proth_sieve *s = job->s;
+    uint64_t row = index / s->row_words, word = index % s->row_words;
+    uint64_t k = s->k_lo + 2 * row;
+    for (uint64_t bits = s->bits[index]; bits; bits &= bits - 1) {
+        uint32_t n = s->n_lo + (uint32_t)(64 * word + (uint64_t)smc_ctz64(bits));
+        int r = smc_proth_test(k, n);
+        if (r > 0) smc_atomic_fetch_add64(&job->primes, 1);
+        if (job->fn) job->fn(job->ctx, k, n, r);
+    }
+}
+
+/*
+ * Run smc_proth_test on every surviving candidate on up to 'threads'
+ * threads (0 = all), one 64-bit word of a row per task; returns the
+ * number of primes. fn may be NULL.
+ */
+SMC_API uint64_t smc_proth_search(const smc_proth_sieve *s, unsigned threads, smc_proth_fn fn, void *ctx) {
+    smc_proth_test_job job;
+    job.s = s;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.primes = 0;
+    smc_parallel_for((size_t)s->nk * s->row_words, threads, smc_proth_test_task, &job);
+    return job.primes;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_PROTH_H */
@@ -0,0 +1,493 @@
+/*
+ * smcPrime - Segmented Sieve of Eratosthenes
+ *
+ * Range sieving for 64-bit integers:
+ * - Odd-only bitmaps (one bit per odd number, 1 = prime)
+ * - Cache-sized segments with persistent next-multiple offsets,
+ *   so each sieving prime costs one division per range, not per segment;
+ *   segment sizes follow the detected cache topology (smcprime_sys.h)
+ * - Counting and enumeration helpers built on the segment iterator
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_SIEVE_H
+#define SMCPRIME_SIEVE_H
+
+#include "smcprime.h"
+#include "smcprime_pi.h"
+#include "smcprime_sys.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bitmap segment size in bytes for a sieve with nprimes sieving primes;
+ * one byte covers 16 integers. Small prime sets sieve fastest in L1, but
+ * each segment costs every prime one offset update, so once the primes
+ * outnumber the bytes the segment grows towards L2. Defining
+ * SMC_SIEVE_SEGMENT_BYTES fixes the size instead.
+ */
+SMC_INLINE size_t smc_sieve_segment_bytes(size_t nprimes) {
+#ifdef SMC_SIEVE_SEGMENT_BYTES
+    (void)nprimes;
+    return (size_t)SMC_SIEVE_SEGMENT_BYTES;
+#else
+    const smc_cache_info *c = smc_cache_sizes();
+    size_t bytes = nprimes < c->l1d ? c->l1d : nprimes > c->l2 ? c->l2 : nprimes;
+    return bytes < 64 ? 64 : bytes & ~(size_t)7;
+#endif
+}
+
+/*
+ * Trim an array allocated from an upper bound (cap elements) to the n
+ * actually used. Bounds from 0 are within a fraction of a percent, so only
+ * a slack above 1/8 is worth a realloc, which may copy. Keeps the original
+ * block if the shrink fails.
+ */
+SMC_INLINE void *smc_shrink_alloc(void *p, size_t n, size_t cap, size_t size) {
+    if (n >= cap - cap / 8) return p;
+    void *t = realloc(p, (n ? n : 1) * size);
+    return t ? t : p;
+}
+
+/* ===========================================================================
+ * SIEVING PRIMES
+ * =========================================================================== */
+
+/*
+ * All primes <= limit (including 2), ascending.
+ *
+ * Returns a malloc'd array and stores its length in *count, or NULL on
+ * allocation failure. Sieves in segments, so memory is the output plus
+ * one segment; the output is sized once from smc_pi_upper.
+ */
+SMC_API uint32_t *smc_sieve_primes32(uint32_t limit, size_t *count) {
+    *count = 0;
+    size_t cap = (size_t)smc_pi_upper(limit) + 1, n = 0;
+    uint32_t *out = (uint32_t *)malloc(cap * sizeof(uint32_t));
+    if (out == NULL) return NULL;
+    if (limit < 2) return out;
+    out[n++] = 2;
+
+    /* Base primes up to sqrt(limit) with a plain odd-only sieve */
+    uint32_t root = smc_isqrt64(limit);
+    size_t base_len = root / 2 + 1;
+    uint8_t *base = (uint8_t *)calloc(base_len, 1);   /* 1 = composite */
+    uint32_t *bp = (uint32_t *)malloc((base_len + 1) * sizeof(uint32_t));
+    uint64_t *next = (uint64_t *)malloc((base_len + 1) * sizeof(uint64_t));
+    /* Byte-per-odd segment: the base primes are few, so it fits L2 */
+    const smc_cache_info *cache = smc_cache_sizes();
+#ifdef SMC_SIEVE_SEGMENT_BYTES
+    const uint64_t seg_len = (uint64_t)SMC_SIEVE_SEGMENT_BYTES * 8;
+#else
+    const uint64_t seg_len = cache->l2 / 8 > cache->l1d ? cache->l2 / 8 : cache->l1d;
+#endif
+    (void)cache;
+    uint8_t *seg = (uint8_t *)malloc((size_t)seg_len);
+    if (!base || !bp || !next || !seg) {
+        free(base); free(bp); free(next); free(seg); free(out);
+        return NULL;
+    }
+    size_t nbp = 0;
+    for (uint32_t i = 1; i < base_len; i++) {
+        if (base[i]) continue;
+        uint32_t p = 2 * i + 1;
+        bp[nbp] = p;
+        next[nbp++] = (uint64_t)p * p / 2;
+        for (uint64_t j = (uint64_t)p * p / 2; j < base_len; j += p) base[j] = 1;
+    }
+    free(base);
+
+    /* Segmented pass over odd indices; index i <-> 2i + 1 */
+    uint64_t end = ((uint64_t)limit + 1) / 2;
+    for (uint64_t lo = 1; lo < end; lo += seg_len) {
+        uint64_t len = end - lo < seg_len ? end - lo : seg_len;
+        memset(seg, 0, (size_t)len);
+        for (size_t k = 0; k < nbp; k++) {
+            uint64_t j = next[k];
+            if (j >= lo + len) continue;
+            for (j -= lo; j < len; j += bp[k]) seg[j] = 1;
+            next[k] = j + lo;
+        }
+        for (uint64_t j = 0; j < len; j++) {
+            if (seg[j]) continue;
+            if (n == cap) {
+                uint32_t *t = (uint32_t *)realloc(out, 2 * cap * sizeof(uint32_t));
+                if (t == NULL) { free(bp); free(next); free(seg); free(out); return NULL; }
+                out = t;
+                cap *= 2;
+            }
+            out[n++] = (uint32_t)(2 * (lo + j) + 1);
+        }
+    }
+    free(bp); free(next); free(seg);
+    *count = n;
+    return (uint32_t *)smc_shrink_alloc(out, n, cap, sizeof(uint32_t));
+}
+
+/* ===========================================================================
+ * SEGMENT ITERATOR
+ *
+ * Sieves [lo, hi) one segment at a time. After each successful
+ * smc_sieve_next call, bit i of 'bits' is set iff seg_lo + 2*i is prime,
+ * for i < seg_bits. seg_lo is always odd; the even prime 2 is not in the
+ * bitmap, callers add it when lo <= 2 < hi.
+ * =========================================================================== */
+
+typedef struct smc_sieve {
+    uint64_t lo, hi;        /* requested range [lo, hi) */
+    uint64_t base;          /* first odd value >= lo */
+    uint64_t total_bits;    /* odd values in [base, hi) */
+    uint64_t done_bits;     /* odd values already sieved */
+    uint64_t seg_lo;        /* value of bit 0 in the current segment */
+    size_t seg_bits;        /* valid bits in the current segment */
+    size_t seg_cap;         /* segment capacity in bits (multiple of 64) */
+    uint64_t *bits;
+    uint32_t *primes;       /* odd sieving primes <= isqrt(hi - 1) */
+    size_t nprimes;
+    uint64_t *next;         /* per prime: absolute bit index of next multiple */
+    bool borrowed;          /* primes belong to the caller (smc_sieve_init_borrow) */
+} smc_sieve;
+
+SMC_API void smc_sieve_free(smc_sieve *s) {
+    free(s->bits);
+    if (!s->borrowed) free(s->primes);
+    free(s->next);
+    memset(s, 0, sizeof(*s));
+}
+
+/*
+ * Position the iterator so the next smc_sieve_next starts at odd-bit
+ * index 'bit' (value base + 2*bit). Costs one division per sieving prime;
+ * sequential iteration never needs it.
+ */
+SMC_API void smc_sieve_seek(smc_sieve *s, uint64_t bit) {
+    if (bit > s->total_bits) bit = s->total_bits;
+    s->done_bits = bit;
+    uint64_t start = s->base + 2 * bit;
+    for (size_t k = 0; k < s->nprimes; k++) {
+        uint64_t p = s->primes[k];
+        uint64_t sq = p * p;
+        uint64_t off;
+        if (sq >= start) {
+            off = sq - start;
+        } else {
+            uint64_t r = start % p;
+            off = r ? p - r : 0;
+            if (off & 1) off += p;   /* start is odd: keep the multiple odd */
+        }
+        s->next[k] = bit + off / 2;
+    }
+}
+
+/* Shared setup of smc_sieve_init_with / smc_sieve_init_borrow */
+SMC_API bool smc_sieve_setup(smc_sieve *s, uint64_t lo, uint64_t hi, uint32_t *primes,
+                             size_t nprimes, bool borrowed) {
+    memset(s, 0, sizeof(*s));
+    s->lo = lo;
+    s->hi = hi;
+    s->base = lo | 1;
+    if (hi > s->base) s->total_bits = (hi - s->base + 1) / 2;
+    s->primes = primes;
+    s->nprimes = nprimes;
+    s->borrowed = borrowed;
+    s->seg_cap = smc_sieve_segment_bytes(nprimes) * 8;
+    if (s->seg_cap > s->total_bits) s->seg_cap = (size_t)((s->total_bits + 63) & ~(uint64_t)63);
+    if (s->seg_cap == 0) s->seg_cap = 64;
+    s->bits = (uint64_t *)malloc(s->seg_cap / 8);
+    s->next = (uint64_t *)malloc((nprimes + 1) * sizeof(uint64_t));
+    if (s->bits == NULL || s->next == NULL) { smc_sieve_free(s); return false; }
+    smc_sieve_seek(s, 0);
+    return true;
+}
+
+/*
+ * Prepare to sieve [lo, hi) with caller-supplied sieving primes: a
+ * malloc'd ascending array of the odd primes <= isqrt(hi - 1), which the
+ * sieve owns from here on (it is freed even on failure). Returns false on
+ * allocation failure.
+ */
+SMC_API bool smc_sieve_init_with(smc_sieve *s, uint64_t lo, uint64_t hi,
+                                 uint32_t *primes, size_t nprimes) {
+    return smc_sieve_setup(s, lo, hi, primes, nprimes, false);
+}
+
+/*
+ * Prepare to sieve [lo, hi) with sieving primes the caller keeps: an
+ * ascending array of odd primes reaching at least isqrt(hi - 1), of which
+ * only those up to it are used. The array is neither copied nor freed and
+ * must outlive the sieve, so sieves over slices of one range can share a
+ * single list. Returns false on allocation failure.
+ */
+SMC_API bool smc_sieve_init_borrow(smc_sieve *s, uint64_t lo, uint64_t hi,
+                                   const uint32_t *primes, size_t nprimes) {
+    size_t n = 0;
+    if (hi > (lo | 1)) {
+        uint64_t root = smc_isqrt64(hi - 1);
+        for (size_t top = nprimes; n < top;) {
+            size_t mid = n + (top - n) / 2;
+            if (primes[mid] <= root) n = mid + 1;
+            else top = mid;
+        }
+    }
+    return smc_sieve_setup(s, lo, hi, (uint32_t *)primes, n, true);
+}
+
+/* Prepare to sieve [lo, hi). Returns false on allocation failure. */
+SMC_API bool smc_sieve_init(smc_sieve *s, uint64_t lo, uint64_t hi) {
+    size_t np = 0;
+    uint32_t *all = NULL;
+    if (hi > (lo | 1)) {
+        all = smc_sieve_primes32(smc_isqrt64(hi - 1), &np);
+        if (all == NULL) { memset(s, 0, sizeof(*s)); return false; }
+        /* Drop the leading 2; keep the array as the odd prime list */
+        if (np > 0) memmove(all, all + 1, --np * sizeof(uint32_t));
+    }
+    return smc_sieve_init_with(s, lo, hi, all, np);
+}
+
+/* Sieve the next segment. Returns false once the range is exhausted. */
+SMC_API bool smc_sieve_next(smc_sieve *s) {
+    if (s->done_bits >= s->total_bits) return false;
+    uint64_t b0 = s->done_bits;
+    uint64_t left = s->total_bits - b0;
+    size_t len = left < s->seg_cap ? (size_t)left : s->seg_cap;
+    size_t words = (len + 63) / 64;
+    uint64_t *bits = s->bits;
+
+    memset(bits, 0xFF, words * 8);
+    if (len & 63) bits[words - 1] = (1ULL << (len & 63)) - 1;
+
+    uint64_t b1 = b0 + len;
+    for (size_t k = 0; k < s->nprimes; k++) {
+        uint64_t j = s->next[k];
+        if (j >= b1) continue;
+        uint64_t p = s->primes[k];
+        for (j -= b0; j < len; j += p) bits[j >> 6] &= ~(1ULL << (j & 63));
+        s->next[k] = j + b0;
+    }
+
+    s->seg_lo = s->base + 2 * b0;
+    if (s->seg_lo == 1) bits[0] &= ~1ULL;   /* 1 is not prime */
+    s->seg_bits = len;
+    s->done_bits = b1;
+    return true;
+}
+
+/* Number of primes in the current segment */
+SMC_API uint64_t smc_sieve_segment_count(const smc_sieve *s) {
+    uint64_t c = 0;
+    size_t words = (s->seg_bits + 63) / 64;
+    for (size_t w = 0; w < words; w++) c += (uint64_t)smc_popcount64(s->bits[w]);
+    return c;
+}
+
+/* ===========================================================================
+ * RANGE HELPERS
+ * =========================================================================== */
+
+/* Number of primes in [lo, hi); returns UINT64_MAX on allocation failure */
+SMC_API uint64_t smc_count_primes(uint64_t lo, uint64_t hi) {
+    if (hi <= lo) return 0;
+    smc_sieve s;
+    if (!smc_sieve_init(&s, lo, hi)) return UINT64_MAX;
+    uint64_t c = (lo <= 2 && hi > 2) ? 1 : 0;
+    while (smc_sieve_next(&s)) c += smc_sieve_segment_count(&s);
+    smc_sieve_free(&s);
+    return c;
+}
+
+/*
+ * All primes in [lo, hi), ascending.
+ *
+ * Returns a malloc'd array and stores its length in *count, or NULL on
+ * allocation failure. The array is allocated once from
+ * smc_pi_range_upper and trimmed to size at the end.
+ */
+SMC_API uint64_t *smc_primes_range(uint64_t lo, uint64_t hi, size_t *count) {
+    *count = 0;
+    size_t cap = (size_t)smc_pi_range_upper(lo, hi) + 1, n = 0;
+    uint64_t *out = (uint64_t *)malloc(cap * sizeof(uint64_t));
+    if (out == NULL) return NULL;
+    if (hi <= lo) return out;
+    smc_sieve s;
+    if (!smc_sieve_init(&s, lo, hi)) { free(out); return NULL; }
+    if (lo <= 2 && hi > 2) out[n++] = 2;
+    while (smc_sieve_next(&s)) {
+        size_t words = (s.seg_bits + 63) / 64;
+        for (size_t w = 0; w < words; w++) {
+            for (uint64_t m = s.bits[w]; m; m &= m - 1) {
+                if (n == cap) {
+                    uint64_t *t = (uint64_t *)realloc(out, 2 * cap * sizeof(uint64_t));
+                    if (t == NULL) { smc_sieve_free(&s); free(out); return NULL; }
+                    out = t;
+                    cap *= 2;
+                }
+                out[n++] = s.seg_lo + 2 * (64 * (uint64_t)w + (uint64_t)smc_ctz64(m));
+            }
+        }
+    }
+    smc_sieve_free(&s);
+    *count = n;
+    return (uint64_t *)smc_shrink_alloc(out, n, cap, sizeof(uint64_t));
+}
+
+/* ===========================================================================
+ * PRIME WINDOW CACHE
+ *
+ * Answers next/prev prime queries from a sieved window of SMC_PRIME_WINDOW
+ * integers around recent queries, for streams that stay in one
+ * neighbourhood (slowly increasing arguments, random walks). The window is
+ * sieved by the odd primes up to SMC_PRIME_WINDOW_BOUND; survivors are
+ * confirmed with smc_is_prime64 on first use and remembered, so each
+ * number is tested at most once per window. A query outside the window
+ * refills it (one division per sieving prime) if it lands near the
+ * previous query; isolated jumps are answered directly, so random access
+ * costs about what smc_next_prime64 does. Below SMC_PRIME_WINDOW_BOUND^2
+ * the window is exact and needs no tests.
+ * =========================================================================== */
+
+#ifndef SMC_PRIME_WINDOW
+  #define SMC_PRIME_WINDOW (1u << 16)
+#endif
+#ifndef SMC_PRIME_WINDOW_BOUND
+  #define SMC_PRIME_WINDOW_BOUND (1u << 12)
+#endif
+#if SMC_PRIME_WINDOW % 128 != 0 || SMC_PRIME_WINDOW_BOUND > 65535
+  #error "smcPrime: SMC_PRIME_WINDOW must be a multiple of 128, SMC_PRIME_WINDOW_BOUND below 2^16"
+#endif
+
+/* Fixed-size, so a thread-local instance needs no allocation or cleanup;
+   zero-initialize before first use */
+typedef struct smc_prime_window {
+    uint64_t lo, hi;        /* odd values in [lo, hi); hi == 0 until filled */
+    uint64_t last;          /* previous query outside the window */
+    bool exact;             /* every candidate is prime */
+    size_t nprimes;
+    uint16_t primes[SMC_PRIME_WINDOW_BOUND / 7 + 64];   /* odd primes <= bound */
+    uint64_t cand[SMC_PRIME_WINDOW / 128];   /* bit i: lo + 2i not yet ruled out */
+    uint64_t known[SMC_PRIME_WINDOW / 128];  /* bit i: lo + 2i confirmed prime */
+} smc_prime_window;
+
+/* Sieve the window of odd values starting at lo (rounded up to odd) */
+SMC_API void smc_prime_window_fill(smc_prime_window *w, uint64_t lo) {
+    if (w->nprimes == 0) {
+        for (uint32_t p = 3; p <= SMC_PRIME_WINDOW_BOUND; p += 2) {
+            bool prime = true;
+            for (size_t k = 0; k < w->nprimes && (uint32_t)w->primes[k] * w->primes[k] <= p; k++)
+                if (p % w->primes[k] == 0) { prime = false; break; }
+            if (prime) w->primes[w->nprimes++] = (uint16_t)p;
+        }
+    }
+    lo |= 1;
+    w->lo = lo;
+    w->hi = lo > UINT64_MAX - SMC_PRIME_WINDOW ? UINT64_MAX : lo + SMC_PRIME_WINDOW;
+    size_t nbits = (size_t)((w->hi - lo) / 2), words = (nbits + 63) / 64;
+    memset(w->cand, 0xFF, words * 8);
+    if (nbits & 63) w->cand[words - 1] = (1ULL << (nbits & 63)) - 1;
+    memset(w->known, 0, sizeof(w->known));
+    for (size_t k = 0; k < w->nprimes; k++) {
+        uint64_t p = w->primes[k], sq = p * p, off;
+        if (sq >= w->hi) break;
+        if (sq >= lo) {
+            off = sq - lo;
+        } else {
+            uint64_t r = lo % p;
+            off = r ? p - r : 0;
+            if (off & 1) off += p;
+        }
+        for (size_t j = (size_t)(off / 2); j < nbits; j += (size_t)p) w->cand[j >> 6] &= ~(1ULL << (j & 63));
+    }
+    if (lo == 1) w->cand[0] &= ~1ULL;   /* 1 is not prime */
+    w->exact = smc_isqrt64(w->hi - 1) <= SMC_PRIME_WINDOW_BOUND;
+}
+
+/* Whether candidate bit i is prime, testing and recording it on first use */
+SMC_INLINE bool smc_prime_window_check(smc_prime_window *w, size_t i) {
+    uint64_t m = 1ULL << (i & 63);
+    if (w->exact || (w->known[i >> 6] & m)) return true;
+    if (smc_is_prime64(w->lo + 2 * (uint64_t)i)) { w->known[i >> 6] |= m; return true; }
+    w->cand[i >> 6] &= ~m;
+    return false;
+}
+
+/* Whether a query outside the window is close enough to the last one to refill */
+SMC_INLINE bool smc_prime_window_local_miss(smc_prime_window *w, uint64_t n) {
+    uint64_t d = n > w->last ? n - w->last : w->last - n;
+    w->last = n;
+    return d <= SMC_PRIME_WINDOW / 2;
+}
+
+/* Smallest prime >= n, as smc_next_prime64 (0 past the last 64-bit prime) */
+SMC_API uint64_t smc_prime_window_next(smc_prime_window *w, uint64_t n) {
+    if (n <= 2) return 2;
+    if (n == UINT64_MAX) return 0;
+    n |= 1;
+    if (w->hi == 0 || n < w->lo || n >= w->hi) {
+        if (!smc_prime_window_local_miss(w, n)) return smc_next_prime64(n);
+        smc_prime_window_fill(w, n > SMC_PRIME_WINDOW / 4 ? n - SMC_PRIME_WINDOW / 4 : 1);
+    }
+    for (;;) {
+        size_t nbits = (size_t)((w->hi - w->lo) / 2), i = (size_t)((n - w->lo) / 2);
+        while (i < nbits) {
+            uint64_t word = w->cand[i >> 6] & (~0ULL << (i & 63));
+            if (word == 0) { i = (i | 63) + 1; continue; }
+            i = (i & ~(size_t)63) + (size_t)smc_ctz64(word);
+            if (i >= nbits) break;
+            if (smc_prime_window_check(w, i)) return w->lo + 2 * (uint64_t)i;
+            i++;
+        }
+        if (w->hi == UINT64_MAX) return 0;
+        n = w->hi;
+        smc_prime_window_fill(w, n);
+    }
+}
+
+/* Largest prime <= n, as smc_prev_prime64 (0 below 2) */
+SMC_API uint64_t smc_prime_window_prev(smc_prime_window *w, uint64_t n) {
+    if (n < 3) return n == 2 ? 2 : 0;
+    if ((n & 1) == 0) n--;
+    if (w->hi == 0 || n < w->lo || n >= w->hi) {
+        if (!smc_prime_window_local_miss(w, n)) return smc_prev_prime64(n);
+        smc_prime_window_fill(w, n > SMC_PRIME_WINDOW / 4 * 3 ? n - SMC_PRIME_WINDOW / 4 * 3 : 1);
+    }
+    for (;;) {
+        size_t i = (size_t)((n - w->lo) / 2) + 1;
+        while (i > 0) {
+            uint64_t word = w->cand[(i - 1) >> 6] & (~0ULL >> (63 - ((i - 1) & 63)));
+            if (word == 0) { i = (i - 1) & ~(size_t)63; continue; }
+            i = ((i - 1) & ~(size_t)63) + 63 - (size_t)smc_clz64(word);
+            if (smc_prime_window_check(w, i)) return w->lo + 2 * (uint64_t)i;
+        }
+        if (w->lo <= 3) return 2;
+        n = w->lo - 2;
+        smc_prime_window_fill(w, w->lo > SMC_PRIME_WINDOW ? w->lo - SMC_PRIME_WINDOW : 1);
+    }
+}
+
+/* The calling thread's window (one per thread and translation unit) */
+SMC_API smc_prime_window *smc_prime_window_local(void) {
+    static SMC_THREAD_LOCAL smc_prime_window w;
+    return &w;
+}
+
+/* smc_next_prime64 / smc_prev_prime64 through the calling thread's window */
+SMC_API uint64_t smc_next_prime64_cached(uint64_t n) {
+    return smc_prime_window_next(smc_prime_window_local(), n);
+}
+
+SMC_API uint64_t smc_prev_prime64_cached(uint64_t n) {
+    return smc_prime_window_prev(smc_prime_window_local(), n);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_SIEVE_H */
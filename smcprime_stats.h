@@ -0,0 +1,411 @@
+/*
+ * smcPrime - Latency histograms
+ *
+ * Records how long sampled calls to the single-number entry points take,
+ * per function and per bit length of the argument, so the tail shows
+ * (smc_is_prime64 rejects most composites in a few divisions but runs
+ * twelve witnesses on a 64-bit prime):
+ * - smc_stats_is_prime64 and friends wrap the same functions as
+ *   smcprime_trace.h; built with SMC_STATS, every call compiled after this
+ *   header goes through them (and then through the trace wrappers if
+ *   SMC_TRACE is defined too)
+ * - A per-thread countdown with random gaps picks about one call in
+ *   'rate'; only that call reads the tick counter (rdtsc / cntvct_el0)
+ * - A sampled call leases a table of log buckets (two per power of two
+ *   ticks) that no other thread holds, counts into it and hands it back;
+ *   smc_stats_take sums the tables
+ * - Text and JSON dumps give samples and p50 / p90 / p99 / p99.9 in ns
+ *   per function and bit length, with the buckets in JSON
+ *
+ * A table takes 266 KB and is kept until smc_stats_free, so counts
+ * outlive their threads. Tables are reused once handed back, so there are
+ * only as many as threads ever recorded a sample at the same moment, not
+ * one per thread started (smc_parallel_for starts new ones per call).
+ * State is per translation unit by default, as for traces: counts cover
+ * the calls compiled in the unit that started sampling. Build every unit
+ * with -DSMC_SHARED_STATE and one with SMC_STATE_IMPLEMENTATION too
+ * (smcprime_sys.h) for process-wide histograms. POSIX builds must link
+ * with -pthread.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_STATS_H
+#define SMCPRIME_STATS_H
+
+#include "smcprime.h"
+#include "smcprime_factor.h"
+#include "smcprime_sys.h"
+#include "smcprime_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Calls between checks for started sampling while it is stopped */
+#ifndef SMC_STATS_IDLE
+  #define SMC_STATS_IDLE 4096
+#endif
+
+/* Argument bit lengths 0 .. 64 */
+#define SMC_STATS_BITS 65
+
+/* Latency buckets: two per power of two ticks, the last open-ended (3 * 2^30 ticks and up) */
+#define SMC_STATS_BUCKETS 64
+
+/* ===========================================================================
+ * BUCKETS
+ * =========================================================================== */
+
+/* Bucket of a duration in ticks: 0 and 1 alone, then [2, 3), [3, 4), [4, 6), [6, 8), ... */
+SMC_INLINE unsigned smc_stats_bucket(uint64_t t) {
+    if (t < 2) return (unsigned)t;
+    unsigned b = 64 - (unsigned)smc_clz64(t);
+    unsigned k = 2 * b - 2 + (unsigned)((t >> (b - 2)) & 1);
+    return k < SMC_STATS_BUCKETS ? k : SMC_STATS_BUCKETS - 1;
+}
+
+/* First tick count of bucket k */
+SMC_INLINE uint64_t smc_stats_bucket_start(unsigned k) {
+    if (k < 2) return k;
+    return (uint64_t)(2 + (k & 1)) << (k / 2 - 1);
+}
+
+/* First tick count past bucket k; the open-ended last bucket reports its start */
+SMC_INLINE uint64_t smc_stats_bucket_end(unsigned k) {
+    return k + 1 < SMC_STATS_BUCKETS ? smc_stats_bucket_start(k + 1) : smc_stats_bucket_start(k);
+}
+
+/* ===========================================================================
+ * SAMPLING
+ * =========================================================================== */
+
+/* Counts of whichever threads leased it, linked into the global list */
+typedef struct smc_stats_table {
+    struct smc_stats_table *next;
+    volatile uint64_t busy;     /* 1 while a thread is counting into it */
+    uint64_t count[SMC_TRACE_FUNCTIONS][SMC_STATS_BITS][SMC_STATS_BUCKETS];
+} smc_stats_table;
+
+typedef struct smc_stats_state {
+    volatile uint64_t rate;     /* mean calls per sample, 0 while stopped */
+    volatile uint64_t lock;
+    volatile uint64_t epoch;    /* bumped by smc_stats_free; older tables are gone */
+    uint64_t last_rate;
+    double ticks_per_ns;
+    smc_stats_table *tables;
+} smc_stats_state;
+
+typedef struct smc_stats_local {
+    uint64_t skip;
+    uint64_t depth;
+    uint64_t rng;
+    uint64_t epoch;
+    smc_stats_table *table;     /* the table leased last, tried first next time */
+} smc_stats_local;
+
+/* Per translation unit unless SMC_SHARED_STATE (smcprime_sys.h) */
+SMC_STATE smc_stats_state smc_stats_global;
+SMC_STATE SMC_THREAD_LOCAL smc_stats_local smc_stats_tls;
+
+SMC_INLINE void smc_stats_lock(void) {
+    while (!smc_atomic_cas64(&smc_stats_global.lock, 0, 1)) smc_yield();
+}
+
+SMC_INLINE void smc_stats_unlock(void) {
+    smc_atomic_store64(&smc_stats_global.lock, 0);
+}
+
+/*
+ * Start sampling about one call in 'rate' (1 = every call), adding to
+ * the counts so far. The first start measures the tick rate (about 10 ms).
+ * Returns false for rate 0.
+ */
+SMC_API bool smc_stats_start(uint32_t rate) {
+    smc_stats_state *g = &smc_stats_global;
+    if (rate == 0) return false;
+    smc_stats_lock();
+    if (g->ticks_per_ns == 0) g->ticks_per_ns = smc_ticks_per_ns(10);
+    g->last_rate = rate;
+    smc_atomic_store64(&g->rate, rate);
+    smc_stats_unlock();
+    return true;
+}
+
+/* Stop sampling; the counts are kept */
+SMC_API void smc_stats_stop(void) {
+    smc_atomic_store64(&smc_stats_global.rate, 0);
+}
+
+/* Zero every thread's counts */
+SMC_API void smc_stats_reset(void) {
+    smc_stats_lock();
+    for (smc_stats_table *t = smc_stats_global.tables; t != NULL; t = t->next) {
+        uint64_t *c = &t->count[0][0][0];
+        for (size_t i = 0; i < sizeof(t->count) / sizeof(uint64_t); i++) smc_atomic_store64(&c[i], 0);
+    }
+    smc_stats_unlock();
+}
+
+/*
+ * Stop sampling and free every thread's table. Only once no thread is
+ * inside a wrapped call; threads sampling after a new start get new tables.
+ */
+SMC_API void smc_stats_free(void) {
+    smc_stats_stop();
+    smc_stats_lock();
+    smc_stats_table *t = smc_stats_global.tables;
+    smc_stats_global.tables = NULL;
+    smc_atomic_fetch_add64(&smc_stats_global.epoch, 1);
+    smc_stats_unlock();
+    while (t != NULL) {
+        smc_stats_table *next = t->next;
+        free(t);
+        t = next;
+    }
+}
+
+/* Countdown ran out: draw the next gap (uniform in [1, 2 rate - 1]); true to sample this call */
+SMC_API bool smc_stats_rearm(smc_stats_local *t) {
+    uint64_t rate = smc_atomic_load64(&smc_stats_global.rate);
+    if (rate == 0) {
+        t->skip = SMC_STATS_IDLE;
+        return false;
+    }
+    if (t->rng == 0) t->rng = smc_nanoseconds() ^ (uint64_t)(uintptr_t)t ^ 0xD1B54A32D192ED03ULL;
+    t->rng ^= t->rng << 13;
+    t->rng ^= t->rng >> 7;
+    t->rng ^= t->rng << 17;
+    t->skip = 1 + t->rng % (2 * rate - 1);
+    return true;
+}
+
+/* Lease a free table, reusing a handed-back one before allocating; NULL if out of memory */
+SMC_API smc_stats_table *smc_stats_lease(smc_stats_local *l) {
+    uint64_t epoch = smc_atomic_load64(&smc_stats_global.epoch);
+    if (l->table != NULL && l->epoch == epoch && smc_atomic_cas64(&l->table->busy, 0, 1)) return l->table;
+    smc_stats_lock();
+    smc_stats_table *t = smc_stats_global.tables;
+    while (t != NULL && !smc_atomic_cas64(&t->busy, 0, 1)) t = t->next;
+    if (t == NULL && (t = (smc_stats_table *)calloc(1, sizeof(smc_stats_table))) != NULL) {
+        t->busy = 1;
+        t->next = smc_stats_global.tables;
+        smc_stats_global.tables = t;
+    }
+    l->epoch = smc_atomic_load64(&smc_stats_global.epoch);
+    smc_stats_unlock();
+    l->table = t;
+    return t;
+}
+
+/* Count one sample in a leased table */
+SMC_API void smc_stats_add(unsigned fn, uint64_t arg, uint64_t ticks) {
+    smc_stats_table *t = smc_stats_lease(&smc_stats_tls);
+    if (t == NULL) return;
+    unsigned bits = arg ? 64 - (unsigned)smc_clz64(arg) : 0;
+    uint64_t *c = &t->count[fn][bits][smc_stats_bucket(ticks)];
+    smc_atomic_store64(c, smc_atomic_load64(c) + 1);
+    smc_atomic_store64(&t->busy, 0);
+}
+
+/* Entering a wrapped call: true if this one is sampled */
+SMC_INLINE bool smc_stats_enter(void) {
+    smc_stats_local *t = &smc_stats_tls;
+    if (t->depth++ != 0) return false;
+    if (t->skip > 1) {
+        t->skip--;
+        return false;
+    }
+    return smc_stats_rearm(t);
+}
+
+/* Leaving a wrapped call; 'start' is its smc_ticks() if it was sampled */
+SMC_INLINE void smc_stats_leave(bool sampled, unsigned fn, uint64_t arg, uint64_t start) {
+    if (sampled) smc_stats_add(fn, arg, smc_ticks() - start);
+    smc_stats_tls.depth--;
+}
+
+/* ===========================================================================
+ * SNAPSHOTS
+ * =========================================================================== */
+
+/* Counts summed over threads at one moment */
+typedef struct smc_stats_snapshot {
+    uint64_t rate;          /* rate of the latest smc_stats_start */
+    double ticks_per_ns;
+    uint64_t count[SMC_TRACE_FUNCTIONS][SMC_STATS_BITS][SMC_STATS_BUCKETS];
+} smc_stats_snapshot;
+
+/* Sum every thread's counts into *s (allocate it: it takes 266 KB); threads keep sampling meanwhile */
+SMC_API void smc_stats_take(smc_stats_snapshot *s) {
+    memset(s, 0, sizeof(*s));
+    smc_stats_lock();
+    s->rate = smc_stats_global.last_rate;
+    s->ticks_per_ns = smc_stats_global.ticks_per_ns > 0 ? smc_stats_global.ticks_per_ns : 1.0;
+    for (smc_stats_table *t = smc_stats_global.tables; t != NULL; t = t->next) {
+        const uint64_t *c = &t->count[0][0][0];
+        uint64_t *d = &s->count[0][0][0];
+        for (size_t i = 0; i < sizeof(t->count) / sizeof(uint64_t); i++) d[i] += smc_atomic_load64(&c[i]);
+    }
+    smc_stats_unlock();
+}
+
+/* Sampled durations of one function, at one bit length or all of them (bits < 0) */
+SMC_INLINE uint64_t smc_stats_histogram(const smc_stats_snapshot *s, unsigned fn, int bits,
+                                        uint64_t h[SMC_STATS_BUCKETS]) {
+    uint64_t total = 0;
+    memset(h, 0, SMC_STATS_BUCKETS * sizeof(uint64_t));
+    for (int b = 0; b < SMC_STATS_BITS; b++) {
+        if (bits >= 0 && b != bits) continue;
+        for (int k = 0; k < SMC_STATS_BUCKETS; k++) h[k] += s->count[fn][b][k];
+    }
+    for (int k = 0; k < SMC_STATS_BUCKETS; k++) total += h[k];
+    return total;
+}
+
+/* Upper end in ns of the bucket holding quantile q of a histogram */
+SMC_INLINE double smc_stats_quantile(const uint64_t h[SMC_STATS_BUCKETS], uint64_t total, double q,
+                                     double ticks_per_ns) {
+    if (total == 0) return 0;
+    uint64_t need = (uint64_t)(q * (double)total), sum = 0;
+    unsigned k = 0;
+    for (; k < SMC_STATS_BUCKETS - 1; k++) {
+        sum += h[k];
+        if (sum > need || sum == total) break;
+    }
+    return (double)smc_stats_bucket_end(k) / ticks_per_ns;
+}
+
+/* Quantiles reported by the dumps */
+static const double smc_stats_qs[4] = {0.5, 0.9, 0.99, 0.999};
+
+/*
+ * Per function: samples and p50 / p90 / p99 / p99.9 (bucket upper ends,
+ * ns) over all arguments, then for each bit length that has samples
+ */
+SMC_API void smc_stats_dump_text(FILE *f, const smc_stats_snapshot *s) {
+    uint64_t h[SMC_STATS_BUCKETS];
+    fprintf(f, "sampled 1 in %llu calls, %.3f ticks/ns\n", (unsigned long long)s->rate, s->ticks_per_ns);
+    for (unsigned fn = 0; fn < SMC_TRACE_FUNCTIONS; fn++) {
+        if (smc_stats_histogram(s, fn, -1, h) == 0) continue;
+        fprintf(f, "\n%s\n%6s %12s %10s %10s %10s %10s\n", smc_trace_names[fn], "bits", "samples",
+                "p50 ns", "p90 ns", "p99 ns", "p99.9 ns");
+        for (int b = -1; b < SMC_STATS_BITS; b++) {
+            uint64_t total = smc_stats_histogram(s, fn, b, h);
+            if (total == 0) continue;
+            if (b < 0) fprintf(f, "%6s", "all");
+            else fprintf(f, "%6d", b);
+            fprintf(f, " %12llu", (unsigned long long)total);
+            for (int i = 0; i < 4; i++) fprintf(f, " %10.0f", smc_stats_quantile(h, total, smc_stats_qs[i], s->ticks_per_ns));
+            fprintf(f, "\n");
+        }
+    }
+}
+
+/* Quantiles of one histogram as JSON members */
+SMC_API void smc_stats_json_quantiles(FILE *f, const uint64_t *h, uint64_t total, double ticks_per_ns) {
+    static const char *const names[4] = {"p50_ns", "p90_ns", "p99_ns", "p999_ns"};
+    fprintf(f, "\"samples\": %llu", (unsigned long long)total);
+    for (int i = 0; i < 4; i++)
+        fprintf(f, ", \"%s\": %.1f", names[i], smc_stats_quantile(h, total, smc_stats_qs[i], ticks_per_ns));
+}
+
+/*
+ * The same as JSON: {"rate", "ticks_per_ns", "functions": [{"name",
+ * quantiles, "bits": [{"bits", quantiles, "buckets": [[end_ns, count],
+ * ...]}]}]}, listing only non-empty entries; the open-ended last bucket
+ * gives its start
+ */
+SMC_API void smc_stats_dump_json(FILE *f, const smc_stats_snapshot *s) {
+    uint64_t h[SMC_STATS_BUCKETS];
+    fprintf(f, "{\"rate\": %llu, \"ticks_per_ns\": %.4f, \"functions\": [",
+            (unsigned long long)s->rate, s->ticks_per_ns);
+    const char *sep = "";
+    for (unsigned fn = 0; fn < SMC_TRACE_FUNCTIONS; fn++) {
+        uint64_t all = smc_stats_histogram(s, fn, -1, h);
+        if (all == 0) continue;
+        fprintf(f, "%s\n  {\"name\": \"%s\", ", sep, smc_trace_names[fn]);
+        smc_stats_json_quantiles(f, h, all, s->ticks_per_ns);
+        fprintf(f, ", \"bits\": [");
+        const char *bsep = "";
+        for (int b = 0; b < SMC_STATS_BITS; b++) {
+            uint64_t total = smc_stats_histogram(s, fn, b, h);
+            if (total == 0) continue;
+            fprintf(f, "%s\n    {\"bits\": %d, ", bsep, b);
+            smc_stats_json_quantiles(f, h, total, s->ticks_per_ns);
+            fprintf(f, ", \"buckets\": [");
+            const char *ksep = "";
+            for (unsigned k = 0; k < SMC_STATS_BUCKETS; k++) {
+                if (h[k] == 0) continue;
+                fprintf(f, "%s[%.1f, %llu]", ksep, (double)smc_stats_bucket_end(k) / s->ticks_per_ns,
+                        (unsigned long long)h[k]);
+                ksep = ", ";
+            }
+            fprintf(f, "]}");
+            bsep = ",";
+        }
+        fprintf(f, "]}");
+        sep = ",";
+    }
+    fprintf(f, "\n]}\n");
+}
+
+/* ===========================================================================
+ * WRAPPERS
+ *
+ * The entry points with sampling; SMC_STATS maps the plain names to them
+ * for all code compiled after this header. With SMC_TRACE as well they
+ * call the trace wrappers, so both run.
+ * =========================================================================== */
+
+#ifdef SMC_TRACE
+  #define SMC_STATS_INNER(name) smc_trace_##name
+#else
+  #define SMC_STATS_INNER(name) (smc_##name)
+#endif
+
+#define SMC_STATS_WRAP(ret, name, arg, id)                    \
+    SMC_INLINE ret smc_stats_##name(arg n) {                  \
+        bool sampled = smc_stats_enter();                     \
+        uint64_t start = sampled ? smc_ticks() : 0;           \
+        ret r = SMC_STATS_INNER(name)(n);                     \
+        smc_stats_leave(sampled, id, n, start);               \
+        return r;                                             \
+    }
+
+SMC_STATS_WRAP(bool, is_prime32, uint32_t, SMC_TRACE_IS_PRIME32)
+SMC_STATS_WRAP(bool, is_prime64, uint64_t, SMC_TRACE_IS_PRIME64)
+SMC_STATS_WRAP(bool, is_prime64_wc, uint64_t, SMC_TRACE_IS_PRIME64_WC)
+SMC_STATS_WRAP(uint32_t, next_prime32, uint32_t, SMC_TRACE_NEXT_PRIME32)
+SMC_STATS_WRAP(uint32_t, prev_prime32, uint32_t, SMC_TRACE_PREV_PRIME32)
+SMC_STATS_WRAP(uint64_t, next_prime64, uint64_t, SMC_TRACE_NEXT_PRIME64)
+SMC_STATS_WRAP(uint64_t, prev_prime64, uint64_t, SMC_TRACE_PREV_PRIME64)
+
+SMC_INLINE int smc_stats_factor64(uint64_t n, uint64_t *f) {
+    bool sampled = smc_stats_enter();
+    uint64_t start = sampled ? smc_ticks() : 0;
+    int r = SMC_STATS_INNER(factor64)(n, f);
+    smc_stats_leave(sampled, SMC_TRACE_FACTOR64, n, start);
+    return r;
+}
+
+#ifdef SMC_STATS
+  #define smc_is_prime32(n)    smc_stats_is_prime32(n)
+  #define smc_is_prime64(n)    smc_stats_is_prime64(n)
+  #define smc_is_prime64_wc(n) smc_stats_is_prime64_wc(n)
+  #define smc_next_prime32(n)  smc_stats_next_prime32(n)
+  #define smc_prev_prime32(n)  smc_stats_prev_prime32(n)
+  #define smc_next_prime64(n)  smc_stats_next_prime64(n)
+  #define smc_prev_prime64(n)  smc_stats_prev_prime64(n)
+  #define smc_factor64(n, f)   smc_stats_factor64(n, f)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_STATS_H */
@@ -0,0 +1,674 @@
+/*
+ * smcPrime - Platform helpers
+ *
+ * Thin portability layer used by the sieve, index and engine headers:
+ * - Read-only file mapping (mmap on POSIX, MapViewOfFile on Windows),
+ *   exclusive file creation and atomic file replacement
+ * - Atomic counters, one-time initialization, thread-local storage and a
+ *   fork-join parallel loop (pthreads / Win32)
+ * - Detached background threads
+ * - A wall clock for throughput reports, a monotonic nanosecond clock and
+ *   a raw tick counter (rdtsc / cntvct_el0) for timing single calls
+ * - Cache topology (sysfs on Linux, cpuid on x86, the Win32 API), which
+ *   sizes the sieve segments and factorization chunks
+ *
+ * POSIX builds using the threading helpers must link with -pthread.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_SYS_H
+#define SMCPRIME_SYS_H
+
+#include "smcprime.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #ifndef WIN32_LEAN_AND_MEAN
+    #define WIN32_LEAN_AND_MEAN
+  #endif
+  #include <windows.h>
+  #if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+  #endif
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #include <cpuid.h>
+#endif
+#if !defined(_WIN32)
+  #include <fcntl.h>
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <sys/time.h>
+  #include <time.h>
+  #include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ===========================================================================
+ * FILE MAPPING
+ *
+ * Maps a whole file read-only. Returns NULL on failure (missing file,
+ * empty file, mapping error). The mapping stays valid after the file
+ * descriptor/handle is closed; release it with smc_unmap_file.
+ * =========================================================================== */
+
+SMC_API const void *smc_map_file(const char *path, size_t *len) {
+#if defined(_WIN32)
+    HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return NULL;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(f, &size) || size.QuadPart == 0) { CloseHandle(f); return NULL; }
+    HANDLE m = CreateFileMappingA(f, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(f);
+    if (m == NULL) return NULL;
+    const void *p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(m);
+    if (p == NULL) return NULL;
+    *len = (size_t)size.QuadPart;
+    return p;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return NULL; }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    *len = (size_t)st.st_size;
+    return p;
+#endif
+}
+
+SMC_API void smc_unmap_file(const void *p, size_t len) {
+    if (p == NULL) return;
+#if defined(_WIN32)
+    (void)len;
+    UnmapViewOfFile(p);
+#else
+    munmap((void *)p, len);
+#endif
+}
+
+/*
+ * smc_map_file for files only the caller could have written: on POSIX the
+ * file must be a regular file (not reached through a symlink) owned by the
+ * effective user or root and not writable by group or others. On Windows
+ * this is smc_map_file; callers keep such files in per-user directories.
+ */
+SMC_API const void *smc_map_private_file(const char *path, size_t *len) {
+#if defined(_WIN32)
+    return smc_map_file(path, len);
+#else
+  #ifdef O_NOFOLLOW
+    int fd = open(path, O_RDONLY | O_NOFOLLOW);
+  #else
+    int fd = open(path, O_RDONLY);
+  #endif
+    if (fd < 0) return NULL;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+        || (st.st_uid != geteuid() && st.st_uid != 0) || (st.st_mode & (S_IWGRP | S_IWOTH))) {
+        close(fd);
+        return NULL;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return NULL;
+    *len = (size_t)st.st_size;
+    return p;
+#endif
+}
+
+/*
+ * Create path and write len bytes to it. Fails if path already exists,
+ * symlinks included, instead of following or truncating it; on POSIX the
+ * file is readable and writable by the owner only. A partial file is
+ * removed on failure.
+ */
+SMC_API bool smc_write_new_file(const char *path, const void *data, size_t len) {
+    const char *p = (const char *)data;
+#if defined(_WIN32)
+    HANDLE f = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    bool ok = true;
+    while (ok && len > 0) {
+        DWORD n = len < (1u << 30) ? (DWORD)len : (DWORD)(1u << 30), done = 0;
+        ok = WriteFile(f, p, n, &done, NULL) && done == n;
+        p += n;
+        len -= n;
+    }
+    ok = CloseHandle(f) && ok;
+#else
+  #ifdef O_NOFOLLOW
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW, 0600);
+  #else
+    int fd = open(path, O_WRONLY | O_CREAT | O_EXCL, 0600);
+  #endif
+    if (fd < 0) return false;
+    bool ok = true;
+    while (ok && len > 0) {
+        ssize_t n = write(fd, p, len < ((size_t)1 << 30) ? len : ((size_t)1 << 30));
+        ok = n > 0;
+        if (ok) {
+            p += n;
+            len -= (size_t)n;
+        }
+    }
+    ok = close(fd) == 0 && ok;
+#endif
+    if (!ok) remove(path);
+    return ok;
+}
+
+/* Atomically move 'from' over 'to' (both on the same volume) */
+SMC_API bool smc_replace_file(const char *from, const char *to) {
+#if defined(_WIN32)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from, to) == 0;
+#endif
+}
+
+/* Identifier of the calling process, for unique temporary names */
+SMC_API unsigned long smc_process_id(void) {
+#if defined(_WIN32)
+    return (unsigned long)GetCurrentProcessId();
+#else
+    return (unsigned long)getpid();
+#endif
+}
+
+/* Seconds since an arbitrary epoch; differences time long-running jobs */
+SMC_API double smc_seconds(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (double)c.QuadPart / (double)f.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec * 1e-6;
+#endif
+}
+
+/*
+ * Nanoseconds since an arbitrary epoch, for timing single calls: the
+ * monotonic clock where the C library declares it (strict ISO builds
+ * may hide it), else the C11 or microsecond wall clock
+ */
+SMC_API uint64_t smc_nanoseconds(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER c, f;
+    QueryPerformanceCounter(&c);
+    QueryPerformanceFrequency(&f);
+    return (uint64_t)(c.QuadPart / f.QuadPart) * 1000000000ULL +
+           (uint64_t)(c.QuadPart % f.QuadPart) * 1000000000ULL / (uint64_t)f.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#elif defined(TIME_UTC)
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (uint64_t)tv.tv_sec * 1000000000ULL + (uint64_t)tv.tv_usec * 1000;
+#endif
+}
+
+/*
+ * Raw tick counter for timing short calls: the TSC on x86 (rdtsc),
+ * the virtual timer on AArch64 (cntvct_el0), else smc_nanoseconds. Ticks
+ * are not cycles on every CPU; see smc_ticks_per_ns.
+ */
+SMC_INLINE uint64_t smc_ticks(void) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return __rdtsc();
+#elif (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_ia32_rdtsc();
+#elif defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__))
+    uint64_t v;
+    __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#else
+    return smc_nanoseconds();
+#endif
+}
+
+/* smc_ticks per nanosecond: the timer frequency on AArch64, else measured over about 'ms' ms */
+SMC_API double smc_ticks_per_ns(unsigned ms) {
+#if defined(__aarch64__) && (defined(__GNUC__) || defined(__clang__)) && !defined(_MSC_VER)
+    uint64_t f;
+    (void)ms;
+    __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(f));
+    return (double)f * 1e-9;
+#else
+    uint64_t n0 = smc_nanoseconds(), t0 = smc_ticks(), n1;
+    do n1 = smc_nanoseconds(); while (n1 - n0 < (uint64_t)ms * 1000000);
+    uint64_t t1 = smc_ticks();
+    return n1 > n0 ? (double)(t1 - t0) / (double)(n1 - n0) : 1.0;
+#endif
+}
+
+/* ===========================================================================
+ * ATOMICS
+ * =========================================================================== */
+
+SMC_INLINE uint64_t smc_atomic_fetch_add64(volatile uint64_t *p, uint64_t v) {
+#if defined(_MSC_VER)
+    return (uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)p, (LONG64)v);
+#else
+    return __atomic_fetch_add(p, v, __ATOMIC_RELAXED);
+#endif
+}
+
+SMC_INLINE uint64_t smc_atomic_load64(const volatile uint64_t *p) {
+#if defined(_MSC_VER)
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)p, 0, 0);
+#else
+    return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+#endif
+}
+
+SMC_INLINE void smc_atomic_store64(volatile uint64_t *p, uint64_t v) {
+#if defined(_MSC_VER)
+    InterlockedExchange64((volatile LONG64 *)p, (LONG64)v);
+#else
+    __atomic_store_n(p, v, __ATOMIC_RELEASE);
+#endif
+}
+
+/* *p &= v; returns the previous value */
+SMC_INLINE uint64_t smc_atomic_fetch_and64(volatile uint64_t *p, uint64_t v) {
+#if defined(_MSC_VER)
+    return (uint64_t)InterlockedAnd64((volatile LONG64 *)p, (LONG64)v);
+#else
+    return __atomic_fetch_and(p, v, __ATOMIC_RELAXED);
+#endif
+}
+
+/* Replace *p by desired if it equals expected; returns whether it did */
+SMC_INLINE bool smc_atomic_cas64(volatile uint64_t *p, uint64_t expected, uint64_t desired) {
+#if defined(_MSC_VER)
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)p, (LONG64)desired,
+                                                  (LONG64)expected) == expected;
+#else
+    return __atomic_compare_exchange_n(p, &expected, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+#endif
+}
+
+SMC_INLINE void smc_yield(void) {
+#if defined(_WIN32)
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+
+/*
+ * One-time initialization: the first caller runs fn(ctx) while later
+ * callers wait; every caller returns after fn has finished. 'flag' must
+ * start at 0 (SMC_ONCE_INIT).
+ */
+#define SMC_ONCE_INIT 0
+
+SMC_API void smc_once(volatile uint64_t *flag, void (*fn)(void *ctx), void *ctx) {
+    if (smc_atomic_load64(flag) == 2) return;
+    if (smc_atomic_cas64(flag, 0, 1)) {
+        fn(ctx);
+        smc_atomic_store64(flag, 2);
+        return;
+    }
+    while (smc_atomic_load64(flag) != 2) smc_yield();
+}
+
+/* Storage class for per-thread state */
+#ifndef SMC_THREAD_LOCAL
+  #if defined(__cplusplus)
+    #define SMC_THREAD_LOCAL thread_local
+  #elif defined(_MSC_VER)
+    #define SMC_THREAD_LOCAL __declspec(thread)
+  #elif defined(__GNUC__) || defined(__clang__)
+    #define SMC_THREAD_LOCAL __thread
+  #else
+    #define SMC_THREAD_LOCAL _Thread_local
+  #endif
+#endif
+
+/*
+ * Storage class for process-wide state (cache topology here, traces and
+ * latency histograms in their headers). By default every translation
+ * unit keeps its own copy, so e.g. smc_cache_override in one unit does not
+ * reach the others. To share one copy, build every unit with
+ * -DSMC_SHARED_STATE and define SMC_STATE_IMPLEMENTATION in exactly one
+ * of them, before it includes every header whose state the program uses.
+ */
+#ifndef SMC_STATE
+  #if !defined(SMC_SHARED_STATE)
+    #define SMC_STATE static
+  #elif defined(SMC_STATE_IMPLEMENTATION)
+    #define SMC_STATE
+  #else
+    #define SMC_STATE extern
+  #endif
+#endif
+
+/* ===========================================================================
+ * CACHE TOPOLOGY
+ *
+ * Per-core data cache sizes in bytes, detected once per translation unit
+ * (once per process with SMC_SHARED_STATE): Linux sysfs first, then cpuid
+ * leaf 4 (Intel) or 0x8000001D (AMD), then GetLogicalProcessorInformation
+ * on Windows. Anything not found falls back to 32 KB L1d and 256 KB L2.
+ * smc_cache_override replaces the detected values, e.g. to tune for
+ * another machine; call it before starting work.
+ * =========================================================================== */
+
+typedef struct smc_cache_info {
+    size_t l1d;             /* level-1 data cache */
+    size_t l2;              /* level-2 (unified) cache */
+    size_t l3;              /* last-level cache, 0 if none */
+    size_t line;            /* cache line */
+} smc_cache_info;
+
+/* Store one cache level; 'data' is false for instruction caches */
+SMC_INLINE void smc_cache_set_level(smc_cache_info *c, unsigned level, bool data, size_t size) {
+    if (!data || size == 0) return;
+    if (level == 1) c->l1d = size;
+    else if (level == 2) c->l2 = size;
+    else if (level == 3) c->l3 = size;
+}
+
+/* /sys/devices/system/cpu/cpu0/cache/index<i>; false if unavailable */
+SMC_API bool smc_cache_detect_sysfs(smc_cache_info *c) {
+#if defined(__linux__)
+    bool found = false;
+    for (unsigned i = 0; i < 16; i++) {
+        char path[96], type[32] = { 0 };
+        unsigned level = 0, line = 0;
+        unsigned long size = 0;
+        char unit = 0;
+        FILE *f;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", i);
+        if ((f = fopen(path, "r")) == NULL) break;
+        if (fscanf(f, "%u", &level) != 1) level = 0;
+        fclose(f);
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/type", i);
+        if ((f = fopen(path, "r")) != NULL) {
+            if (fscanf(f, "%31s", type) != 1) type[0] = 0;
+            fclose(f);
+        }
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", i);
+        if ((f = fopen(path, "r")) != NULL) {
+            if (fscanf(f, "%lu%c", &size, &unit) < 1) size = 0;
+            fclose(f);
+        }
+        if (unit == 'K') size <<= 10;
+        else if (unit == 'M') size <<= 20;
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/coherency_line_size", i);
+        if ((f = fopen(path, "r")) != NULL) {
+            if (fscanf(f, "%u", &line) == 1 && line) c->line = line;
+            fclose(f);
+        }
+        smc_cache_set_level(c, level, type[0] != 'I', (size_t)size);
+        found = found || size != 0;
+    }
+    return found;
+#else
+    (void)c;
+    return false;
+#endif
+}
+
+/* Deterministic cache parameters from cpuid; false if not x86 or not reported */
+SMC_API bool smc_cache_detect_cpuid(smc_cache_info *c) {
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(_WIN32)
+    unsigned a, b, cx, d, leaf = 4;
+    if (!__get_cpuid(0, &a, &b, &cx, &d)) return false;
+    bool amd = b == 0x68747541;   /* "Auth"enticAMD */
+    if (amd) {
+        unsigned max_ext = __get_cpuid_max(0x80000000, NULL);
+        if (max_ext < 0x8000001D || !__get_cpuid(0x80000001, &a, &b, &cx, &d) || !(cx & (1u << 22)))
+            return false;   /* no topology extensions */
+        leaf = 0x8000001D;
+    } else if (a < 4) {
+        return false;
+    }
+    bool found = false;
+    for (unsigned i = 0; i < 16; i++) {
+        __cpuid_count(leaf, i, a, b, cx, d);
+        unsigned type = a & 31;
+        if (type == 0) break;
+        size_t line = (b & 0xFFF) + 1, parts = ((b >> 12) & 0x3FF) + 1, ways = (b >> 22) + 1;
+        size_t size = line * parts * ways * ((size_t)cx + 1);
+        smc_cache_set_level(c, (a >> 5) & 7, type != 2, size);
+        c->line = line;
+        found = true;
+    }
+    return found;
+#else
+    (void)c;
+    return false;
+#endif
+}
+
+/* Detected sizes with the fallbacks applied */
+SMC_API void smc_cache_detect(smc_cache_info *c) {
+    memset(c, 0, sizeof(*c));
+#if defined(_WIN32)
+    DWORD len = 0;
+    GetLogicalProcessorInformation(NULL, &len);
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION *info = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION *)malloc(len);
+    if (info != NULL && GetLogicalProcessorInformation(info, &len)) {
+        for (DWORD i = 0; i < len / sizeof(*info); i++) {
+            if (info[i].Relationship != RelationCache) continue;
+            const CACHE_DESCRIPTOR *cd = &info[i].Cache;
+            smc_cache_set_level(c, cd->Level, cd->Type != CacheInstruction, cd->Size);
+            if (cd->LineSize) c->line = cd->LineSize;
+        }
+    }
+    free(info);
+#else
+    if (!smc_cache_detect_sysfs(c)) smc_cache_detect_cpuid(c);
+#endif
+    if (c->l1d == 0) c->l1d = 32 * 1024;
+    if (c->l2 < c->l1d) c->l2 = c->l1d > 256 * 1024 ? c->l1d : 256 * 1024;
+    if (c->line == 0) c->line = 64;
+}
+
+typedef struct smc_cache_state {
+    volatile uint64_t once;
+    smc_cache_info info;
+} smc_cache_state;
+
+/* Per-translation-unit state unless SMC_SHARED_STATE; zero is SMC_ONCE_INIT and "not detected" */
+SMC_STATE smc_cache_state smc_cache_global;
+
+SMC_API void smc_cache_init(void *ctx) {
+    smc_cache_detect(&((smc_cache_state *)ctx)->info);
+}
+
+/* Cache sizes used for tuning: detected on first use unless overridden */
+SMC_API const smc_cache_info *smc_cache_sizes(void) {
+    smc_once(&smc_cache_global.once, smc_cache_init, &smc_cache_global);
+    return &smc_cache_global.info;
+}
+
+/*
+ * Replace the tuning sizes; zero fields keep the detected value, NULL
+ * re-detects. Affects only the calling translation unit unless every unit
+ * is built with SMC_SHARED_STATE.
+ */
+SMC_API void smc_cache_override(const smc_cache_info *c) {
+    smc_cache_info *cur = &smc_cache_global.info;
+    smc_cache_sizes();
+    if (c == NULL) {
+        smc_cache_detect(cur);
+        return;
+    }
+    if (c->l1d) cur->l1d = c->l1d;
+    if (c->l2) cur->l2 = c->l2;
+    if (c->l3) cur->l3 = c->l3;
+    if (c->line) cur->line = c->line;
+}
+
+/* ===========================================================================
+ * PARALLEL LOOP
+ *
+ * smc_parallel_for runs fn(ctx, i) for every i in [0, count) on up to
+ * 'threads' threads (0 = one per hardware thread). Indices are handed out
+ * dynamically, the calling thread takes part, and the call returns once
+ * every index has finished. fn must be safe to run concurrently.
+ * =========================================================================== */
+
+typedef void (*smc_task_fn)(void *ctx, size_t index);
+
+/* Number of hardware threads available to the process (at least 1) */
+SMC_API unsigned smc_thread_count(void) {
+#if defined(_WIN32)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return si.dwNumberOfProcessors ? (unsigned)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned)n : 1;
+#endif
+}
+
+typedef struct smc_parallel_job {
+    smc_task_fn fn;
+    void *ctx;
+    uint64_t count;
+    volatile uint64_t next;
+} smc_parallel_job;
+
+SMC_API void smc_parallel_worker(smc_parallel_job *job) {
+    for (;;) {
+        uint64_t i = smc_atomic_fetch_add64(&job->next, 1);
+        if (i >= job->count) break;
+        job->fn(job->ctx, (size_t)i);
+    }
+}
+
+#if defined(_WIN32)
+SMC_API DWORD WINAPI smc_parallel_entry(LPVOID arg) {
+    smc_parallel_worker((smc_parallel_job *)arg);
+    return 0;
+}
+#else
+SMC_API void *smc_parallel_entry(void *arg) {
+    smc_parallel_worker((smc_parallel_job *)arg);
+    return NULL;
+}
+#endif
+
+/* Returns false if fewer threads than requested could be started; all indices still run */
+SMC_API bool smc_parallel_for(size_t count, unsigned threads, smc_task_fn fn, void *ctx) {
+    smc_parallel_job job;
+    job.fn = fn;
+    job.ctx = ctx;
+    job.count = count;
+    job.next = 0;
+    if (threads == 0) threads = smc_thread_count();
+    if ((size_t)threads > count) threads = count ? (unsigned)count : 1;
+
+    unsigned started = 0;
+    bool ok = true;
+#if defined(_WIN32)
+    HANDLE *tids = (HANDLE *)malloc(threads * sizeof(HANDLE));
+#else
+    pthread_t *tids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+#endif
+    if (tids == NULL) ok = threads <= 1;
+    for (unsigned t = 1; tids != NULL && t < threads; t++) {
+#if defined(_WIN32)
+        tids[started] = CreateThread(NULL, 0, smc_parallel_entry, &job, 0, NULL);
+        if (tids[started] == NULL) { ok = false; break; }
+#else
+        if (pthread_create(&tids[started], NULL, smc_parallel_entry, &job) != 0) { ok = false; break; }
+#endif
+        started++;
+    }
+    smc_parallel_worker(&job);
+    for (unsigned t = 0; t < started; t++) {
+#if defined(_WIN32)
+        WaitForSingleObject(tids[t], INFINITE);
+        CloseHandle(tids[t]);
+#else
+        pthread_join(tids[t], NULL);
+#endif
+    }
+    free(tids);
+    return ok;
+}
+
+/* ===========================================================================
+ * DETACHED THREADS
+ *
+ * smc_spawn runs fn(ctx, 0) on a new thread that nobody joins; the caller
+ * learns about completion through whatever fn signals. Used by the async
+ * C++ layer to keep long jobs off the awaiting thread.
+ * =========================================================================== */
+
+typedef struct smc_spawn_arg {
+    smc_task_fn fn;
+    void *ctx;
+} smc_spawn_arg;
+
+#if defined(_WIN32)
+SMC_API DWORD WINAPI smc_spawn_entry(LPVOID arg) {
+    smc_spawn_arg a = *(smc_spawn_arg *)arg;
+    free(arg);
+    a.fn(a.ctx, 0);
+    return 0;
+}
+#else
+SMC_API void *smc_spawn_entry(void *arg) {
+    smc_spawn_arg a = *(smc_spawn_arg *)arg;
+    free(arg);
+    a.fn(a.ctx, 0);
+    return NULL;
+}
+#endif
+
+/* Returns false if the thread could not be started; fn has then not run */
+SMC_API bool smc_spawn(smc_task_fn fn, void *ctx) {
+    smc_spawn_arg *a = (smc_spawn_arg *)malloc(sizeof(smc_spawn_arg));
+    if (a == NULL) return false;
+    a->fn = fn;
+    a->ctx = ctx;
+#if defined(_WIN32)
+    HANDLE h = CreateThread(NULL, 0, smc_spawn_entry, a, 0, NULL);
+    if (h == NULL) { free(a); return false; }
+    CloseHandle(h);
+#else
+    pthread_t t;
+    pthread_attr_t attr;
+    if (pthread_attr_init(&attr) != 0) { free(a); return false; }
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&t, &attr, smc_spawn_entry, a);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) { free(a); return false; }
+#endif
+    return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_SYS_H */
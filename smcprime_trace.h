@@ -0,0 +1,324 @@
+/*
+ * smcPrime - Call trace capture
+ *
+ * Records a sample of real calls to the single-number entry points into a
+ * compact binary trace, so optimizations can be judged offline against
+ * production inputs (tools/smc_replay.c re-executes a trace):
+ * - smc_trace_is_prime64 and friends wrap smc_is_prime32/64,
+ *   smc_is_prime64_wc, smc_next_prime32/64, smc_prev_prime32/64 and
+ *   smc_factor64; built with SMC_TRACE, every call compiled after this
+ *   header goes through them
+ * - A call is timed only when a per-thread countdown runs out (a random
+ *   gap averaging 'rate' calls), otherwise the wrapper costs a decrement
+ * - Calls made inside a traced call (e.g. smc_factor64's own primality
+ *   tests) are not sampled, so a replay does each piece of work once
+ *
+ * File: "SMCTRACE", then the format version and the sampling rate as
+ * little-endian 32-bit words, then one record per sampled call - a byte
+ * holding the function (top 3 bits) and the latency class (bit length of
+ * the nanoseconds, capped at 31), then the argument as a LEB128 varint.
+ *
+ * Trace state is per translation unit by default: a trace only sees calls
+ * compiled in the unit that started it, and starting one in several units
+ * opens the file several times. Build every unit with -DSMC_SHARED_STATE
+ * and one with SMC_STATE_IMPLEMENTATION too (smcprime_sys.h) for a single
+ * process-wide trace. POSIX builds must link with -pthread.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#ifndef SMCPRIME_TRACE_H
+#define SMCPRIME_TRACE_H
+
+#include "smcprime.h"
+#include "smcprime_factor.h"
+#include "smcprime_sys.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Bytes of records buffered between writes */
+#ifndef SMC_TRACE_BUFFER
+  #define SMC_TRACE_BUFFER (64 * 1024)
+#endif
+
+/* Calls between checks for a started trace while none is running */
+#ifndef SMC_TRACE_IDLE
+  #define SMC_TRACE_IDLE 4096
+#endif
+
+#define SMC_TRACE_MAGIC "SMCTRACE"
+#define SMC_TRACE_VERSION 1
+#define SMC_TRACE_HEADER 16
+
+/* Longest record: function byte plus a 10-byte varint */
+#define SMC_TRACE_RECORD_MAX 11
+
+/* Traced functions (3-bit ids) */
+#define SMC_TRACE_IS_PRIME32    0
+#define SMC_TRACE_IS_PRIME64    1
+#define SMC_TRACE_IS_PRIME64_WC 2
+#define SMC_TRACE_NEXT_PRIME32  3
+#define SMC_TRACE_PREV_PRIME32  4
+#define SMC_TRACE_NEXT_PRIME64  5
+#define SMC_TRACE_PREV_PRIME64  6
+#define SMC_TRACE_FACTOR64      7
+#define SMC_TRACE_FUNCTIONS     8
+
+static const char *const smc_trace_names[SMC_TRACE_FUNCTIONS] = {
+    "smc_is_prime32", "smc_is_prime64", "smc_is_prime64_wc", "smc_next_prime32",
+    "smc_prev_prime32", "smc_next_prime64", "smc_prev_prime64", "smc_factor64",
+};
+
+/* ===========================================================================
+ * RECORDS
+ * =========================================================================== */
+
+/* One sampled call */
+typedef struct smc_trace_entry {
+    uint64_t arg;
+    unsigned fn;
+    unsigned cls;   /* latency class: [2^(cls-1), 2^cls) ns, 0 for 0 ns, 31 open-ended */
+} smc_trace_entry;
+
+/* Latency class of a duration in nanoseconds */
+SMC_INLINE unsigned smc_trace_class(uint64_t ns) {
+    if (ns == 0) return 0;
+    unsigned c = 64 - (unsigned)smc_clz64(ns);
+    return c < 31 ? c : 31;
+}
+
+/* Encode a record into p (SMC_TRACE_RECORD_MAX bytes); returns its length */
+SMC_INLINE size_t smc_trace_encode(uint8_t *p, const smc_trace_entry *e) {
+    size_t k = 0;
+    uint64_t a = e->arg;
+    p[k++] = (uint8_t)(e->fn << 5 | e->cls);
+    while (a >= 0x80) {
+        p[k++] = (uint8_t)(a | 0x80);
+        a >>= 7;
+    }
+    p[k++] = (uint8_t)a;
+    return k;
+}
+
+/* Decode the record at p (len bytes available); returns its length, 0 if truncated or malformed */
+SMC_INLINE size_t smc_trace_decode(const uint8_t *p, size_t len, smc_trace_entry *e) {
+    if (len < 2) return 0;
+    e->fn = p[0] >> 5;
+    e->cls = p[0] & 31;
+    e->arg = 0;
+    for (size_t k = 1; k < len && k < SMC_TRACE_RECORD_MAX; k++) {
+        e->arg |= (uint64_t)(p[k] & 0x7F) << (7 * (k - 1));
+        if (!(p[k] & 0x80)) return k + 1;
+    }
+    return 0;
+}
+
+/* Header for a trace sampled every 'rate' calls on average */
+SMC_INLINE void smc_trace_write_header(uint8_t *p, uint32_t rate) {
+    memcpy(p, SMC_TRACE_MAGIC, 8);
+    for (int k = 0; k < 4; k++) {
+        p[8 + k] = (uint8_t)(SMC_TRACE_VERSION >> (8 * k));
+        p[12 + k] = (uint8_t)(rate >> (8 * k));
+    }
+}
+
+/* Check a trace's header; its sampling rate into *rate */
+SMC_INLINE bool smc_trace_read_header(const uint8_t *p, size_t len, uint32_t *rate) {
+    if (len < SMC_TRACE_HEADER || memcmp(p, SMC_TRACE_MAGIC, 8) != 0) return false;
+    uint32_t version = 0;
+    *rate = 0;
+    for (int k = 0; k < 4; k++) {
+        version |= (uint32_t)p[8 + k] << (8 * k);
+        *rate |= (uint32_t)p[12 + k] << (8 * k);
+    }
+    return version == SMC_TRACE_VERSION;
+}
+
+/* ===========================================================================
+ * CAPTURE
+ * =========================================================================== */
+
+typedef struct smc_trace_state {
+    volatile uint64_t rate;     /* mean calls per sample, 0 while stopped */
+    volatile uint64_t lock;
+    FILE *file;
+    bool failed;
+    size_t used;
+    uint64_t records;
+    uint8_t buf[SMC_TRACE_BUFFER];
+} smc_trace_state;
+
+/* Per-thread countdown to the next sample, and nesting depth of traced calls */
+typedef struct smc_trace_local {
+    uint64_t skip;
+    uint64_t depth;
+    uint64_t rng;
+} smc_trace_local;
+
+/* Per translation unit unless SMC_SHARED_STATE (smcprime_sys.h) */
+SMC_STATE smc_trace_state smc_trace_global;
+SMC_STATE SMC_THREAD_LOCAL smc_trace_local smc_trace_tls;
+
+SMC_INLINE void smc_trace_lock(void) {
+    while (!smc_atomic_cas64(&smc_trace_global.lock, 0, 1)) smc_yield();
+}
+
+SMC_INLINE void smc_trace_unlock(void) {
+    smc_atomic_store64(&smc_trace_global.lock, 0);
+}
+
+/* Write out the buffered records (lock held) */
+SMC_API void smc_trace_flush_locked(void) {
+    smc_trace_state *g = &smc_trace_global;
+    if (g->file != NULL && g->used && fwrite(g->buf, 1, g->used, g->file) != g->used) g->failed = true;
+    g->used = 0;
+}
+
+/* Append one record to the running trace, if any */
+SMC_API void smc_trace_record(unsigned fn, uint64_t arg, uint64_t ns) {
+    smc_trace_entry e;
+    uint8_t rec[SMC_TRACE_RECORD_MAX];
+    e.fn = fn;
+    e.cls = smc_trace_class(ns);
+    e.arg = arg;
+    size_t len = smc_trace_encode(rec, &e);
+    smc_trace_state *g = &smc_trace_global;
+    smc_trace_lock();
+    if (g->file != NULL) {
+        if (g->used + len > SMC_TRACE_BUFFER) smc_trace_flush_locked();
+        memcpy(g->buf + g->used, rec, len);
+        g->used += len;
+        g->records++;
+    }
+    smc_trace_unlock();
+}
+
+/*
+ * Start capturing to path, sampling one call in 'rate' on average (1 =
+ * every call). Returns false if a trace is already running or the file
+ * cannot be created.
+ */
+SMC_API bool smc_trace_start(const char *path, uint32_t rate) {
+    smc_trace_state *g = &smc_trace_global;
+    if (rate == 0) return false;
+    smc_trace_lock();
+    bool ok = g->file == NULL && (g->file = fopen(path, "wb")) != NULL;
+    if (ok) {
+        uint8_t h[SMC_TRACE_HEADER];
+        smc_trace_write_header(h, rate);
+        g->failed = fwrite(h, 1, sizeof(h), g->file) != sizeof(h);
+        g->used = 0;
+        g->records = 0;
+        smc_atomic_store64(&g->rate, rate);
+    }
+    smc_trace_unlock();
+    return ok;
+}
+
+/*
+ * Stop capturing and close the file; records sampled afterwards are
+ * dropped. Returns the number of records written, or UINT64_MAX if none
+ * was running or a write failed.
+ */
+SMC_API uint64_t smc_trace_stop(void) {
+    smc_trace_state *g = &smc_trace_global;
+    smc_atomic_store64(&g->rate, 0);
+    smc_trace_lock();
+    uint64_t n = UINT64_MAX;
+    if (g->file != NULL) {
+        smc_trace_flush_locked();
+        if (fclose(g->file) != 0) g->failed = true;
+        g->file = NULL;
+        n = g->failed ? UINT64_MAX : g->records;
+    }
+    smc_trace_unlock();
+    return n;
+}
+
+/* Countdown ran out: draw the next gap (uniform in [1, 2 rate - 1]); true to sample this call */
+SMC_API bool smc_trace_rearm(smc_trace_local *t) {
+    uint64_t rate = smc_atomic_load64(&smc_trace_global.rate);
+    if (rate == 0) {
+        t->skip = SMC_TRACE_IDLE;
+        return false;
+    }
+    if (t->rng == 0) t->rng = smc_nanoseconds() ^ (uint64_t)(uintptr_t)t ^ 0x9E3779B97F4A7C15ULL;
+    t->rng ^= t->rng << 13;
+    t->rng ^= t->rng >> 7;
+    t->rng ^= t->rng << 17;
+    t->skip = 1 + t->rng % (2 * rate - 1);
+    return true;
+}
+
+/* Entering a traced call: true if this one is sampled */
+SMC_INLINE bool smc_trace_enter(void) {
+    smc_trace_local *t = &smc_trace_tls;
+    if (t->depth++ != 0) return false;
+    if (t->skip > 1) {
+        t->skip--;
+        return false;
+    }
+    return smc_trace_rearm(t);
+}
+
+/* Leaving a traced call; 'start' is its smc_nanoseconds() if it was sampled */
+SMC_INLINE void smc_trace_leave(bool sampled, unsigned fn, uint64_t arg, uint64_t start) {
+    if (sampled) smc_trace_record(fn, arg, smc_nanoseconds() - start);
+    smc_trace_tls.depth--;
+}
+
+/* ===========================================================================
+ * WRAPPERS
+ *
+ * The entry points with capture; SMC_TRACE maps the plain names to them
+ * for all code compiled after this header.
+ * =========================================================================== */
+
+#define SMC_TRACE_WRAP(ret, name, arg, id)                    \
+    SMC_INLINE ret smc_trace_##name(arg n) {                  \
+        bool sampled = smc_trace_enter();                     \
+        uint64_t start = sampled ? smc_nanoseconds() : 0;     \
+        ret r = (smc_##name)(n);                              \
+        smc_trace_leave(sampled, id, n, start);               \
+        return r;                                             \
+    }
+
+SMC_TRACE_WRAP(bool, is_prime32, uint32_t, SMC_TRACE_IS_PRIME32)
+SMC_TRACE_WRAP(bool, is_prime64, uint64_t, SMC_TRACE_IS_PRIME64)
+SMC_TRACE_WRAP(bool, is_prime64_wc, uint64_t, SMC_TRACE_IS_PRIME64_WC)
+SMC_TRACE_WRAP(uint32_t, next_prime32, uint32_t, SMC_TRACE_NEXT_PRIME32)
+SMC_TRACE_WRAP(uint32_t, prev_prime32, uint32_t, SMC_TRACE_PREV_PRIME32)
+SMC_TRACE_WRAP(uint64_t, next_prime64, uint64_t, SMC_TRACE_NEXT_PRIME64)
+SMC_TRACE_WRAP(uint64_t, prev_prime64, uint64_t, SMC_TRACE_PREV_PRIME64)
+
+SMC_INLINE int smc_trace_factor64(uint64_t n, uint64_t *f) {
+    bool sampled = smc_trace_enter();
+    uint64_t start = sampled ? smc_nanoseconds() : 0;
+    int r = (smc_factor64)(n, f);
+    smc_trace_leave(sampled, SMC_TRACE_FACTOR64, n, start);
+    return r;
+}
+
+/* With SMC_STATS as well, smcprime_stats.h maps the names and calls these */
+#if defined(SMC_TRACE) && !defined(SMC_STATS)
+  #define smc_is_prime32(n)    smc_trace_is_prime32(n)
+  #define smc_is_prime64(n)    smc_trace_is_prime64(n)
+  #define smc_is_prime64_wc(n) smc_trace_is_prime64_wc(n)
+  #define smc_next_prime32(n)  smc_trace_next_prime32(n)
+  #define smc_prev_prime32(n)  smc_trace_prev_prime32(n)
+  #define smc_next_prime64(n)  smc_trace_next_prime64(n)
+  #define smc_prev_prime64(n)  smc_trace_prev_prime64(n)
+  #define smc_factor64(n, f)   smc_trace_factor64(n, f)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SMCPRIME_TRACE_H */
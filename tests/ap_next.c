@@ -0,0 +1,69 @@
+/*
+ * smcPrime - Arithmetic-progression search checks
+ *
+ * smc_ap_next against a brute-force walk of the progression, including
+ * moduli large enough that its search window would overflow 64 bits:
+ *
+ *   cc -std=c99 -O2 -o ap_next tests/ap_next.c -pthread
+ *   ./ap_next
+ *
+ * Exits non-zero on failure.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#include "../smcprime_ap.h"
+#include <stdio.h>
+
+static uint64_t gcd(uint64_t a, uint64_t b) {
+    while (b) { uint64_t t = a % b; a = b; b = t; }
+    return a;
+}
+
+/* Smallest prime >= n that is a (mod q), walking the progression; 0 if none below 2^64 */
+static uint64_t brute_next(uint64_t a, uint64_t q, uint64_t n) {
+    uint64_t r = a % q, x = n - n % q;
+    if (n % q > r) {
+        if (UINT64_MAX - x < q) return 0;
+        x += q;
+    }
+    if (UINT64_MAX - x < r) return 0;
+    for (x += r;; x += q) {
+        if (smc_is_prime64(x)) return x;
+        if (gcd(x, q) > 1 || UINT64_MAX - x < q) return 0;
+    }
+}
+
+static int failures;
+
+static void check(uint64_t a, uint64_t q, uint64_t n, uint64_t want) {
+    uint64_t got = smc_ap_next(a, q, n);
+    if (got != want) {
+        printf("FAIL smc_ap_next(%llu, %llu, %llu) = %llu, want %llu\n", (unsigned long long)a,
+               (unsigned long long)q, (unsigned long long)n, (unsigned long long)got,
+               (unsigned long long)want);
+        failures++;
+    }
+}
+
+int main(void) {
+    /* Window span 64 q wraps for q >= 2^58 */
+    check(3, 1ULL << 59, 0, 3);
+    check(3, 1ULL << 59, 4, brute_next(3, 1ULL << 59, 4));
+    check(5, 1ULL << 58, 6, brute_next(5, 1ULL << 58, 6));
+    check(1, UINT64_MAX / 3, 2, brute_next(1, UINT64_MAX / 3, 2));
+    check(0, 1ULL << 60, 0, 0);
+
+    /* Small and mid-sized moduli against the brute-force walk */
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (int i = 0; i < 2000; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        uint64_t q = 1 + (x >> (i % 3 == 0 ? 40 : 54));
+        uint64_t a = (x >> 7) % q;
+        uint64_t n = i % 5 == 0 ? UINT64_MAX - (x >> 20) : (x >> (i % 7 + 20));
+        check(a, q, n, brute_next(a, q, n));
+    }
+    printf("%s\n", failures ? "FAIL" : "ok");
+    return failures != 0;
+}
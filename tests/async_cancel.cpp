@@ -0,0 +1,101 @@
+/*
+ * smcPrime - Async job cancellation check
+ *
+ * Cancels a prime count near 2^64 (where the job first builds ~203M
+ * sieving primes) and checks that it comes back empty, and quickly:
+ *
+ *   c++ -std=c++20 -O2 -o async_cancel tests/async_cancel.cpp -pthread
+ *   ./async_cancel
+ *
+ * Exits non-zero on failure.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#include "../smcprime_async.hpp"
+#include <chrono>
+#include <cstdio>
+#include <semaphore>
+#include <thread>
+
+/* Eagerly started coroutine whose result is read after 'done' is released */
+struct task {
+    struct promise_type {
+        task get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+static task count(uint64_t lo, uint64_t hi, smc::async_options opt,
+                  std::optional<uint64_t> &out, std::binary_semaphore &done) {
+    out = co_await smc::async_count_primes(lo, hi, std::move(opt));
+    done.release();
+}
+
+/* Time from the stop request to the job's completion, in ms; -1 if it was not cancelled */
+static double cancel_after(uint64_t lo, uint64_t hi, unsigned threads, int delay_ms) {
+    std::stop_source source;
+    std::optional<uint64_t> out;
+    std::binary_semaphore done{0};
+    smc::async_options opt;
+    opt.threads = threads;
+    opt.stop = source.get_token();
+    count(lo, hi, std::move(opt), out, done);
+    std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+    auto t = std::chrono::steady_clock::now();
+    source.request_stop();
+    done.acquire();
+    std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - t;
+    return out ? -1.0 : ms.count();
+}
+
+int main() {
+    const uint64_t hi = UINT64_MAX, lo = hi - ((uint64_t)1 << 40);
+    const double limit_ms = 250;
+    int failures = 0;
+
+    /* Stopped before it starts: no setup work at all */
+    {
+        std::stop_source source;
+        source.request_stop();
+        std::optional<uint64_t> out;
+        std::binary_semaphore done{0};
+        smc::async_options opt;
+        opt.stop = source.get_token();
+        auto t = std::chrono::steady_clock::now();
+        count(lo, hi, std::move(opt), out, done);
+        done.acquire();
+        std::chrono::duration<double, std::milli> ms = std::chrono::steady_clock::now() - t;
+        bool ok = !out && ms.count() < limit_ms;
+        std::printf("%-32s %8.1f ms %s\n", "stopped before start", ms.count(), ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+
+    /* Stopped while the sieving primes are being built */
+    for (unsigned threads : {1u, 4u}) {
+        for (int delay : {10, 200}) {
+            double ms = cancel_after(lo, hi, threads, delay);
+            bool ok = ms >= 0 && ms < limit_ms;
+            char name[64];
+            std::snprintf(name, sizeof(name), "threads %u, stop after %d ms", threads, delay);
+            std::printf("%-32s %8.1f ms %s\n", name, ms, ok ? "ok" : "FAIL");
+            failures += !ok;
+        }
+    }
+
+    /* An uncancelled job still counts correctly: pi(2^32) = 203280221 */
+    {
+        std::optional<uint64_t> out;
+        std::binary_semaphore done{0};
+        count(0, (uint64_t)1 << 32, smc::async_options{}, out, done);
+        done.acquire();
+        bool ok = out && *out == 203280221;
+        std::printf("%-32s %11s %s\n", "pi(2^32)", "", ok ? "ok" : "FAIL");
+        failures += !ok;
+    }
+    return failures != 0;
+}
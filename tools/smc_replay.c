@@ -0,0 +1,159 @@
+/*
+ * smcPrime - Trace replay
+ *
+ * Re-executes a call trace captured with smcprime_trace.h against the
+ * library as built with this tool, so a change can be judged on the
+ * recorded production inputs instead of uniform random ones:
+ * - Throughput: the whole trace in recorded order, best of -r passes
+ * - Per function: calls, mean replay time, and latency quantiles
+ *   (p50 / p90 / p99, as class upper bounds in ns) recorded versus
+ *   replayed, with every replayed call timed on its own by the same
+ *   clock the capture used
+ *
+ *   cc -O2 -march=native -o smc_replay tools/smc_replay.c -pthread
+ *   ./smc_replay [-r passes] [-c] trace.smct
+ *
+ * Build it once per library version or flag set and replay the same
+ * trace with each; -c adds the full class histograms.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#include "../smcprime_trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SMC_REPLAY_CLASSES 32
+
+static volatile uint64_t smc_replay_sink;
+
+/* One call of the traced function */
+static uint64_t smc_replay_call(const smc_trace_entry *e) {
+    uint64_t f[SMC_MAX_FACTORS64];
+    switch (e->fn) {
+        case SMC_TRACE_IS_PRIME32: return smc_is_prime32((uint32_t)e->arg);
+        case SMC_TRACE_IS_PRIME64: return smc_is_prime64(e->arg);
+        case SMC_TRACE_IS_PRIME64_WC: return smc_is_prime64_wc(e->arg);
+        case SMC_TRACE_NEXT_PRIME32: return smc_next_prime32((uint32_t)e->arg);
+        case SMC_TRACE_PREV_PRIME32: return smc_prev_prime32((uint32_t)e->arg);
+        case SMC_TRACE_NEXT_PRIME64: return smc_next_prime64(e->arg);
+        case SMC_TRACE_PREV_PRIME64: return smc_prev_prime64(e->arg);
+        default: return (uint64_t)smc_factor64(e->arg, f);
+    }
+}
+
+/* Upper bound in ns of the class holding quantile q of hist */
+static uint64_t smc_replay_quantile(const uint64_t *hist, uint64_t total, double q) {
+    uint64_t need = (uint64_t)(q * (double)total), sum = 0;
+    for (unsigned c = 0; c < SMC_REPLAY_CLASSES; c++) {
+        sum += hist[c];
+        if (sum > need || sum == total) return c ? 1ULL << c : 0;
+    }
+    return 1ULL << (SMC_REPLAY_CLASSES - 1);
+}
+
+int main(int argc, char **argv) {
+    int passes = 5;
+    bool classes = false;
+    const char *path = NULL;
+    bool usage = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) passes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "-c") == 0) classes = true;
+        else if (path == NULL && argv[i][0] != '-') path = argv[i];
+        else usage = true;
+    }
+    if (usage || path == NULL || passes < 1) {
+        fprintf(stderr, "usage: %s [-r passes] [-c] trace.smct\n", argv[0]);
+        return 2;
+    }
+
+    size_t len;
+    const uint8_t *p = (const uint8_t *)smc_map_file(path, &len);
+    uint32_t rate;
+    if (p == NULL || !smc_trace_read_header(p, len, &rate)) {
+        fprintf(stderr, "%s: not a readable trace\n", path);
+        return 1;
+    }
+    size_t n = 0, cap = 1 << 16;
+    smc_trace_entry *calls = (smc_trace_entry *)malloc(cap * sizeof(smc_trace_entry));
+    for (size_t pos = SMC_TRACE_HEADER; pos < len && calls != NULL;) {
+        size_t k = smc_trace_decode(p + pos, len - pos, &calls[n]);
+        if (k == 0) {
+            fprintf(stderr, "%s: truncated after %zu records\n", path, n);
+            break;
+        }
+        pos += k;
+        if (++n == cap) {
+            smc_trace_entry *t = (smc_trace_entry *)realloc(calls, 2 * cap * sizeof(smc_trace_entry));
+            if (t == NULL) free(calls);
+            calls = t;
+            cap *= 2;
+        }
+    }
+    smc_unmap_file(p, len);
+    if (calls == NULL) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    /* Throughput in recorded order */
+    double best = 0;
+    for (int r = 0; r < passes; r++) {
+        uint64_t acc = 0;
+        double t = smc_seconds();
+        for (size_t i = 0; i < n; i++) acc += smc_replay_call(&calls[i]);
+        t = smc_seconds() - t;
+        smc_replay_sink = acc;
+        if (r == 0 || t < best) best = t;
+    }
+
+    /* Latency of each call on its own */
+    static uint64_t rec[SMC_TRACE_FUNCTIONS][SMC_REPLAY_CLASSES], rep[SMC_TRACE_FUNCTIONS][SMC_REPLAY_CLASSES];
+    uint64_t count[SMC_TRACE_FUNCTIONS] = {0}, ns[SMC_TRACE_FUNCTIONS] = {0};
+    for (size_t i = 0; i < n; i++) {
+        const smc_trace_entry *e = &calls[i];
+        uint64_t t = smc_nanoseconds();
+        smc_replay_sink = smc_replay_call(e);
+        t = smc_nanoseconds() - t;
+        count[e->fn]++;
+        ns[e->fn] += t;
+        rec[e->fn][e->cls]++;
+        rep[e->fn][smc_trace_class(t)]++;
+    }
+
+    printf("%s: %zu calls, sampled 1 in %u (about %.3g calls)\n", path, n, rate, (double)n * rate);
+    printf("replay: %.3g calls/s, %.1f ns per call (best of %d)\n",
+           n && best > 0 ? (double)n / best : 0.0, n ? best * 1e9 / (double)n : 0.0, passes);
+    printf("\n%-18s %10s %9s %17s %17s %17s\n", "function", "calls", "mean ns",
+           "p50 rec/rep", "p90 rec/rep", "p99 rec/rep");
+    for (unsigned f = 0; f < SMC_TRACE_FUNCTIONS; f++) {
+        if (count[f] == 0) continue;
+        printf("%-18s %10llu %9.1f", smc_trace_names[f], (unsigned long long)count[f],
+               (double)ns[f] / (double)count[f]);
+        static const double qs[3] = {0.5, 0.9, 0.99};
+        for (int q = 0; q < 3; q++) {
+            char cell[32];
+            snprintf(cell, sizeof(cell), "%llu/%llu",
+                     (unsigned long long)smc_replay_quantile(rec[f], count[f], qs[q]),
+                     (unsigned long long)smc_replay_quantile(rep[f], count[f], qs[q]));
+            printf(" %17s", cell);
+        }
+        printf("\n");
+    }
+    if (classes) {
+        for (unsigned f = 0; f < SMC_TRACE_FUNCTIONS; f++) {
+            if (count[f] == 0) continue;
+            printf("\n%s\n%14s %10s %10s\n", smc_trace_names[f], "< ns", "recorded", "replayed");
+            for (unsigned c = 0; c < SMC_REPLAY_CLASSES; c++) {
+                if (rec[f][c] == 0 && rep[f][c] == 0) continue;
+                printf("%14llu %10llu %10llu\n", c ? 1ULL << c : 1ULL,
+                       (unsigned long long)rec[f][c], (unsigned long long)rep[f][c]);
+            }
+        }
+    }
+    free(calls);
+    return 0;
+}
@@ -0,0 +1,312 @@
+/*
+ * smcPrime - Offline threshold tuner
+ *
+ * Benchmarks the compile-time thresholds of smcprime.h and
+ * smcprime_factor.h on this host and writes them as a config header:
+ * - Trial-division depth of smc_is_prime64 below 2^55, and the matching
+ *   one-comparison limit
+ * - Trial-division depth above that limit
+ * - Crossover below which smc_is_prime64_wc defers to smc_is_prime64
+ *   (searched over the witness-set bounds)
+ * - Steps per gcd check in the lane-parallel rho (batch factorization)
+ *
+ * Every candidate is built into a probe (this file with SMC_TUNE_PROBE)
+ * by the same compiler and flags the library will be built with, so the
+ * timings include that compiler's unrolling and scheduling:
+ *
+ *   cc -O2 -o smc_tune tools/smc_tune.c
+ *   CC=gcc CFLAGS="-O2 -march=native" ./smc_tune -o smcprime_tuned.h
+ *   gcc -O2 -march=native -DSMC_CONFIG_HEADER='"smcprime_tuned.h"' ...
+ *
+ * Options: -o <header> (default smcprime_tuned.h), -s <path to this
+ * source> when run away from where it was compiled. CC and CFLAGS
+ * default to cc and -O2 -march=native; the compiler must accept
+ * gcc-style -D and -o.
+ *
+ * Copyright 2025 ScaleCode Solutions
+ * Released under MIT License
+ */
+
+#include "../smcprime.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Upper bounds of the witness sets in smc_is_prime64 */
+static const uint64_t smc_tune_bands_hi[] = {
+    2047ULL, 1373653ULL, 25326001ULL, 3215031751ULL, 2152302898747ULL,
+    3474749660383ULL, 341550071728321ULL, 3825123056546413051ULL, UINT64_MAX,
+};
+#define SMC_TUNE_BANDS (sizeof(smc_tune_bands_hi) / sizeof(smc_tune_bands_hi[0]))
+
+#ifdef SMC_TUNE_PROBE
+
+/* ===========================================================================
+ * PROBE: one kernel per run, timings (best of SMC_TUNE_REPS) on stdout
+ * =========================================================================== */
+
+#include "../smcprime_factor.h"
+
+#define SMC_TUNE_REPS 5
+#define SMC_TUNE_COUNT (1u << 18)
+
+static double smc_tune_now(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static uint64_t smc_tune_rng = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t smc_tune_rand(void) {
+    uint64_t x = smc_tune_rng;
+    x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+    return smc_tune_rng = x;
+}
+
+/* Random odd integer of exactly 'bits' bits */
+static uint64_t smc_tune_odd(unsigned bits) {
+    uint64_t top = 1ULL << (bits - 1);
+    return (top | (smc_tune_rand() & (top - 1))) | 1;
+}
+
+static volatile uint64_t smc_tune_sink;
+
+/* Mean ns per smc_is_prime64 call over n[0 .. count) */
+static double smc_tune_time_prime(const uint64_t *n, size_t count, bool wc) {
+    double best = 1e30;
+    for (int r = 0; r < SMC_TUNE_REPS; r++) {
+        uint64_t hits = 0;
+        double t0 = smc_tune_now();
+        if (wc) for (size_t i = 0; i < count; i++) hits += smc_is_prime64_wc(n[i]);
+        else for (size_t i = 0; i < count; i++) hits += smc_is_prime64(n[i]);
+        double t = smc_tune_now() - t0;
+        smc_tune_sink += hits;
+        if (t < best) best = t;
+    }
+    return best * 1e9 / (double)count;
+}
+
+/* Random odd integers, log-uniform over [lo_bits, hi_bits] bits */
+static double smc_tune_mixed(unsigned lo_bits, unsigned hi_bits) {
+    uint64_t *n = (uint64_t *)malloc(SMC_TUNE_COUNT * sizeof(uint64_t));
+    if (n == NULL) return -1;
+    for (size_t i = 0; i < SMC_TUNE_COUNT; i++)
+        n[i] = smc_tune_odd(lo_bits + (unsigned)(smc_tune_rand() % (hi_bits - lo_bits + 1)));
+    double t = smc_tune_time_prime(n, SMC_TUNE_COUNT, false);
+    free(n);
+    return t;
+}
+
+/* Per witness-set band: ns per prime for smc_is_prime64 and _wc */
+static int smc_tune_bands(void) {
+    const size_t count = 4096;
+    uint64_t *n = (uint64_t *)malloc(count * sizeof(uint64_t));
+    if (n == NULL) return 1;
+    uint64_t lo = 9;
+    for (size_t b = 0; b < SMC_TUNE_BANDS; b++) {
+        uint64_t hi = smc_tune_bands_hi[b];
+        for (size_t i = 0; i < count; i++) {
+            uint64_t p;
+            do { p = smc_next_prime64(lo + smc_tune_rand() % (hi - lo)); } while (p < lo || p >= hi);
+            n[i] = p;
+        }
+        printf("%.2f %.2f\n", smc_tune_time_prime(n, count, false), smc_tune_time_prime(n, count, true));
+        lo = hi;
+    }
+    free(n);
+    return 0;
+}
+
+/* ns per number for smc_factor_batch on semiprimes of 16..32-bit primes */
+static int smc_tune_rho(void) {
+    const size_t count = 4096;
+    uint64_t *n = (uint64_t *)malloc(count * sizeof(uint64_t));
+    if (n == NULL) return 1;
+    for (size_t i = 0; i < count; i++) {
+        uint64_t p = smc_next_prime64(smc_tune_odd(16 + (unsigned)(smc_tune_rand() % 17)));
+        uint64_t q = smc_next_prime64(smc_tune_odd(16 + (unsigned)(smc_tune_rand() % 17)));
+        n[i] = p * q;
+    }
+    double best = 1e30;
+    for (int r = 0; r < SMC_TUNE_REPS; r++) {
+        smc_factor_chunk ch;
+        double t0 = smc_tune_now();
+        if (!smc_factor_batch(n, count, &ch)) { free(n); return 1; }
+        double t = smc_tune_now() - t0;
+        smc_tune_sink += ch.offset[count];
+        smc_factor_chunk_free(&ch);
+        if (t < best) best = t;
+    }
+    printf("%.2f\n", best * 1e9 / (double)count);
+    free(n);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    const char *k = argc > 1 ? argv[1] : "";
+    if (strcmp(k, "small") == 0) { printf("%.2f\n", smc_tune_mixed(10, 55)); return 0; }
+    if (strcmp(k, "large") == 0) { printf("%.2f\n", smc_tune_mixed(56, 64)); return 0; }
+    if (strcmp(k, "bands") == 0) return smc_tune_bands();
+    if (strcmp(k, "rho") == 0) return smc_tune_rho();
+    return 2;
+}
+
+#else
+
+/* ===========================================================================
+ * DRIVER
+ * =========================================================================== */
+
+#if defined(_WIN32)
+  #define smc_tune_popen _popen
+  #define smc_tune_pclose _pclose
+  #define SMC_TUNE_PROBE_EXE "smc_tune_probe.exe"
+  #define SMC_TUNE_RUN ""
+#else
+  #define smc_tune_popen popen
+  #define smc_tune_pclose pclose
+  #define SMC_TUNE_PROBE_EXE "smc_tune_probe"
+  #define SMC_TUNE_RUN "./"
+#endif
+
+/* A candidate replaces the library default only if this much faster */
+#define SMC_TUNE_MARGIN 1.03
+
+typedef struct smc_tune_env {
+    const char *cc, *cflags, *source;
+} smc_tune_env;
+
+/* Build the probe with 'defs'; false if the compiler fails */
+static bool smc_tune_build(const smc_tune_env *env, const char *defs) {
+    char cmd[4096];
+    snprintf(cmd, sizeof(cmd), "%s %s -DSMC_TUNE_PROBE %s %s -o %s",
+             env->cc, env->cflags, defs, env->source, SMC_TUNE_PROBE_EXE);
+    return system(cmd) == 0;
+}
+
+/* Run one probe kernel; fills up to 'max' numbers, returns how many */
+static size_t smc_tune_run(const char *kernel, double *out, size_t max) {
+    char cmd[256];
+    snprintf(cmd, sizeof(cmd), SMC_TUNE_RUN "%s %s", SMC_TUNE_PROBE_EXE, kernel);
+    FILE *f = smc_tune_popen(cmd, "r");
+    if (f == NULL) return 0;
+    size_t n = 0;
+    while (n < max && fscanf(f, "%lf", &out[n]) == 1) n++;
+    smc_tune_pclose(f);
+    return n;
+}
+
+/* Build with 'defs' and return the kernel's single timing, or -1 */
+static double smc_tune_measure(const smc_tune_env *env, const char *defs, const char *kernel) {
+    double t;
+    if (!smc_tune_build(env, defs) || smc_tune_run(kernel, &t, 1) != 1) return -1;
+    fprintf(stderr, "  %-72s %8.2f ns\n", defs, t);
+    return t;
+}
+
+/* One-comparison trial-division limit for the first 'depth' primes */
+static uint64_t smc_tune_limit(unsigned depth) {
+    return UINT64_MAX / SMC_SMALL_PRIMES[depth - 1];
+}
+
+int main(int argc, char **argv) {
+    smc_tune_env env;
+    const char *out_path = "smcprime_tuned.h";
+    env.cc = getenv("CC") ? getenv("CC") : "cc";
+    env.cflags = getenv("CFLAGS") ? getenv("CFLAGS") : "-O2 -march=native";
+    env.source = __FILE__;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (strcmp(argv[i], "-o") == 0) out_path = argv[i + 1];
+        else if (strcmp(argv[i], "-s") == 0) env.source = argv[i + 1];
+        else { fprintf(stderr, "usage: %s [-o header] [-s smc_tune.c]\n", argv[0]); return 2; }
+    }
+    char defs[1024];
+    static const unsigned depths[] = { 8, 16, 24, 32, 40, 48, 56, SMC_NUM_PRIME_INV64 };
+    static const unsigned large[] = { 0, 3, 5, 8, 12, 16, 24 };
+    static const unsigned blocks[] = { 64, 128, 256, 512, 1024 };
+
+    /* 1. Depth below 2^55, each with its widest valid limit */
+    unsigned best_depth = SMC_NUM_PRIME_INV64;
+    double t_depth = 1e30, t_default = 0;
+    fprintf(stderr, "trial depth (random odd n, 10..55 bits):\n");
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        snprintf(defs, sizeof(defs), "-DSMC_TRIAL_PRIMES64=%u -DSMC_TRIAL_LIMIT64=%lluULL",
+                 depths[i], (unsigned long long)smc_tune_limit(depths[i]));
+        double t = smc_tune_measure(&env, defs, "small");
+        if (t < 0) { fprintf(stderr, "probe build failed: %s\n", defs); return 1; }
+        if (depths[i] == SMC_NUM_PRIME_INV64) t_default = t;
+        if (t < t_depth) { t_depth = t; best_depth = depths[i]; }
+    }
+    if (t_default <= t_depth * SMC_TUNE_MARGIN) { best_depth = SMC_NUM_PRIME_INV64; t_depth = t_default; }
+    uint64_t limit = smc_tune_limit(best_depth);
+
+    /* 2. Depth above the limit */
+    unsigned best_large = 5;
+    double t_large = 1e30, t_large_default = 0;
+    fprintf(stderr, "large trial depth (random odd n, 56..64 bits):\n");
+    for (size_t i = 0; i < sizeof(large) / sizeof(large[0]); i++) {
+        snprintf(defs, sizeof(defs), "-DSMC_TRIAL_PRIMES64=%u -DSMC_TRIAL_LIMIT64=%lluULL -DSMC_TRIAL_LARGE64=%u",
+                 best_depth, (unsigned long long)limit, large[i]);
+        double t = smc_tune_measure(&env, defs, "large");
+        if (t < 0) return 1;
+        if (large[i] == 5) t_large_default = t;
+        if (t < t_large) { t_large = t; best_large = large[i]; }
+    }
+    if (t_large_default <= t_large * SMC_TUNE_MARGIN) { best_large = 5; t_large = t_large_default; }
+
+    /* 3. Crossover: below the first band where _wc wins on primes, and every later band */
+    double band[2 * SMC_TUNE_BANDS];
+    snprintf(defs, sizeof(defs), "-DSMC_TRIAL_PRIMES64=%u -DSMC_TRIAL_LIMIT64=%lluULL -DSMC_TRIAL_LARGE64=%u",
+             best_depth, (unsigned long long)limit, best_large);
+    if (!smc_tune_build(&env, defs) || smc_tune_run("bands", band, 2 * SMC_TUNE_BANDS) != 2 * SMC_TUNE_BANDS)
+        return 1;
+    uint64_t crossover = UINT64_MAX;
+    fprintf(stderr, "primes per witness band (smc_is_prime64 / _wc):\n");
+    for (size_t b = 0; b < SMC_TUNE_BANDS; b++)
+        fprintf(stderr, "  below %20llu %8.2f %8.2f ns\n", (unsigned long long)smc_tune_bands_hi[b],
+                band[2 * b], band[2 * b + 1]);
+    for (size_t b = SMC_TUNE_BANDS; b-- > 0 && band[2 * b + 1] <= band[2 * b];)
+        crossover = b > 0 ? smc_tune_bands_hi[b - 1] : 0;
+
+    /* 4. Rho steps per gcd check */
+    unsigned best_block = 256;
+    double t_block = 1e30, t_block_default = 0;
+    fprintf(stderr, "rho block (batch of 16..32-bit semiprimes):\n");
+    for (size_t i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+        snprintf(defs, sizeof(defs), "-DSMC_RHO_BLOCK=%u", blocks[i]);
+        double t = smc_tune_measure(&env, defs, "rho");
+        if (t < 0) return 1;
+        if (blocks[i] == 256) t_block_default = t;
+        if (t < t_block) { t_block = t; best_block = blocks[i]; }
+    }
+    if (t_block_default <= t_block * SMC_TUNE_MARGIN) { best_block = 256; t_block = t_block_default; }
+    remove(SMC_TUNE_PROBE_EXE);
+
+    FILE *f = fopen(out_path, "w");
+    if (f == NULL) { perror(out_path); return 1; }
+    fprintf(f, "/*\n * smcPrime tuned thresholds, generated by tools/smc_tune.c; do not edit.\n"
+               " * Built with: %s %s\n */\n\n", env.cc, env.cflags);
+    fprintf(f, "#ifndef SMCPRIME_TUNED_H\n#define SMCPRIME_TUNED_H\n\n");
+    fprintf(f, "/* Random odd n below 2^55: %.2f ns per test (%u primes: %.2f ns) */\n",
+            t_depth, SMC_NUM_PRIME_INV64, t_default);
+    fprintf(f, "#ifndef SMC_TRIAL_PRIMES64\n  #define SMC_TRIAL_PRIMES64 %u\n#endif\n", best_depth);
+    fprintf(f, "#ifndef SMC_TRIAL_LIMIT64\n  #define SMC_TRIAL_LIMIT64 %lluULL\n#endif\n\n",
+            (unsigned long long)limit);
+    fprintf(f, "/* Random odd n of 56..64 bits: %.2f ns per test (5 primes: %.2f ns) */\n",
+            t_large, t_large_default);
+    fprintf(f, "#ifndef SMC_TRIAL_LARGE64\n  #define SMC_TRIAL_LARGE64 %u\n#endif\n\n", best_large);
+    fprintf(f, "/* smc_is_prime64 is faster on primes below this */\n");
+    fprintf(f, "#ifndef SMC_WC_CROSSOVER\n  #define SMC_WC_CROSSOVER %lluULL\n#endif\n\n",
+            (unsigned long long)crossover);
+    fprintf(f, "/* Semiprime batches: %.2f ns per number (256 steps: %.2f ns) */\n",
+            t_block, t_block_default);
+    fprintf(f, "#ifndef SMC_RHO_BLOCK\n  #define SMC_RHO_BLOCK %u\n#endif\n\n", best_block);
+    fprintf(f, "#endif /* SMCPRIME_TUNED_H */\n");
+    fclose(f);
+    fprintf(stderr, "wrote %s\n", out_path);
+    return 0;
+}
+
+#endif /* SMC_TUNE_PROBE */